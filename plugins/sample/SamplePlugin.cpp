@@ -0,0 +1,58 @@
+// Example sensor plugin: a simulated rack inlet probe and PDU temperature.
+// Build it with the main project and TempMonitor.exe picks it up from the
+// plugins folder next to the executable.
+#include "TempMonitorPlugin.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    struct SampleContext {
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void Describe(tm_sensor_desc& desc, uint32_t kind, const char* key, const char* label) {
+        desc.kind = kind;
+        desc.unit = TM_UNIT_CELSIUS;
+        strncpy(desc.key, key, sizeof(desc.key) - 1);
+        strncpy(desc.label, label, sizeof(desc.label) - 1);
+    }
+}
+
+extern "C" TM_PLUGIN_EXPORT int tm_plugin_open(uint32_t host_abi_version, tm_plugin_info* info, void** context) {
+    if (host_abi_version != TM_PLUGIN_ABI_VERSION) return -1;
+
+    memset(info, 0, sizeof(*info));
+    info->abi_version = TM_PLUGIN_ABI_VERSION;
+    // A probe behind a serial or USB link would give the host a short
+    // deadline, so a stuck link never holds up the built-in sensors
+    info->read_deadline_ms = 100;
+    info->sensor_count = 2;
+    Describe(info->sensors[0], TM_KIND_OTHER, "inlet", "Rack Inlet");
+    Describe(info->sensors[1], TM_KIND_OTHER, "pdu", "PDU");
+
+    SampleContext* ctx = new SampleContext();
+    ctx->start = std::chrono::steady_clock::now();
+    *context = ctx;
+    return 0;
+}
+
+extern "C" TM_PLUGIN_EXPORT int tm_plugin_read(void* context, float* values, uint8_t* valid, uint32_t count) {
+    SampleContext* ctx = (SampleContext*)context;
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctx->start).count();
+
+    // Slow sine waves standing in for real readings
+    if (count > 0) {
+        values[0] = (float)(24.0 + 3.0 * std::sin(t / 60.0));
+        valid[0] = 1;
+    }
+    if (count > 1) {
+        values[1] = (float)(35.0 + 5.0 * std::sin(t / 90.0));
+        valid[1] = 1;
+    }
+    return 0;
+}
+
+extern "C" TM_PLUGIN_EXPORT void tm_plugin_close(void* context) {
+    delete (SampleContext*)context;
+}
@@ -0,0 +1,519 @@
+#include "ActionDispatcher.h"
+#include "AlertEvaluator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+
+#pragma comment(lib, "winhttp.lib")
+#else
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+static const char* LevelName(TempLevel level) {
+    switch (level) {
+    case TempLevel::Danger: return "danger";
+    case TempLevel::Warning: return "warning";
+    default: return "normal";
+    }
+}
+
+ActionDispatcher::ActionDispatcher()
+    : stopping(false), cancelled(false), dropped(0), rateLimited(0), completed(0), failed(0) {
+    for (auto& level : lastLevels) {
+        level = TempLevel::Normal;
+    }
+#ifdef _WIN32
+    stopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+#endif
+}
+
+ActionDispatcher::~ActionDispatcher() {
+    Stop();
+#ifdef _WIN32
+    if (stopEvent) CloseHandle((HANDLE)stopEvent);
+#endif
+}
+
+bool ActionDispatcher::ParseRule(const std::wstring& line, ActionRule& rule) {
+    std::wstring fields[3];
+    size_t pos = 0;
+    for (int f = 0; f < 3; f++) {
+        size_t comma = line.find(L',', pos);
+        if (comma == std::wstring::npos) return false;
+        fields[f] = line.substr(pos, comma - pos);
+        pos = comma + 1;
+    }
+    if (pos >= line.size()) return false;
+
+    rule.level = (fields[0] == L"danger") ? TempLevel::Danger : TempLevel::Warning;
+    rule.sensor = std::string(fields[1].begin(), fields[1].end());
+    if (fields[2] == L"script") rule.type = ActionType::Script;
+    else if (fields[2] == L"log") rule.type = ActionType::Log;
+    else if (fields[2] == L"webhook") rule.type = ActionType::Webhook;
+    else return false;
+    rule.target = line.substr(pos);
+    rule.timeout = kDefaultTimeout;
+    rule.minInterval = kDefaultInterval;
+    return true;
+}
+
+#ifdef _WIN32
+bool ActionDispatcher::Start(const std::wstring& configPath) {
+    std::vector<ActionRule> loaded;
+
+    // Action<N>=<warning|danger>,<sensor key prefix|any>,<script|log|webhook>,<target>
+    int count = GetPrivateProfileIntW(L"Actions", L"Count", 0, configPath.c_str());
+    for (int i = 1; i <= count; i++) {
+        std::wstring key = L"Action" + std::to_wstring(i);
+        WCHAR buffer[1024];
+        GetPrivateProfileStringW(L"Actions", key.c_str(), L"", buffer, 1024, configPath.c_str());
+
+        ActionRule rule;
+        if (!ParseRule(buffer, rule)) continue;
+        rule.timeout = GetPrivateProfileIntW(L"Actions", (key + L"Timeout").c_str(), kDefaultTimeout, configPath.c_str());
+        rule.minInterval = GetPrivateProfileIntW(L"Actions", (key + L"Interval").c_str(), kDefaultInterval, configPath.c_str());
+        loaded.push_back(rule);
+    }
+    return Start(loaded);
+}
+#endif
+
+bool ActionDispatcher::Start(const std::vector<ActionRule>& configured) {
+    rules = configured;
+    states.assign(rules.size(), RuleState());
+    if (rules.empty()) return false;
+
+    stopping = false;
+    cancelled = false;
+#ifdef _WIN32
+    ResetEvent((HANDLE)stopEvent);
+    activeRequests.assign(kWorkerCount, nullptr);
+#endif
+    for (int i = 0; i < kWorkerCount; i++) {
+        workers.emplace_back(&ActionDispatcher::WorkerLoop, this, i);
+    }
+    return true;
+}
+
+void ActionDispatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        cancelled = true;
+        queue.clear();
+#ifdef _WIN32
+        // Closing a request handle aborts the synchronous call using it
+        for (auto& request : activeRequests) {
+            if (request) {
+                WinHttpCloseHandle((HINTERNET)request);
+                request = nullptr;
+            }
+        }
+#endif
+    }
+#ifdef _WIN32
+    SetEvent((HANDLE)stopEvent);
+#endif
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+unsigned long long ActionDispatcher::GetDroppedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
+
+unsigned long long ActionDispatcher::GetRateLimitedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rateLimited;
+}
+
+unsigned long long ActionDispatcher::GetCompletedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return completed;
+}
+
+unsigned long long ActionDispatcher::GetFailedCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failed;
+}
+
+void ActionDispatcher::OnSample(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+    int warningTemp, int dangerTemp) {
+    if (rules.empty()) return;
+
+    // A sensor that failed to read keeps its previous level
+    for (uint32_t i = 0; i < snapshot.count; i++) {
+        if (!snapshot.valid[i] || !SensorRegistry::IsTemperature(registry.Get(i))) continue;
+
+        TempLevel level = AlertEvaluator::CheckThreshold(snapshot.values[i], warningTemp, dangerTemp);
+        Trigger(registry.Get(i).key, level, lastLevels[i], snapshot.values[i]);
+        lastLevels[i] = level;
+    }
+}
+
+void ActionDispatcher::Trigger(const std::string& sensor, TempLevel level, TempLevel previous, float temp) {
+    if (level <= previous) return;
+
+    int64_t now = SteadyNow();
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < rules.size(); i++) {
+            const ActionRule& rule = rules[i];
+            if (rule.sensor != "any" && sensor.compare(0, rule.sensor.size(), rule.sensor) != 0) continue;
+            // Only the upward crossing into the rule's level counts
+            if (level < rule.level || previous >= rule.level) continue;
+
+            RuleState& state = states[i];
+            if (state.pending) continue;
+            if (state.lastRun != 0 && now - state.lastRun < (int64_t)rule.minInterval) {
+                rateLimited++;
+                continue;
+            }
+            if (queue.size() >= kQueueCapacity) {
+                dropped++;
+                continue;
+            }
+
+            state.pending = true;
+            state.lastRun = now;
+            queue.push_back({ i, sensor, level, temp });
+            queued = true;
+        }
+    }
+    if (queued) {
+        wake.notify_all();
+    }
+}
+
+void ActionDispatcher::WorkerLoop(int worker) {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            job = queue.front();
+            queue.pop_front();
+        }
+
+        bool ok = Execute(worker, rules[job.rule], job);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        states[job.rule].pending = false;
+        completed++;
+        if (!ok) failed++;
+    }
+}
+
+bool ActionDispatcher::Execute(int worker, const ActionRule& rule, const Job& job) {
+    switch (rule.type) {
+    case ActionType::Script:
+        return RunScript(rule, job);
+    case ActionType::Log:
+        return AppendLog(rule, job);
+    case ActionType::Webhook:
+        return PostWebhook(worker, rule, job);
+    }
+    return false;
+}
+
+#ifdef _WIN32
+
+bool ActionDispatcher::RunScript(const ActionRule& rule, const Job& job) {
+    WCHAR args[64];
+    swprintf_s(args, L" %hs %hs %.1f", job.sensor.c_str(), LevelName(job.level), job.temp);
+    std::wstring cmdLine = L"cmd.exe /c \"\"" + rule.target + L"\"" + args + L"\"";
+
+    // Everything the script starts runs in one job, so a timeout ends the
+    // whole tree and not just cmd.exe. Closing the job ends whatever the
+    // script left running.
+    HANDLE processJob = CreateJobObjectW(NULL, NULL);
+    if (!processJob) return false;
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {};
+    limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    SetInformationJobObject(processJob, JobObjectExtendedLimitInformation, &limits, sizeof(limits));
+
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessW(NULL, &cmdLine[0], NULL, NULL, FALSE, CREATE_NO_WINDOW | CREATE_SUSPENDED,
+        NULL, NULL, &si, &pi)) {
+        CloseHandle(processJob);
+        return false;
+    }
+    if (!AssignProcessToJobObject(processJob, pi.hProcess)) {
+        TerminateProcess(pi.hProcess, 1);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+        CloseHandle(processJob);
+        return false;
+    }
+    ResumeThread(pi.hThread);
+
+    HANDLE waits[2] = { pi.hProcess, (HANDLE)stopEvent };
+    bool finished = WaitForMultipleObjects(2, waits, FALSE, rule.timeout) == WAIT_OBJECT_0;
+    DWORD exitCode = 1;
+    if (finished) {
+        GetExitCodeProcess(pi.hProcess, &exitCode);
+    } else {
+        TerminateJobObject(processJob, 1);
+    }
+
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    CloseHandle(processJob);
+    return finished && exitCode == 0;
+}
+
+bool ActionDispatcher::AppendLog(const ActionRule& rule, const Job& job) {
+    HANDLE file = CreateFileW(rule.target.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    char line[128];
+    int length = sprintf_s(line, "%04d-%02d-%02d %02d:%02d:%02d %s %s %.1f\r\n",
+        st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond,
+        job.sensor.c_str(), LevelName(job.level), job.temp);
+
+    DWORD written = 0;
+    bool ok = length > 0 && WriteFile(file, line, (DWORD)length, &written, NULL);
+    CloseHandle(file);
+    return ok;
+}
+
+bool ActionDispatcher::PostWebhook(int worker, const ActionRule& rule, const Job& job) {
+    URL_COMPONENTS url = {};
+    url.dwStructSize = sizeof(url);
+    WCHAR host[256];
+    WCHAR path[1024];
+    url.lpszHostName = host;
+    url.dwHostNameLength = ARRAYSIZE(host);
+    url.lpszUrlPath = path;
+    url.dwUrlPathLength = ARRAYSIZE(path);
+    if (!WinHttpCrackUrl(rule.target.c_str(), 0, 0, &url)) return false;
+
+    char body[128];
+    int length = sprintf_s(body, "{\"sensor\":\"%s\",\"level\":\"%s\",\"temp\":%.1f}",
+        job.sensor.c_str(), LevelName(job.level), job.temp);
+
+    bool ok = false;
+    HINTERNET session = WinHttpOpen(L"TempMonitor", WINHTTP_ACCESS_TYPE_NO_PROXY,
+        WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!session) return false;
+
+    // The timeouts apply per phase; a quarter each keeps the whole request
+    // within the rule's timeout
+    int phase = std::max(1, (int)rule.timeout / 4);
+    WinHttpSetTimeouts(session, phase, phase, phase, phase);
+
+    HINTERNET connection = WinHttpConnect(session, host, url.nPort, 0);
+    if (connection) {
+        DWORD flags = (url.nScheme == INTERNET_SCHEME_HTTPS) ? WINHTTP_FLAG_SECURE : 0;
+        HINTERNET request = WinHttpOpenRequest(connection, L"POST", path, NULL,
+            WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, flags);
+        if (request) {
+            // Registered so Stop can abort it; whoever clears the slot closes the handle
+            bool registered;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                registered = !cancelled;
+                if (registered) activeRequests[worker] = request;
+            }
+
+            const wchar_t* headers = L"Content-Type: application/json\r\n";
+            if (registered &&
+                WinHttpSendRequest(request, headers, (DWORD)-1L, body, (DWORD)length, (DWORD)length, 0) &&
+                WinHttpReceiveResponse(request, NULL)) {
+                DWORD status = 0;
+                DWORD size = sizeof(status);
+                ok = WinHttpQueryHeaders(request, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                    WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX) &&
+                    status >= 200 && status < 300;
+            }
+
+            bool owned;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                owned = !registered || activeRequests[worker] == request;
+                activeRequests[worker] = nullptr;
+            }
+            if (owned) WinHttpCloseHandle(request);
+        }
+        WinHttpCloseHandle(connection);
+    }
+    WinHttpCloseHandle(session);
+    return ok;
+}
+
+#else
+
+namespace {
+    typedef std::chrono::steady_clock::time_point Deadline;
+
+    Deadline DeadlineAfter(uint32_t ms) {
+        return std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    }
+
+    // Waits for the socket in short slices so Stop is noticed
+    bool WaitSocket(int fd, short events, Deadline deadline, const std::atomic<bool>& cancelled) {
+        for (;;) {
+            if (cancelled) return false;
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) return false;
+
+            pollfd p = { fd, events, 0 };
+            int result = poll(&p, 1, (int)std::min<long long>(left, ActionDispatcher::kCancelPoll));
+            if (result > 0) return true;
+            if (result < 0 && errno != EINTR) return false;
+        }
+    }
+}
+
+bool ActionDispatcher::RunScript(const ActionRule& rule, const Job& job) {
+    char args[64];
+    snprintf(args, sizeof(args), " %s %s %.1f", job.sensor.c_str(), LevelName(job.level), job.temp);
+    std::string command = "\"" + std::string(rule.target.begin(), rule.target.end()) + "\"" + args;
+
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        // Its own process group stands in for the Windows job object
+        setpgid(0, 0);
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    setpgid(pid, pid);
+
+    Deadline deadline = DeadlineAfter(rule.timeout);
+    int status = 0;
+    bool finished = false;
+    for (;;) {
+        pid_t result = waitpid(pid, &status, WNOHANG);
+        if (result == pid) {
+            finished = true;
+            break;
+        }
+        if (result < 0 || cancelled || std::chrono::steady_clock::now() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(kCancelPoll));
+    }
+
+    // Ends the script on a timeout and anything it left running either way
+    kill(-pid, SIGKILL);
+    if (!finished) waitpid(pid, &status, 0);
+    return finished && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+bool ActionDispatcher::AppendLog(const ActionRule& rule, const Job& job) {
+    FILE* file = fopen(std::string(rule.target.begin(), rule.target.end()).c_str(), "ab");
+    if (!file) return false;
+
+    time_t now = time(nullptr);
+    tm local;
+    localtime_r(&now, &local);
+    int length = fprintf(file, "%04d-%02d-%02d %02d:%02d:%02d %s %s %.1f\r\n",
+        local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec,
+        job.sensor.c_str(), LevelName(job.level), job.temp);
+    return fclose(file) == 0 && length > 0;
+}
+
+// Plain http:// only; TLS needs WinHTTP
+bool ActionDispatcher::PostWebhook(int, const ActionRule& rule, const Job& job) {
+    const std::string scheme = "http://";
+    std::string url(rule.target.begin(), rule.target.end());
+    if (url.compare(0, scheme.size(), scheme) != 0) return false;
+
+    size_t pathStart = url.find('/', scheme.size());
+    std::string host = url.substr(scheme.size(), pathStart - scheme.size());
+    std::string path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+    std::string port = "80";
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+        port = host.substr(colon + 1);
+        host = host.substr(0, colon);
+    }
+
+    Deadline deadline = DeadlineAfter(rule.timeout);
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) return false;
+
+    int fd = socket(addresses->ai_family, addresses->ai_socktype, addresses->ai_protocol);
+    bool connected = false;
+    if (fd >= 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        if (connect(fd, addresses->ai_addr, addresses->ai_addrlen) == 0) {
+            connected = true;
+        } else if (errno == EINPROGRESS && WaitSocket(fd, POLLOUT, deadline, cancelled)) {
+            int error = 0;
+            socklen_t size = sizeof(error);
+            connected = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0 && error == 0;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (!connected) {
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    char body[128];
+    int length = snprintf(body, sizeof(body), "{\"sensor\":\"%s\",\"level\":\"%s\",\"temp\":%.1f}",
+        job.sensor.c_str(), LevelName(job.level), job.temp);
+    std::string request = "POST " + path + " HTTP/1.1\r\nHost: " + host +
+        "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(length) +
+        "\r\nConnection: close\r\n\r\n" + body;
+
+    bool ok = true;
+    for (size_t sent = 0; ok && sent < request.size();) {
+        ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ok = WaitSocket(fd, POLLOUT, deadline, cancelled);
+        } else {
+            ok = false;
+        }
+    }
+
+    // Only the status line matters
+    std::string response;
+    while (ok && response.find("\r\n") == std::string::npos) {
+        char buffer[256];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            response.append(buffer, (size_t)n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            ok = WaitSocket(fd, POLLIN, deadline, cancelled);
+        } else {
+            ok = false;
+        }
+    }
+    close(fd);
+
+    int status = 0;
+    return ok && sscanf(response.c_str(), "HTTP/%*d.%*d %d", &status) == 1 && status >= 200 && status < 300;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Sensor.h"
+
+enum class ActionType {
+    Script,    // runs "cmd.exe /c <target> <sensor> <level> <temp>" (/bin/sh -c elsewhere)
+    Log,       // appends a line to the file <target>
+    Webhook    // POSTs a JSON body to the http:// URL <target>
+};
+
+// One configured action. Fires when a matching sensor rises to the given
+// level or above. "cpu" matches cpu, cpu1, cpu2...; "any" matches all.
+struct ActionRule {
+    TempLevel level;
+    std::string sensor;
+    ActionType type;
+    std::wstring target;
+    uint32_t timeout;       // ms the whole action may take before it is abandoned
+    uint32_t minInterval;   // ms between two runs of this rule
+};
+
+// Runs alert actions on background threads so slow scripts or unreachable
+// endpoints never hold up sampling or the UI.
+class ActionDispatcher {
+public:
+    ActionDispatcher();
+    ~ActionDispatcher();
+
+#ifdef _WIN32
+    // Reads [Actions] from config.ini and starts the workers
+    bool Start(const std::wstring& configPath);
+#endif
+    bool Start(const std::vector<ActionRule>& rules);
+
+    // Cancels running actions, so it returns within about kCancelPoll
+    void Stop();
+
+    // Parses "<warning|danger>,<sensor key prefix|any>,<script|log|webhook>,<target>";
+    // timeout and interval get their defaults
+    static bool ParseRule(const std::wstring& line, ActionRule& rule);
+
+    // Called once per tick; queues actions for rules whose sensor crossed
+    // upwards into the rule's level since the previous tick
+    void OnSample(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+        int warningTemp, int dangerTemp);
+
+    size_t GetRuleCount() const { return rules.size(); }
+    unsigned long long GetDroppedCount();
+    unsigned long long GetRateLimitedCount();
+    unsigned long long GetCompletedCount();   // actions that ran, failed or not
+    unsigned long long GetFailedCount();      // failed, timed out or cancelled
+
+    static const size_t kQueueCapacity = 32;
+    static const int kWorkerCount = 2;
+    static const uint32_t kDefaultTimeout = 10000;    // ms
+    static const uint32_t kDefaultInterval = 60000;   // ms
+    static constexpr int kCancelPoll = 20;            // ms between checks for Stop
+
+private:
+    struct Job {
+        size_t rule;
+        std::string sensor;
+        TempLevel level;
+        float temp;
+    };
+
+    struct RuleState {
+        int64_t lastRun;
+        bool pending;   // queued or running; further triggers are duplicates
+    };
+
+    std::vector<ActionRule> rules;
+    std::vector<RuleState> states;
+    TempLevel lastLevels[kMaxSensors];
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+    bool stopping;
+    std::atomic<bool> cancelled;   // read by running actions without the lock
+    unsigned long long dropped;
+    unsigned long long rateLimited;
+    unsigned long long completed;
+    unsigned long long failed;
+
+#ifdef _WIN32
+    void* stopEvent;                     // manual reset, set by Stop
+    std::vector<void*> activeRequests;   // per worker; whoever clears a slot closes it
+#endif
+
+    void Trigger(const std::string& sensor, TempLevel level, TempLevel previous, float temp);
+    void WorkerLoop(int worker);
+    bool Execute(int worker, const ActionRule& rule, const Job& job);
+    bool RunScript(const ActionRule& rule, const Job& job);
+    bool AppendLog(const ActionRule& rule, const Job& job);
+    bool PostWebhook(int worker, const ActionRule& rule, const Job& job);
+};
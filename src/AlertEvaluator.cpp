@@ -0,0 +1,60 @@
+#include "AlertEvaluator.h"
+#include "Trace.h"
+
+AlertEvaluator::AlertEvaluator() {
+    Reset();
+}
+
+void AlertEvaluator::Reset() {
+    windowShown = false;
+    lastMaxTemp = 0.0f;
+    lastLevel = TempLevel::Normal;
+}
+
+TempLevel AlertEvaluator::CheckThreshold(float temp, int warningTemp, int dangerTemp) {
+    if (temp >= dangerTemp) {
+        return TempLevel::Danger;
+    } else if (temp >= warningTemp) {
+        return TempLevel::Warning;
+    }
+    return TempLevel::Normal;
+}
+
+AlertDecision AlertEvaluator::Evaluate(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+    int warningTemp, int dangerTemp) {
+    TRACE_SCOPE("evaluate");
+    AlertDecision decision = {};
+    decision.previousLevel = lastLevel;
+    decision.level = lastLevel;
+    decision.hottestSensor = HottestSensor(snapshot, registry);
+    decision.action = AlertAction::None;
+
+    if (decision.hottestSensor < 0) return decision;
+
+    // The hottest sensor decides the level for the whole machine
+    float maxTemp = snapshot.values[decision.hottestSensor];
+    decision.level = CheckThreshold(maxTemp, warningTemp, dangerTemp);
+    decision.maxTemp = maxTemp;
+    lastLevel = decision.level;
+
+    // Show/hide floating window based on threshold
+    if (maxTemp >= warningTemp) {
+        if (!windowShown) {
+            decision.action = AlertAction::Show;
+            windowShown = true;
+            lastMaxTemp = maxTemp;
+        }
+        decision.updateWindow = true;
+        if (maxTemp > lastMaxTemp) {
+            lastMaxTemp = maxTemp;
+        }
+    } else if (windowShown && maxTemp < (warningTemp - kHideHysteresis)) {
+        decision.action = AlertAction::Hide;
+        windowShown = false;
+        lastMaxTemp = 0.0f;
+    } else if (windowShown) {
+        decision.updateWindow = true;
+    }
+
+    return decision;
+}
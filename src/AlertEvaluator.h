@@ -0,0 +1,41 @@
+#pragma once
+#include "Sensor.h"
+
+enum class AlertAction {
+    None,
+    Show,
+    Hide
+};
+
+struct AlertDecision {
+    TempLevel level;
+    TempLevel previousLevel;
+    float maxTemp;
+    int hottestSensor;   // -1 when no temperature sensor was valid
+    AlertAction action;
+    bool updateWindow;   // floating window is visible and should repaint
+};
+
+// Threshold and hysteresis logic behind the floating window. Kept free of
+// UI calls so it can be driven by recorded or synthetic traces.
+class AlertEvaluator {
+public:
+    AlertEvaluator();
+
+    AlertDecision Evaluate(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+        int warningTemp, int dangerTemp);
+    void Reset();
+
+    bool IsWindowShown() const { return windowShown; }
+    float GetLastMaxTemp() const { return lastMaxTemp; }
+
+    static TempLevel CheckThreshold(float temp, int warningTemp, int dangerTemp);
+
+    // The window hides once the hottest sensor drops this far below warning
+    static constexpr float kHideHysteresis = 5.0f;
+
+private:
+    bool windowShown;
+    float lastMaxTemp;
+    TempLevel lastLevel;
+};
@@ -0,0 +1,253 @@
+#include "BaselineModel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const uint32_t kBaselineMagic = 0x4D424D54;   // "TMBM"
+    const uint32_t kBaselineVersion = 1;
+
+    const double kInitialCovariance = 1000.0;
+    // Past this the fit has seen too little variation to forget more
+    const double kMaxCovarianceTrace = 1e5;
+    const double kNoiseForgetting = 0.999;        // per kForgettingStep
+
+#pragma pack(push, 1)
+    struct BaselineHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t inputCount;
+        uint32_t modelCount;
+    };
+
+    struct StoredModel {
+        char key[16];
+        uint32_t samples;
+        double weights[BaselineModel::kTerms];
+        double covariance[BaselineModel::kTerms][BaselineModel::kTerms];
+        double noiseVariance;
+    };
+#pragma pack(pop)
+
+    bool IsInput(const SensorInfo& info) {
+        return info.kind == SensorKind::Load ||
+            (info.kind == SensorKind::Fan && info.unit == SensorUnit::Percent);
+    }
+}
+
+BaselineModel::BaselineModel(const SensorRegistry& r)
+    : registry(r), smoothed(), primed(false), lastTime(0), models(r.Count()) {
+    for (size_t i = 0; i < registry.Count() && inputs.size() < kMaxInputs; i++) {
+        if (IsInput(registry.Get(i))) inputs.push_back((int)i);
+    }
+    for (size_t i = 0; i < models.size(); i++) {
+        Reset(models[i]);
+        models[i].active = SensorRegistry::IsTemperature(registry.Get(i));
+    }
+}
+
+void BaselineModel::Reset(SensorModel& model) const {
+    model.degraded = false;
+    model.samples = 0;
+    memset(model.weights, 0, sizeof(model.weights));
+    memset(model.covariance, 0, sizeof(model.covariance));
+    for (size_t i = 0; i < kTerms; i++) {
+        model.covariance[i][i] = kInitialCovariance;
+    }
+    model.noiseVariance = 0.0;
+    model.excess = 0.0;
+    model.expected = NAN;
+    model.aboveSince = -1;
+    model.degradedSince = -1;
+}
+
+float BaselineModel::GetExcess(size_t sensor) const {
+    return sensor < models.size() ? (float)models[sensor].excess : 0.0f;
+}
+
+float BaselineModel::GetExpected(size_t sensor) const {
+    return sensor < models.size() ? (float)models[sensor].expected : NAN;
+}
+
+bool BaselineModel::Update(const SensorSnapshot& snapshot) {
+    if (inputs.empty()) return false;
+
+    int64_t now = snapshot.time;
+    double dt = primed ? (double)(now - lastTime) : 0.0;
+    if (dt < 0) dt = 0;
+    lastTime = now;
+
+    // A missing input keeps its last smoothed value
+    double inputAlpha = 1.0 - std::exp(-dt / kInputTau);
+    for (size_t k = 0; k < inputs.size(); k++) {
+        int id = inputs[k];
+        if (id >= (int)snapshot.count || !snapshot.valid[id]) continue;
+        double value = snapshot.values[id] / 100.0;
+        smoothed[k] = primed ? smoothed[k] + inputAlpha * (value - smoothed[k]) : value;
+    }
+    primed = true;
+
+    double x[kTerms] = { 1.0 };
+    for (size_t k = 0; k < inputs.size(); k++) {
+        x[k + 1] = smoothed[k];
+    }
+
+    bool changed = false;
+    for (uint32_t i = 0; i < snapshot.count && i < models.size(); i++) {
+        SensorModel& model = models[i];
+        if (!model.active || !snapshot.valid[i] || snapshot.stale[i]) continue;
+        changed = UpdateSensor(model, x, snapshot.values[i], dt, now) || changed;
+    }
+    return changed;
+}
+
+bool BaselineModel::UpdateSensor(SensorModel& model, const double* x, double temp, double dt, int64_t now) {
+    if (model.samples == 0) {
+        model.weights[0] = temp;
+    }
+
+    double prediction = 0.0;
+    for (size_t i = 0; i < kTerms; i++) {
+        prediction += model.weights[i] * x[i];
+    }
+    model.expected = prediction;
+    double error = temp - prediction;
+
+    double residualAlpha = model.samples == 0 ? 1.0 : 1.0 - std::exp(-dt / kResidualTau);
+    model.excess += residualAlpha * (error - model.excess);
+
+    double limit = std::max((double)kMinExcess, kSigmas * std::sqrt(model.noiseVariance));
+    bool above = model.samples >= kWarmup && model.excess > limit;
+    bool wasDegraded = model.degraded;
+
+    if (above) {
+        if (model.aboveSince < 0) model.aboveSince = now;
+        if (!model.degraded && now - model.aboveSince >= kSustain) {
+            model.degraded = true;
+            model.degradedSince = now;
+        }
+    } else {
+        model.aboveSince = -1;
+    }
+    if (model.degraded && model.excess < kMinExcess / 2) {
+        model.degraded = false;
+        model.degradedSince = -1;
+    }
+
+    // Learning stops while the residual is high, or the fit would simply
+    // absorb the fault; a shift that lasts long enough is the new normal
+    bool relearn = model.degraded && now - model.degradedSince >= kRelearnAfter;
+    if (model.aboveSince < 0 || relearn) {
+        double steps = dt / kForgettingStep;
+        Learn(model, x, error, std::pow(kForgetting, steps));
+        if (!model.degraded) {
+            double noiseAlpha = 1.0 - std::pow(kNoiseForgetting, steps);
+            model.noiseVariance += noiseAlpha * (model.excess * model.excess - model.noiseVariance);
+        }
+    }
+    model.samples++;
+    return model.degraded != wasDegraded;
+}
+
+void BaselineModel::Learn(SensorModel& model, const double* x, double error, double forgetting) const {
+    const size_t n = inputs.size() + 1;
+
+    double px[kTerms] = {};
+    double xpx = 0.0;
+    double trace = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            px[i] += model.covariance[i][j] * x[j];
+        }
+        xpx += x[i] * px[i];
+        trace += model.covariance[i][i];
+    }
+
+    double lambda = trace < kMaxCovarianceTrace ? forgetting : 1.0;
+    double denominator = lambda + xpx;
+    for (size_t i = 0; i < n; i++) {
+        model.weights[i] += px[i] / denominator * error;
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            model.covariance[i][j] = (model.covariance[i][j] - px[i] * px[j] / denominator) / lambda;
+        }
+    }
+}
+
+bool BaselineModel::Save(const std::wstring& path) const {
+    if (inputs.empty()) return false;
+
+    // Written aside and renamed over the old file, so a crash mid-save keeps the last one
+    fs::path target(path);
+    fs::path temp = target;
+    temp += L".tmp";
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    BaselineHeader header = { kBaselineMagic, kBaselineVersion, (uint32_t)inputs.size(), 0 };
+    for (const auto& model : models) {
+        if (model.active) header.modelCount++;
+    }
+    out.write((const char*)&header, sizeof(header));
+
+    for (int input : inputs) {
+        out.write(registry.Get(input).key, sizeof(SensorInfo::key));
+    }
+    for (size_t i = 0; i < models.size(); i++) {
+        const SensorModel& model = models[i];
+        if (!model.active) continue;
+
+        StoredModel stored = {};
+        memcpy(stored.key, registry.Get(i).key, sizeof(stored.key));
+        stored.samples = model.samples;
+        memcpy(stored.weights, model.weights, sizeof(stored.weights));
+        memcpy(stored.covariance, model.covariance, sizeof(stored.covariance));
+        stored.noiseVariance = model.noiseVariance;
+        out.write((const char*)&stored, sizeof(stored));
+    }
+    out.close();
+    if (!out) return false;
+
+    std::error_code ec;
+    fs::rename(temp, target, ec);
+    return !ec;
+}
+
+bool BaselineModel::Load(const std::wstring& path) {
+    std::ifstream in(fs::path(path), std::ios::binary);
+    BaselineHeader header;
+    if (!in.read((char*)&header, sizeof(header))) return false;
+    if (header.magic != kBaselineMagic || header.version != kBaselineVersion ||
+        header.inputCount != inputs.size() || header.modelCount > kMaxSensors) {
+        return false;
+    }
+
+    for (int input : inputs) {
+        char key[sizeof(SensorInfo::key)];
+        if (!in.read(key, sizeof(key)) || strncmp(key, registry.Get(input).key, sizeof(key)) != 0) {
+            return false;
+        }
+    }
+
+    for (uint32_t m = 0; m < header.modelCount; m++) {
+        StoredModel stored;
+        if (!in.read((char*)&stored, sizeof(stored))) return false;
+        stored.key[sizeof(stored.key) - 1] = '\0';
+
+        int id = registry.Find(stored.key);
+        if (id < 0 || !models[id].active) continue;
+
+        SensorModel& model = models[id];
+        Reset(model);
+        model.samples = stored.samples;
+        memcpy(model.weights, stored.weights, sizeof(model.weights));
+        memcpy(model.covariance, stored.covariance, sizeof(model.covariance));
+        model.noiseVariance = stored.noiseVariance;
+    }
+    return true;
+}
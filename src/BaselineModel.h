@@ -0,0 +1,73 @@
+#pragma once
+#include "Sensor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Learns, per temperature sensor, what it normally reads for the current
+// load: recursive least squares of temperature against smoothed CPU/GPU
+// load and fan speed, with slow forgetting. Each update is O(1) with fixed
+// state per sensor. A residual that stays well above the fit (say 80°C
+// where the load predicts 65°C) means the cooling got worse; that shows
+// long before the absolute thresholds trip.
+class BaselineModel {
+public:
+    // Inputs are the Load sensors and percent-unit fans, up to kMaxInputs
+    explicit BaselineModel(const SensorRegistry& registry);
+
+    // Without load inputs the fit would flag every busy period
+    bool IsActive() const { return !inputs.empty(); }
+
+    // Folds in one snapshot; true when any sensor became degraded or recovered
+    bool Update(const SensorSnapshot& snapshot);
+
+    bool IsDegraded(size_t sensor) const { return sensor < models.size() && models[sensor].degraded; }
+    float GetExcess(size_t sensor) const;   // smoothed C above the fit
+    float GetExpected(size_t sensor) const; // fitted temperature for the current load
+
+    // Learned fits are kept across runs; a file from another sensor layout is
+    // ignored. Save replaces the file in one step, so it is safe to call while running.
+    bool Save(const std::wstring& path) const;
+    bool Load(const std::wstring& path);
+
+    static const size_t kMaxInputs = 4;
+    static const size_t kTerms = kMaxInputs + 1;        // plus intercept
+
+    // The fit remembers far longer than a fault takes to be flagged, so a
+    // slow degradation shows as excess instead of being learned. Forgetting
+    // is per kForgettingStep of snapshot time, whatever the sampling rate.
+    static constexpr double kForgetting = 0.99995;      // ~11 h memory
+    static constexpr double kForgettingStep = 2000;     // ms
+    static constexpr double kInputTau = 60000;          // ms; heatsinks lag the load
+    static constexpr double kResidualTau = 300000;      // ms
+    static constexpr float kMinExcess = 3.0f;           // C
+    static constexpr float kSigmas = 3.0f;
+    static const int64_t kSustain = 10 * 60 * 1000;     // ms above the limit before flagging
+    static const int64_t kRelearnAfter = 24 * 3600 * 1000LL;  // ms flagged before accepting it
+    static const uint32_t kWarmup = 900;                // updates before anything is flagged
+
+private:
+    struct SensorModel {
+        bool active;                  // temperature sensor
+        bool degraded;
+        uint32_t samples;
+        double weights[kTerms];
+        double covariance[kTerms][kTerms];
+        double excess;                // residual smoothed over kResidualTau
+        double noiseVariance;         // of the excess while healthy
+        double expected;
+        int64_t aboveSince;           // -1 while the excess is within the limit
+        int64_t degradedSince;
+    };
+
+    const SensorRegistry& registry;
+    std::vector<int> inputs;
+    double smoothed[kMaxInputs];
+    bool primed;
+    int64_t lastTime;
+    std::vector<SensorModel> models;
+
+    void Reset(SensorModel& model) const;
+    bool UpdateSensor(SensorModel& model, const double* x, double temp, double dt, int64_t now);
+    void Learn(SensorModel& model, const double* x, double error, double forgetting) const;
+};
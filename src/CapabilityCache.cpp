@@ -0,0 +1,267 @@
+#include "CapabilityCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+#endif
+
+namespace {
+#ifdef _WIN32
+    const wchar_t* kSection = L"Capabilities";
+
+    std::wstring ReadRegistryString(const wchar_t* key, const wchar_t* value) {
+        WCHAR buffer[256];
+        DWORD size = sizeof(buffer);
+        if (RegGetValueW(HKEY_LOCAL_MACHINE, key, value, RRF_RT_REG_SZ, NULL, buffer, &size) != ERROR_SUCCESS) {
+            return std::wstring();
+        }
+        return buffer;
+    }
+#else
+    const char* kSection = "[Capabilities]";
+
+    std::string ReadLine(const char* path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    std::string CpuModel() {
+        std::ifstream in("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.compare(0, 10, "model name") == 0) return line;
+        }
+        return std::string();
+    }
+
+    // Same layout GetPrivateProfileString reads, for the one section we use
+    std::map<std::string, std::string> ReadSection(const std::filesystem::path& path) {
+        std::map<std::string, std::string> values;
+        std::ifstream in(path);
+        std::string line;
+        bool inSection = false;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty() && line[0] == '[') {
+                inSection = (line == kSection);
+                continue;
+            }
+            size_t equals = line.find('=');
+            if (inSection && equals != std::string::npos) {
+                values[line.substr(0, equals)] = line.substr(equals + 1);
+            }
+        }
+        return values;
+    }
+#endif
+
+    template <typename Text>
+    uint64_t Fnv1a(const Text& text) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (auto c : text) {
+            hash ^= (uint64_t)(typename std::make_unsigned<typename Text::value_type>::type)c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+CapabilityCache::CapabilityCache(const std::wstring& cachePath)
+    : path(cachePath) {
+}
+
+#ifdef _WIN32
+std::string CapabilityCache::HardwareFingerprint() {
+    const wchar_t* cpuKey = L"HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\0";
+    const wchar_t* biosKey = L"HARDWARE\\DESCRIPTION\\System\\BIOS";
+
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    std::wstring identity = ReadRegistryString(cpuKey, L"ProcessorNameString") + L"|" +
+        ReadRegistryString(biosKey, L"BaseBoardManufacturer") + L"|" +
+        ReadRegistryString(biosKey, L"BaseBoardProduct") + L"|" +
+        ReadRegistryString(biosKey, L"BIOSVersion") + L"|" +
+        std::to_wstring(info.dwNumberOfProcessors);
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)Fnv1a(identity));
+    return hex;
+}
+
+bool CapabilityCache::Load(const std::string& fingerprint, Capabilities& capabilities) const {
+    if (path.empty()) return false;
+
+    WCHAR buffer[64];
+    GetPrivateProfileStringW(kSection, L"Fingerprint", L"", buffer, 64, path.c_str());
+    std::wstring stored(buffer);
+    if (stored.empty() || stored != std::wstring(fingerprint.begin(), fingerprint.end())) {
+        return false;
+    }
+
+    capabilities.fingerprint = fingerprint;
+    capabilities.cpuSource = GetPrivateProfileIntW(kSection, L"CpuSource", 0, path.c_str());
+    capabilities.cpuZones = GetPrivateProfileIntW(kSection, L"CpuZones", 0, path.c_str());
+
+    GetPrivateProfileStringW(kSection, L"ProbedAt", L"0", buffer, 64, path.c_str());
+    capabilities.probedAt = wcstoll(buffer, nullptr, 10);
+    return true;
+}
+
+bool CapabilityCache::Save(const Capabilities& capabilities) const {
+    if (path.empty()) return false;
+
+    std::wstring fingerprint(capabilities.fingerprint.begin(), capabilities.fingerprint.end());
+    return WritePrivateProfileStringW(kSection, L"Fingerprint", fingerprint.c_str(), path.c_str()) &&
+        WritePrivateProfileStringW(kSection, L"CpuSource", std::to_wstring(capabilities.cpuSource).c_str(), path.c_str()) &&
+        WritePrivateProfileStringW(kSection, L"CpuZones", std::to_wstring(capabilities.cpuZones).c_str(), path.c_str()) &&
+        WritePrivateProfileStringW(kSection, L"ProbedAt", std::to_wstring(capabilities.probedAt).c_str(), path.c_str());
+}
+#else
+std::string CapabilityCache::HardwareFingerprint() {
+    std::string identity = CpuModel() + "|" +
+        ReadLine("/sys/class/dmi/id/board_vendor") + "|" +
+        ReadLine("/sys/class/dmi/id/board_name") + "|" +
+        ReadLine("/sys/class/dmi/id/bios_version") + "|" +
+        std::to_string(std::thread::hardware_concurrency());
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)Fnv1a(identity));
+    return hex;
+}
+
+bool CapabilityCache::Load(const std::string& fingerprint, Capabilities& capabilities) const {
+    if (path.empty()) return false;
+
+    auto values = ReadSection(path);
+    if (values["Fingerprint"].empty() || values["Fingerprint"] != fingerprint) {
+        return false;
+    }
+
+    capabilities.fingerprint = fingerprint;
+    capabilities.cpuSource = atoi(values["CpuSource"].c_str());
+    capabilities.cpuZones = (uint32_t)strtoul(values["CpuZones"].c_str(), nullptr, 10);
+    capabilities.probedAt = strtoll(values["ProbedAt"].c_str(), nullptr, 10);
+    return true;
+}
+
+bool CapabilityCache::Save(const Capabilities& capabilities) const {
+    if (path.empty()) return false;
+
+    // Written whole and renamed over, so a crash leaves the old cache
+    std::filesystem::path target(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::trunc);
+        out << kSection << "\n"
+            << "Fingerprint=" << capabilities.fingerprint << "\n"
+            << "CpuSource=" << capabilities.cpuSource << "\n"
+            << "CpuZones=" << capabilities.cpuZones << "\n"
+            << "ProbedAt=" << capabilities.probedAt << "\n";
+        if (!out) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, target, ec);
+    return !ec;
+}
+#endif
+
+bool ProbeSchedule::ShouldProbe(int64_t now) {
+    if (nextProbe == 0) {
+        Failed(now);
+        return false;
+    }
+    return now >= nextProbe;
+}
+
+void ProbeSchedule::Failed(int64_t now) {
+    delay = (delay == 0) ? kMinDelay : delay * 2;
+    if (delay > kMaxDelay) delay = kMaxDelay;
+    nextProbe = now + delay;
+}
+
+SourceSelector::SourceSelector(int count, ReadFunction readFunction)
+    : sourceCount(count), read(readFunction), capabilities(), source(0), zones(0), cachedWorking(false) {
+    capabilities.cpuSource = -1;
+}
+
+void SourceSelector::Discover(const std::wstring& path, const std::string& fingerprint, int64_t now, int64_t steadyNow) {
+    cachePath = path;
+
+    Capabilities cached;
+    if (CapabilityCache(cachePath).Load(fingerprint, cached) &&
+        cached.cpuSource >= 0 && cached.cpuSource <= sourceCount &&
+        !(cached.cpuSource == 0 && now - cached.probedAt > kNegativeLifetime)) {
+        // Known hardware: trust the earlier probe, the first tick confirms it
+        capabilities = cached;
+        source = cached.cpuSource;
+        zones = cached.cpuZones;
+        cachedWorking = source != 0;
+        if (source == 0) {
+            schedule.Failed(steadyNow);
+        }
+        return;
+    }
+
+    capabilities = Capabilities();
+    capabilities.fingerprint = fingerprint;
+    capabilities.cpuSource = -1;
+    std::vector<float> values;
+    if (!Probe(values)) {
+        schedule.Failed(steadyNow);
+    }
+    // A full probe may record that nothing works; that expires
+    Save(now);
+}
+
+bool SourceSelector::Probe(std::vector<float>& values) {
+    for (int candidate = 1; candidate <= sourceCount; candidate++) {
+        if (read(candidate, values)) {
+            source = candidate;
+            zones = values.size();
+            return true;
+        }
+    }
+    source = 0;
+    values.clear();
+    return false;
+}
+
+bool SourceSelector::Read(std::vector<float>& values, int64_t now, int64_t steadyNow) {
+    if (source != 0 && read(source, values)) {
+        schedule.Succeeded();
+        return true;
+    }
+    cachedWorking = false;
+
+    // The source died or there never was one: probe again, backing off
+    // while nothing answers so dead backends are not queried every tick
+    if (!schedule.ShouldProbe(steadyNow)) return false;
+    if (!Probe(values)) {
+        schedule.Failed(steadyNow);
+        return false;
+    }
+    schedule.Succeeded();
+    Save(now);
+    return true;
+}
+
+void SourceSelector::Save(int64_t now) {
+    if (capabilities.cpuSource == source && capabilities.cpuZones == zones) return;
+
+    capabilities.cpuSource = source;
+    capabilities.cpuZones = (uint32_t)zones;
+    capabilities.probedAt = now;
+    CapabilityCache(cachePath).Save(capabilities);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// What sensor discovery found on this machine. Kept in capabilities.ini
+// next to config.ini so later starts go straight to the working backends.
+struct Capabilities {
+    std::string fingerprint;
+    int cpuSource;        // TempMonitor::CpuSource
+    uint32_t cpuZones;
+    int64_t probedAt;     // ms since epoch
+};
+
+class CapabilityCache {
+public:
+    explicit CapabilityCache(const std::wstring& path);
+
+    // False when there is no cache or it was written on other hardware
+    bool Load(const std::string& fingerprint, Capabilities& capabilities) const;
+    bool Save(const Capabilities& capabilities) const;
+
+    // Hash of CPU, board and BIOS identification; survives reboots but
+    // changes when the hardware or firmware does. Read from the registry
+    // on Windows and from /proc/cpuinfo and DMI in sysfs elsewhere.
+    static std::string HardwareFingerprint();
+
+private:
+    std::wstring path;
+};
+
+// When to look again for a source that stopped answering: not on the
+// first failed read, then soon, then less and less often
+class ProbeSchedule {
+public:
+    ProbeSchedule() : nextProbe(0), delay(0) {}
+
+    // For every failed read; true when a probe should run now. The first
+    // failure only starts the backoff, so one bad read costs no probe.
+    bool ShouldProbe(int64_t now);
+    void Failed(int64_t now);
+    void Succeeded() { nextProbe = 0; delay = 0; }
+
+    static constexpr int64_t kMinDelay = 30 * 1000;
+    static constexpr int64_t kMaxDelay = 10 * 60 * 1000;
+
+private:
+    int64_t nextProbe;
+    int64_t delay;
+};
+
+// Picks one of several interchangeable sources, tried in preference order
+// (1 first; 0 means none works). A full probe at startup is cached by
+// hardware fingerprint, so later starts read the working source without
+// touching the others. That a full probe found nothing is cached too, but
+// only for kNegativeLifetime. A source that stops answering is re-probed
+// on a ProbeSchedule; only a probe that finds a working source is saved.
+class SourceSelector {
+public:
+    // Reads a source into values; false when it does not answer
+    typedef std::function<bool(int source, std::vector<float>& values)> ReadFunction;
+
+    SourceSelector(int sourceCount, ReadFunction read);
+
+    // Startup: the cached choice for this fingerprint, or a full probe.
+    // now is ms since epoch, steadyNow is SteadyNow().
+    void Discover(const std::wstring& cachePath, const std::string& fingerprint, int64_t now, int64_t steadyNow);
+
+    // Every tick: reads the chosen source, probing again when it fails
+    bool Read(std::vector<float>& values, int64_t now, int64_t steadyNow);
+
+    int GetSource() const { return source; }
+    size_t GetZoneCount() const { return zones; }
+
+    // The source came from the cache and has not failed since
+    bool IsCachedWorking() const { return cachedWorking; }
+
+    static constexpr int64_t kNegativeLifetime = 24 * 3600 * 1000LL;
+
+private:
+    int sourceCount;
+    ReadFunction read;
+    std::wstring cachePath;
+    Capabilities capabilities;   // as last saved
+    ProbeSchedule schedule;
+    int source;
+    size_t zones;
+    std::atomic<bool> cachedWorking;   // also read from the UI thread
+
+    bool Probe(std::vector<float>& values);
+    void Save(int64_t now);
+};
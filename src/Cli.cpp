@@ -0,0 +1,555 @@
+#include "Cli.h"
+#include "History.h"
+#include "ReplayProvider.h"
+#include "LoadGenerator.h"
+#include "Soak.h"
+#ifdef _WIN32
+#include "Config.h"
+#include "TelemetryQuery.h"
+#include "Simulator.h"
+#include "TempMonitor.h"
+#include <shellapi.h>
+#else
+#include "HwmonSensors.h"
+#endif
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cwchar>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string Narrow(const std::wstring& s) {
+    return std::string(s.begin(), s.end());
+}
+
+#ifdef _WIN32
+static void AttachOutput() {
+    // The app is built for the Windows subsystem, so borrow the parent's console
+    if (!AttachConsole(ATTACH_PARENT_PROCESS)) {
+        AllocConsole();
+    }
+    FILE* f = nullptr;
+    freopen_s(&f, "CONOUT$", "w", stdout);
+    freopen_s(&f, "CONOUT$", "w", stderr);
+}
+
+static void FormatTime(int64_t timestamp, char* buffer, size_t size) {
+    time_t seconds = (time_t)(timestamp / 1000);
+    struct tm utc;
+    gmtime_s(&utc, &seconds);
+    strftime(buffer, size, "%Y-%m-%d %H:%M", &utc);
+}
+
+static bool ParseAggregate(const std::wstring& name, QuerySpec& spec) {
+    if (name == L"min") {
+        spec.aggregate = Aggregate::Min;
+    } else if (name == L"max") {
+        spec.aggregate = Aggregate::Max;
+    } else if (name == L"mean") {
+        spec.aggregate = Aggregate::Mean;
+    } else if (name == L"above") {
+        spec.aggregate = Aggregate::TimeAbove;
+    } else if (name.size() > 1 && name[0] == L'p') {
+        spec.aggregate = Aggregate::Percentile;
+        spec.percentile = _wtof(name.c_str() + 1);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void PrintQueryUsage() {
+    fprintf(stderr,
+        "usage: TempMonitor.exe query <channel> <min|max|mean|pNN|above>\n"
+        "           [--days N] [--hours N] [--bucket none|hour|day]\n"
+        "           [--threshold C] [--threads N] [--export FILE]\n"
+        "  channel is a recorded sensor key, e.g. cpu, cpu1, gpu or fan\n"
+        "  above reports seconds spent at or above the threshold\n"
+        "  (defaults to the configured warning temperature)\n"
+        "  --export writes a quantile sketch of the whole range for \"merge\"\n");
+}
+
+static int RunQuery(const std::vector<std::wstring>& args) {
+    if (args.size() < 3) {
+        PrintQueryUsage();
+        return 1;
+    }
+
+    Config config;
+    config.Load();
+
+    QuerySpec spec = {};
+    spec.channel = Narrow(args[1]);
+    spec.threshold = (float)config.GetWarningTemp();
+    if (!ParseAggregate(args[2], spec)) {
+        PrintQueryUsage();
+        return 1;
+    }
+
+    int64_t range = 7LL * 24 * 3600 * 1000;
+    unsigned threads = 0;
+    std::wstring exportPath;
+    for (size_t i = 3; i < args.size(); i += 2) {
+        // Every option takes a value
+        if (i + 1 >= args.size()) {
+            PrintQueryUsage();
+            return 1;
+        }
+        const std::wstring& key = args[i];
+        const std::wstring& value = args[i + 1];
+        if (key == L"--days") {
+            range = (int64_t)(_wtof(value.c_str()) * 24 * 3600 * 1000);
+        } else if (key == L"--hours") {
+            range = (int64_t)(_wtof(value.c_str()) * 3600 * 1000);
+        } else if (key == L"--bucket") {
+            if (value == L"hour") spec.bucketSize = 3600LL * 1000;
+            else if (value == L"day") spec.bucketSize = 24LL * 3600 * 1000;
+            else spec.bucketSize = 0;
+        } else if (key == L"--threshold") {
+            spec.threshold = (float)_wtof(value.c_str());
+        } else if (key == L"--threads") {
+            threads = (unsigned)_wtoi(value.c_str());
+        } else if (key == L"--export") {
+            exportPath = value;
+        } else {
+            PrintQueryUsage();
+            return 1;
+        }
+    }
+
+    spec.endTime = History::Now();
+    spec.startTime = spec.endTime - range;
+    if (spec.bucketSize > 0) {
+        // Align buckets to UTC hour/day boundaries
+        spec.startTime -= spec.startTime % spec.bucketSize;
+    }
+
+    TelemetryQuery query(config.GetHistoryDir(), threads);
+    std::vector<QueryRow> rows = query.Run(spec);
+
+    char timeText[32];
+    for (const auto& row : rows) {
+        FormatTime(row.bucketStart, timeText, sizeof(timeText));
+        if (std::isnan(row.value)) {
+            printf("%s\t-\t%llu\n", timeText, (unsigned long long)row.samples);
+        } else {
+            printf("%s\t%.1f\t%llu\n", timeText, row.value, (unsigned long long)row.samples);
+        }
+    }
+
+    if (!exportPath.empty()) {
+        QuerySpec whole = spec;
+        whole.bucketSize = 0;
+        std::string data = query.Sketch(whole)[0].Serialize();
+
+        std::ofstream out(exportPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.write(data.data(), data.size())) {
+            fprintf(stderr, "cannot write %s\n", Narrow(exportPath).c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int RunMerge(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        fprintf(stderr,
+            "usage: TempMonitor.exe merge <sketch file>...\n"
+            "  merges sketches written by \"query --export\", e.g. from several\n"
+            "  machines or weeks, and prints their combined percentiles\n");
+        return 1;
+    }
+
+    QuantileSketch merged;
+    for (size_t i = 1; i < args.size(); i++) {
+        std::ifstream in(args[i].c_str(), std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        QuantileSketch sketch;
+        if (!sketch.Deserialize(data) || !merged.Merge(sketch)) {
+            fprintf(stderr, "%s is not a compatible sketch\n", Narrow(args[i]).c_str());
+            return 1;
+        }
+    }
+
+    const double quantiles[] = { 0.5, 0.9, 0.95, 0.99, 0.999 };
+    for (double q : quantiles) {
+        printf("p%g\t%.1f\n", q * 100, merged.Quantile(q));
+    }
+    printf("max\t%.1f\nsamples\t%llu\n", merged.GetMax(), (unsigned long long)merged.GetCount());
+    return 0;
+}
+
+static void PrintSimulateUsage() {
+    fprintf(stderr,
+        "usage: TempMonitor.exe simulate <constant|ramp|spike|square|recorded>\n"
+        "           [--base C] [--peak C] [--period S] [--width S]\n"
+        "           [--noise C] [--dropout RATE] [--interval MS] [--minutes N]\n"
+        "           [--seed N] [--sensors N] [--days N] [--speed X]\n"
+        "           [--warning C] [--danger C]\n"
+        "           [--tau S] [--load 1] [--degrade-at S] [--degrade-by C]\n"
+        "  recorded replays the last --days of history\n"
+        "  --tau makes temperatures follow the shape with that time constant\n"
+        "  --load 1 adds a load sensor following the shape, so the baseline\n"
+        "  model can learn it; --degrade-by then raises temperatures for the\n"
+        "  same load from --degrade-at on\n"
+        "  --speed 0 (default) runs as fast as possible\n");
+}
+
+static const char* LevelName(TempLevel level) {
+    switch (level) {
+    case TempLevel::Danger: return "danger";
+    case TempLevel::Warning: return "warning";
+    default: return "normal";
+    }
+}
+
+static int RunSimulate(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        PrintSimulateUsage();
+        return 1;
+    }
+
+    Config config;
+    config.Load();
+
+    SyntheticTrace trace = {};
+    trace.baseTemp = 45.0f;
+    trace.peakTemp = 90.0f;
+    trace.period = 10 * 60 * 1000;
+    trace.spikeWidth = 20 * 1000;
+    trace.interval = 2000;
+    trace.duration = 60 * 60 * 1000;
+    trace.seed = 1;
+
+    const std::wstring& kind = args[1];
+    bool recorded = false;
+    if (kind == L"constant") trace.shape = SyntheticTrace::Shape::Constant;
+    else if (kind == L"ramp") trace.shape = SyntheticTrace::Shape::Ramp;
+    else if (kind == L"spike") trace.shape = SyntheticTrace::Shape::Spike;
+    else if (kind == L"square") trace.shape = SyntheticTrace::Shape::Square;
+    else if (kind == L"recorded") recorded = true;
+    else {
+        PrintSimulateUsage();
+        return 1;
+    }
+
+    double days = 1.0;
+    double speed = 0.0;
+    int warningTemp = config.GetWarningTemp();
+    int dangerTemp = config.GetDangerTemp();
+    for (size_t i = 2; i < args.size(); i += 2) {
+        if (i + 1 >= args.size()) {
+            PrintSimulateUsage();
+            return 1;
+        }
+        const std::wstring& key = args[i];
+        double value = _wtof(args[i + 1].c_str());
+        if (key == L"--base") trace.baseTemp = (float)value;
+        else if (key == L"--peak") trace.peakTemp = (float)value;
+        else if (key == L"--period") trace.period = (int64_t)(value * 1000);
+        else if (key == L"--width") trace.spikeWidth = (int64_t)(value * 1000);
+        else if (key == L"--noise") trace.noise = (float)value;
+        else if (key == L"--dropout") trace.dropoutRate = (float)value;
+        else if (key == L"--interval") trace.interval = (int64_t)value;
+        else if (key == L"--minutes") trace.duration = (int64_t)(value * 60 * 1000);
+        else if (key == L"--seed") trace.seed = (uint32_t)value;
+        else if (key == L"--sensors") trace.sensorCount = (int)value;
+        else if (key == L"--days") days = value;
+        else if (key == L"--speed") speed = value;
+        else if (key == L"--warning") warningTemp = (int)value;
+        else if (key == L"--danger") dangerTemp = (int)value;
+        else if (key == L"--tau") trace.timeConstant = (int64_t)(value * 1000);
+        else if (key == L"--load") trace.withLoad = value != 0;
+        else if (key == L"--degrade-at") trace.degradeAt = (int64_t)(value * 1000);
+        else if (key == L"--degrade-by") trace.degradeBy = (float)value;
+        else {
+            PrintSimulateUsage();
+            return 1;
+        }
+    }
+
+    ReplayProvider provider;
+    if (recorded) {
+        int64_t end = History::Now();
+        if (!provider.OpenRecording(config.GetHistoryDir(), end - (int64_t)(days * 24 * 3600 * 1000), end)) {
+            fprintf(stderr, "no recorded history in range\n");
+            return 1;
+        }
+    } else {
+        provider.SetSynthetic(trace);
+    }
+
+    Simulator simulator(warningTemp, dangerTemp);
+    SimResult result = simulator.Run(provider, speed);
+
+    for (const auto& e : result.events) {
+        if (e.type == SimEventType::Degraded || e.type == SimEventType::Recovered) {
+            const char* type = e.type == SimEventType::Degraded ? "degraded" : "recovered";
+            printf("%10.1f\t%s\t%s\t%+.1f\n", e.timestamp / 1000.0, type,
+                provider.GetRegistry().Get(e.sensor).key, e.excess);
+            continue;
+        }
+        const char* type = e.type == SimEventType::Show ? "show" :
+            e.type == SimEventType::Hide ? "hide" : "level";
+        printf("%10.1f\t%s\t%s\t%.1f\n", e.timestamp / 1000.0, type, LevelName(e.level), e.maxTemp);
+    }
+
+    double speedup = result.wallSeconds > 0 ? (result.simulatedTime / 1000.0) / result.wallSeconds : 0.0;
+    fprintf(stderr, "%llu ticks (%llu invalid), %.1f s simulated in %.3f s (%.0fx real time)\n",
+        (unsigned long long)result.ticks, (unsigned long long)result.invalidTicks,
+        result.simulatedTime / 1000.0, result.wallSeconds, speedup);
+    return 0;
+}
+
+#else
+// $XDG_DATA_HOME/TempMonitor/soak, or under ~/.local/share
+static std::wstring GetSoakDir() {
+    const char* data = getenv("XDG_DATA_HOME");
+    const char* home = getenv("HOME");
+    std::filesystem::path base = data && *data ? std::filesystem::path(data) :
+        std::filesystem::path(home ? home : ".") / ".local" / "share";
+    return (base / "TempMonitor" / "soak").wstring();
+}
+#endif
+
+static void PrintSoakUsage() {
+#ifdef _WIN32
+    const char* program = "TempMonitor.exe";
+#else
+    const char* program = "TempMonitor";
+#endif
+    fprintf(stderr,
+        "usage: %s soak <scalar|vector|memory|replay>\n"
+        "           [--threads N] [--idle S] [--minutes N] [--cooldown S]\n"
+        "           [--interval MS] [--output FILE]\n"
+        "           [--base C] [--peak C] [--tau S] [--noise C] [--seed N]\n"
+        "  runs the load on every core (or --threads) between an idle and a\n"
+        "  cooldown phase, sampling all sensors every --interval ms\n"
+        "  vector uses AVX2/FMA when available, memory streams past the caches\n"
+        "  replay analyzes a generated first-order trace (--base, --peak, --tau)\n"
+        "  instead of loading the machine\n"
+        "  results go to --output, or to a new file in the soak directory\n", program);
+}
+
+static int RunSoak(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        PrintSoakUsage();
+        return 1;
+    }
+
+#ifdef _WIN32
+    Config config;
+    config.Load();
+#endif
+
+    SoakReport report = {};
+    SoakLoad load = SoakLoad::Scalar;
+    const std::wstring& kind = args[1];
+    bool replay = false;
+    if (kind == L"scalar") load = SoakLoad::Scalar;
+    else if (kind == L"vector") load = SoakLoad::Vector;
+    else if (kind == L"memory") load = SoakLoad::Memory;
+    else if (kind == L"replay") replay = true;
+    else {
+        PrintSoakUsage();
+        return 1;
+    }
+    report.load = Narrow(kind);
+
+    SyntheticTrace trace = {};
+    trace.shape = SyntheticTrace::Shape::Soak;
+    trace.baseTemp = 40.0f;
+    trace.peakTemp = 85.0f;
+    trace.timeConstant = 60 * 1000;
+    trace.seed = 1;
+
+    int threads = 0;
+    report.interval = 250;
+    report.phases.idle = 60 * 1000;
+    report.phases.load = 10 * 60 * 1000;
+    report.phases.cooldown = 5 * 60 * 1000;
+    std::wstring output;
+    for (size_t i = 2; i < args.size(); i += 2) {
+        if (i + 1 >= args.size()) {
+            PrintSoakUsage();
+            return 1;
+        }
+        const std::wstring& key = args[i];
+        double value = wcstod(args[i + 1].c_str(), nullptr);
+        if (key == L"--threads") threads = (int)value;
+        else if (key == L"--idle") report.phases.idle = (int64_t)(value * 1000);
+        else if (key == L"--minutes") report.phases.load = (int64_t)(value * 60 * 1000);
+        else if (key == L"--cooldown") report.phases.cooldown = (int64_t)(value * 1000);
+        else if (key == L"--interval") report.interval = (int)value;
+        else if (key == L"--output") output = args[i + 1];
+        else if (key == L"--base") trace.baseTemp = (float)value;
+        else if (key == L"--peak") trace.peakTemp = (float)value;
+        else if (key == L"--tau") trace.timeConstant = (int64_t)(value * 1000);
+        else if (key == L"--noise") trace.noise = (float)value;
+        else if (key == L"--seed") trace.seed = (uint32_t)value;
+        else {
+            PrintSoakUsage();
+            return 1;
+        }
+    }
+    if (report.interval < 10) report.interval = 10;
+    report.started = History::Now();
+
+    const int64_t loadEnd = report.phases.idle + report.phases.load;
+    const int64_t total = loadEnd + report.phases.cooldown;
+    SensorSnapshot snapshot;
+    std::vector<SoakResult> results;
+
+    if (replay) {
+        trace.interval = report.interval;
+        trace.period = report.phases.idle;
+        trace.spikeWidth = report.phases.load;
+        trace.duration = total;
+
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        SoakRecorder recorder(provider.GetRegistry());
+        while (provider.Next(snapshot)) {
+            recorder.Add(snapshot, provider.GetTime());
+        }
+        results = recorder.Analyze(report.phases);
+    } else {
+#ifdef _WIN32
+        TempMonitor monitor;
+        monitor.Initialize(config.GetCapabilityPath());
+        monitor.SetReadDeadline(report.interval / 2);
+#else
+        HwmonReader monitor;
+        if (!monitor.Initialize()) {
+            fprintf(stderr, "no hwmon or thermal zone temperatures found\n");
+            return 1;
+        }
+#endif
+        SoakRecorder recorder(monitor.GetRegistry());
+        LoadGenerator generator;
+
+        // The phases are measured where the load actually started and stopped
+        const int64_t start = SteadyNow();
+        int64_t loadStarted = -1;
+        int64_t loadStopped = -1;
+        uint64_t work = 0;
+        fprintf(stderr, "idle for %.0f s\n", report.phases.idle / 1000.0);
+
+        for (int64_t tick = 0;; tick++) {
+            int64_t wait = start + tick * report.interval - SteadyNow();
+            if (wait > 0) std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+
+            int64_t elapsed = SteadyNow() - start;
+            if (loadStarted < 0 && elapsed >= report.phases.idle) {
+                generator.Start(load, threads);
+                loadStarted = elapsed;
+                report.threads = generator.GetThreadCount();
+                fprintf(stderr, "%s load on %d threads for %.0f s\n", report.load.c_str(),
+                    report.threads, report.phases.load / 1000.0);
+            }
+            if (loadStarted >= 0 && loadStopped < 0 && elapsed >= loadStarted + report.phases.load) {
+                work = generator.GetWorkUnits();
+                generator.Stop();
+                loadStopped = elapsed;
+                fprintf(stderr, "cooling down for %.0f s\n", report.phases.cooldown / 1000.0);
+            }
+            if (loadStopped >= 0 && elapsed >= loadStopped + report.phases.cooldown) break;
+
+            monitor.Sample(snapshot);
+            recorder.Add(snapshot, elapsed);
+        }
+
+        report.phases.idle = loadStarted;
+        report.phases.load = loadStopped - loadStarted;
+        report.workRate = report.phases.load > 0 ? work * 1000.0 / report.phases.load : 0.0;
+        results = recorder.Analyze(report.phases);
+    }
+    report.sensors = results;
+
+    std::string json = FormatSoakJson(report);
+    printf("%s", json.c_str());
+
+    if (output.empty()) {
+#ifdef _WIN32
+        std::filesystem::path dir = config.GetSoakDir();
+#else
+        std::filesystem::path dir = GetSoakDir();
+#endif
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        output = (dir / (L"soak_" + std::to_wstring(report.started) + L".json")).wstring();
+    }
+    std::ofstream out(std::filesystem::path(output), std::ios::binary | std::ios::trunc);
+    out << json;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", Narrow(output).c_str());
+        return 1;
+    }
+    fprintf(stderr, "written to %s\n", Narrow(output).c_str());
+    return 0;
+}
+
+#ifdef _WIN32
+bool RunCommandLine(PWSTR pCmdLine, int& exitCode) {
+    if (!pCmdLine || !*pCmdLine) return false;
+
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(pCmdLine, &argc);
+    if (!argv) return false;
+
+    std::vector<std::wstring> args(argv, argv + argc);
+    LocalFree(argv);
+
+    if (args.empty()) return false;
+
+    if (args[0] == L"query") {
+        AttachOutput();
+        exitCode = RunQuery(args);
+        return true;
+    }
+
+    if (args[0] == L"merge") {
+        AttachOutput();
+        exitCode = RunMerge(args);
+        return true;
+    }
+
+    if (args[0] == L"simulate") {
+        AttachOutput();
+        exitCode = RunSimulate(args);
+        return true;
+    }
+
+    if (args[0] == L"soak") {
+        AttachOutput();
+        exitCode = RunSoak(args);
+        return true;
+    }
+
+    return false;
+}
+#else
+bool RunCommandLine(int argc, char** argv, int& exitCode) {
+    std::vector<std::wstring> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        args.push_back(std::wstring(arg.begin(), arg.end()));
+    }
+    if (args.empty()) return false;
+
+    if (args[0] == L"soak") {
+        exitCode = RunSoak(args);
+        return true;
+    }
+
+    return false;
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+
+// Handles command line subcommands such as "TempMonitor.exe query ...".
+// Returns false when the command line holds no subcommand and the tray
+// application should start as usual.
+bool RunCommandLine(PWSTR pCmdLine, int& exitCode);
+#else
+// Elsewhere only soak runs, reading hwmon and the thermal zones; argv
+// starts at the subcommand. Returns false for anything else.
+bool RunCommandLine(int argc, char** argv, int& exitCode);
+#endif
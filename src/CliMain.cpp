@@ -0,0 +1,13 @@
+#include "Cli.h"
+#include <cstdio>
+
+// Entry point outside Windows, where there is no tray app and only the
+// subcommands that need neither WMI nor the UI are built
+int main(int argc, char** argv) {
+    int exitCode = 1;
+    if (!RunCommandLine(argc - 1, argv + 1, exitCode)) {
+        fprintf(stderr, "usage: TempMonitor soak <scalar|vector|memory|replay> [options]\n");
+        return 1;
+    }
+    return exitCode;
+}
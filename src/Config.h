@@ -1,47 +1,79 @@
-#pragma once
-#include <windows.h>
-#include <string>
-
-class Config {
-public:
-    Config();
-    ~Config();
-
-    // Load configuration from file
-    bool Load();
-    
-    // Save configuration to file
-    bool Save();
-
-    // Temperature thresholds
-    int GetWarningTemp() const { return warningTemp; }
-    void SetWarningTemp(int temp) { warningTemp = temp; }
-    
-    int GetDangerTemp() const { return dangerTemp; }
-    void SetDangerTemp(int temp) { dangerTemp = temp; }
-
-    // Window position
-    int GetWindowX() const { return windowX; }
-    void SetWindowX(int x) { windowX = x; }
-    
-    int GetWindowY() const { return windowY; }
-    void SetWindowY(int y) { windowY = y; }
-
-    // Auto-start
-    bool GetAutoStart() const { return autoStart; }
-    void SetAutoStart(bool enable);
-
-    // Config file path
-    std::wstring GetConfigPath() const { return configPath; }
-
-private:
-    std::wstring configPath;
-    int warningTemp;
-    int dangerTemp;
-    int windowX;
-    int windowY;
-    bool autoStart;
-
-    void CreateDefaultConfig();
-    bool SetAutoStartRegistry(bool enable);
-};
+#pragma once
+#include <windows.h>
+#include <string>
+
+class Config {
+public:
+    Config();
+    ~Config();
+
+    // Load configuration from file
+    bool Load();
+    
+    // Save configuration to file
+    bool Save();
+
+    // Temperature thresholds
+    int GetWarningTemp() const { return warningTemp; }
+    void SetWarningTemp(int temp) { warningTemp = temp; }
+    
+    int GetDangerTemp() const { return dangerTemp; }
+    void SetDangerTemp(int temp) { dangerTemp = temp; }
+
+    // Window position
+    int GetWindowX() const { return windowX; }
+    void SetWindowX(int x) { windowX = x; }
+    
+    int GetWindowY() const { return windowY; }
+    void SetWindowY(int y) { windowY = y; }
+
+    // Auto-start
+    bool GetAutoStart() const { return autoStart; }
+    void SetAutoStart(bool enable);
+
+    // Wake on WMI thermal events and poll slowly otherwise; set by hand
+    bool GetEventDriven() const { return eventDriven; }
+
+    // Record a trace-event timeline of each tick; set by hand
+    bool GetTrace() const { return trace; }
+
+    // Flight recorder, set by hand in [FlightRecorder]
+    bool GetFlightRecorder() const { return flightRecorder; }
+    int GetFlightInterval() const { return flightInterval; }        // ms
+    int GetFlightPreTrigger() const { return flightPreTrigger; }    // s
+    int GetFlightPostTrigger() const { return flightPostTrigger; }  // s
+
+    // Live stream port on 127.0.0.1, 0 = off; set by hand in [Stream]
+    int GetStreamPort() const { return streamPort; }
+
+    // Config file path
+    std::wstring GetConfigPath() const { return configPath; }
+
+    // Directory holding config.ini and recorded data
+    std::wstring GetDataDir() const { return dataDir; }
+    std::wstring GetHistoryDir() const { return dataDir + L"\\history"; }
+    std::wstring GetFlightDir() const { return dataDir + L"\\flight"; }
+    std::wstring GetTraceDir() const { return dataDir + L"\\trace"; }
+    std::wstring GetSoakDir() const { return dataDir + L"\\soak"; }
+    std::wstring GetCapabilityPath() const { return dataDir + L"\\capabilities.ini"; }
+    std::wstring GetBaselinePath() const { return dataDir + L"\\baseline.dat"; }
+
+private:
+    std::wstring configPath;
+    std::wstring dataDir;
+    int warningTemp;
+    int dangerTemp;
+    int windowX;
+    int windowY;
+    bool autoStart;
+    bool eventDriven;
+    bool trace;
+    bool flightRecorder;
+    int flightInterval;
+    int flightPreTrigger;
+    int flightPostTrigger;
+    int streamPort;
+
+    void CreateDefaultConfig();
+    bool SetAutoStartRegistry(bool enable);
+};
@@ -0,0 +1,153 @@
+#include "FlightRecorder.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+FlightRecorder::FlightRecorder(const std::wstring& dir, const std::vector<std::string>& chans,
+    int64_t sampleInterval, int64_t pre, int64_t post)
+    : directory(dir), channels(chans), interval(std::max<int64_t>(sampleInterval, 1)),
+      preTrigger(std::max<int64_t>(pre, 0)), postTrigger(std::max<int64_t>(post, 0)),
+      written(0), pinned(kNotPinned), dropped(0), capturing(false), capture(),
+      writing(false), stopping(false) {
+    // One capture plus as much again, so the writer has a whole capture's
+    // duration to finish before the sampler reaches the pinned slots
+    capacity = (size_t)(2 * (preTrigger + postTrigger) / interval) + 2;
+    ring.reset(new SensorSnapshot[capacity]);
+
+    std::error_code ec;
+    fs::create_directories(fs::path(directory), ec);
+
+    writer = std::thread(&FlightRecorder::WriterLoop, this);
+}
+
+FlightRecorder::~FlightRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+std::wstring FlightRecorder::FileName(int64_t triggerTime) {
+    return L"flight_" + std::to_wstring(triggerTime) + L".tmf";
+}
+
+uint64_t FlightRecorder::FirstInWindow(int64_t start) const {
+    uint64_t oldest = written > capacity ? written - capacity : 0;
+    uint64_t first = written;
+    while (first > oldest && ring[(first - 1) % capacity].time >= start) {
+        first--;
+    }
+    return first;
+}
+
+void FlightRecorder::Record(const SensorSnapshot& snapshot) {
+    uint64_t pin = pinned.load(std::memory_order_acquire);
+    if (pin != kNotPinned && written >= pin + capacity) {
+        // The writer still needs this slot
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[written % capacity] = snapshot;
+    written++;
+
+    const int64_t end = capture.triggerTime + postTrigger;
+    if (!capturing || snapshot.time < end) return;
+
+    // Post-trigger window complete; leave out every sample at or past its end
+    capture.last = written;
+    while (capture.last > capture.first && ring[(capture.last - 1) % capacity].time >= end) {
+        capture.last--;
+    }
+    capturing = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(capture);
+    }
+    wake.notify_one();
+}
+
+bool FlightRecorder::Trigger(int64_t time, const std::string& reason) {
+    if (capturing || pinned.load(std::memory_order_acquire) != kNotPinned) return false;
+
+    capture.first = FirstInWindow(time - preTrigger);
+    capture.last = capture.first;
+    capture.triggerTime = time;
+    capture.reason = reason;
+    capturing = true;
+    pinned.store(capture.first, std::memory_order_release);
+    return true;
+}
+
+void FlightRecorder::WaitForDumps() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && !writing; });
+}
+
+void FlightRecorder::WriterLoop() {
+    for (;;) {
+        Dump dump;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+
+            dump = queue.front();
+            queue.erase(queue.begin());
+            writing = true;
+        }
+
+        WriteDump(dump);
+        pinned.store(kNotPinned, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+        }
+        idle.notify_all();
+    }
+}
+
+bool FlightRecorder::WriteDump(const Dump& dump) {
+    using namespace FlightFormat;
+
+    const uint16_t channelCount = (uint16_t)std::min(channels.size(), kMaxSensors);
+
+    Header header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.channelCount = channelCount;
+    header.sampleCount = (uint32_t)(dump.last - dump.first);
+    header.triggerTime = dump.triggerTime;
+    header.preTrigger = preTrigger;
+    header.postTrigger = postTrigger;
+    header.interval = interval;
+    strncpy(header.reason, dump.reason.c_str(), kReasonSize - 1);
+
+    fs::path path = fs::path(directory) / FileName(dump.triggerTime);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    out.write((const char*)&header, sizeof(header));
+    for (uint16_t c = 0; c < channelCount; c++) {
+        char name[kChannelNameSize] = {};
+        strncpy(name, channels[c].c_str(), kChannelNameSize - 1);
+        out.write(name, kChannelNameSize);
+    }
+
+    // Rows are written straight out of the pinned ring slots
+    for (uint64_t seq = dump.first; seq < dump.last; seq++) {
+        const SensorSnapshot& slot = ring[seq % capacity];
+        out.write((const char*)&slot.time, sizeof(slot.time));
+        out.write((const char*)slot.values, channelCount * sizeof(float));
+        out.write((const char*)slot.valid, channelCount);
+    }
+    return (bool)out;
+}
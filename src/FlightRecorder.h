@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Sensor.h"
+
+namespace FlightFormat {
+    const uint32_t kMagic = 0x52464D54;   // "TMFR"
+    const uint16_t kVersion = 1;
+    const size_t kChannelNameSize = 16;
+    const size_t kReasonSize = 64;
+
+    // File layout: header, channel names, then one row per sample:
+    // int64 time, float values[channelCount], uint8 valid[channelCount]
+#pragma pack(push, 1)
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t channelCount;
+        uint32_t sampleCount;
+        int64_t triggerTime;    // ms since epoch
+        int64_t preTrigger;     // ms
+        int64_t postTrigger;    // ms
+        int64_t interval;       // ms
+        char reason[kReasonSize];
+    };
+#pragma pack(pop)
+}
+
+// Keeps the last preTrigger ms of high-rate samples in a fixed ring. After
+// Trigger(), recording continues for postTrigger ms and the capture, every
+// sample in [trigger - preTrigger, trigger + postTrigger), is written to
+// "flight_<trigger>.tmf" by a background thread straight from the ring.
+// The captured slots are pinned until written; if the writer falls a whole
+// ring behind, new samples are dropped rather than stalling the sampler.
+class FlightRecorder {
+public:
+    FlightRecorder(const std::wstring& dir, const std::vector<std::string>& channels,
+        int64_t interval, int64_t preTrigger, int64_t postTrigger);
+    ~FlightRecorder();
+
+    // Sampler thread only; never blocks
+    void Record(const SensorSnapshot& snapshot);
+
+    // Starts a capture around the given time; ignored while one is running
+    bool Trigger(int64_t time, const std::string& reason);
+
+    bool IsCapturing() const { return capturing; }
+    size_t GetCapacity() const { return capacity; }
+    uint64_t GetDroppedSamples() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Blocks until queued captures are on disk; for shutdown and tests
+    void WaitForDumps();
+
+    static std::wstring FileName(int64_t triggerTime);
+
+private:
+    struct Dump {
+        uint64_t first;   // first ring sequence in the capture
+        uint64_t last;    // one past the last
+        int64_t triggerTime;
+        std::string reason;
+    };
+
+    static const uint64_t kNotPinned = ~0ULL;
+
+    std::wstring directory;
+    std::vector<std::string> channels;
+    int64_t interval;
+    int64_t preTrigger;
+    int64_t postTrigger;
+
+    size_t capacity;
+    std::unique_ptr<SensorSnapshot[]> ring;
+    uint64_t written;
+    std::atomic<uint64_t> pinned;     // oldest sequence the writer still needs
+    std::atomic<uint64_t> dropped;
+
+    bool capturing;
+    Dump capture;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<Dump> queue;
+    bool writing;
+    bool stopping;
+    std::thread writer;
+
+    uint64_t FirstInWindow(int64_t start) const;
+    void WriterLoop();
+    bool WriteDump(const Dump& dump);
+};
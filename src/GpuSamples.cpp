@@ -0,0 +1,106 @@
+#include "GpuSamples.h"
+#include <algorithm>
+
+namespace {
+    enum {
+        NVML_VALUE_TYPE_DOUBLE = 0,
+        NVML_VALUE_TYPE_UNSIGNED_INT = 1,
+        NVML_VALUE_TYPE_UNSIGNED_LONG = 2,
+        NVML_VALUE_TYPE_UNSIGNED_LONG_LONG = 3,
+        NVML_VALUE_TYPE_SIGNED_LONG_LONG = 4
+    };
+
+    const int NVML_ERROR_NOT_FOUND = 6;
+
+    // nvmlSamplingType_t of each type and the factor to the sensor's unit
+    struct BufferedType {
+        int samplingType;
+        float scale;
+    };
+
+    const BufferedType kBuffered[GpuSamples::kTypes] = {
+        { 1, 1.0f },     // NVML_GPU_UTILIZATION_SAMPLES, %
+        { 0, 0.001f },   // NVML_TOTAL_POWER_SAMPLES, mW
+        { 5, 1.0f },     // NVML_PROCESSOR_CLK_SAMPLES, MHz
+    };
+}
+
+bool GpuSamples::Probe(nvmlDeviceGetSamples_t getSamples, void* device, size_t type) {
+    if (!getSamples || !device || type >= kTypes) return false;
+
+    // Without a buffer the call only reports how many samples it would return
+    int valueType = 0;
+    unsigned int count = 0;
+    int result = getSamples(device, kBuffered[type].samplingType, 0, &valueType, &count, nullptr);
+    return result == 0 || result == NVML_ERROR_NOT_FOUND;
+}
+
+// One call per type and tick returns everything the driver sampled since
+// the newest sample seen, each reading keeping its own timestamp
+void GpuSamples::Read(nvmlDeviceGetSamples_t getSamples, void* device, size_t type, uint16_t sensor,
+    unsigned long long& lastSeen, std::vector<unsigned char>& buffer, int64_t wallToSteady,
+    std::vector<SensorReading>& readings) {
+    if (!getSamples || !device || type >= kTypes) return;
+
+    int valueType = 0;
+    unsigned int count = 0;
+    if (getSamples(device, kBuffered[type].samplingType, lastSeen, &valueType, &count, nullptr) != 0 ||
+        count == 0) {
+        return;
+    }
+
+    // The buffer is sized once for the driver's maximum and kept
+    size_t needed = count * sizeof(nvmlSample_t);
+    if (buffer.size() < needed) {
+        buffer.resize(needed);
+    }
+
+    auto samples = (nvmlSample_t*)buffer.data();
+    if (getSamples(device, kBuffered[type].samplingType, lastSeen, &valueType, &count, samples) != 0) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+        const nvmlSample_t& sample = samples[i];
+        if (sample.timeStamp <= lastSeen) continue;
+        lastSeen = sample.timeStamp;
+
+        double value;
+        switch (valueType) {
+        case NVML_VALUE_TYPE_DOUBLE: value = sample.sampleValue.dVal; break;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG: value = (double)sample.sampleValue.ulVal; break;
+        case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG: value = (double)sample.sampleValue.ullVal; break;
+        case NVML_VALUE_TYPE_SIGNED_LONG_LONG: value = (double)sample.sampleValue.sllVal; break;
+        default: value = sample.sampleValue.uiVal; break;
+        }
+
+        int64_t timestamp = (int64_t)(sample.timeStamp / 1000) + wallToSteady;
+        readings.push_back({ sensor, (float)(value * kBuffered[type].scale), timestamp });
+    }
+}
+
+void GpuSamples::Split(const SensorSnapshot& snapshot, std::vector<SensorReading>& readings,
+    int64_t steadyToWall, std::vector<SensorSnapshot>& between) {
+    between.clear();
+    std::stable_sort(readings.begin(), readings.end(),
+        [](const SensorReading& a, const SensorReading& b) { return a.timestamp < b.timestamp; });
+
+    int64_t bucket = 0;
+    for (const auto& reading : readings) {
+        if (reading.sensor >= snapshot.count || !snapshot.valid[reading.sensor] ||
+            reading.timestamp >= snapshot.timestamps[reading.sensor]) {
+            continue;
+        }
+
+        int64_t readingBucket = reading.timestamp / kBucket;
+        if (between.empty() || readingBucket != bucket) {
+            between.emplace_back();
+            between.back().Clear(snapshot.count);
+            between.back().partial = true;
+            bucket = readingBucket;
+        }
+        SensorSnapshot& partial = between.back();
+        partial.Set(reading.sensor, reading.value, reading.timestamp);
+        partial.time = reading.timestamp + steadyToWall;
+    }
+}
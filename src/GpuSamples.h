@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ReadPool.h"
+#include "Sensor.h"
+
+// nvmlDeviceGetSamples and what it fills in, as declared by nvml.h
+union nvmlValue_t {
+    double dVal;
+    unsigned int uiVal;
+    unsigned long ulVal;
+    unsigned long long ullVal;
+    signed long long sllVal;
+};
+
+struct nvmlSample_t {
+    unsigned long long timeStamp;   // us since epoch
+    nvmlValue_t sampleValue;
+};
+typedef int (*nvmlDeviceGetSamples_t)(void*, int, unsigned long long, int*, unsigned int*, nvmlSample_t*);
+
+// Samples the GPU driver keeps in its own buffer. Kept apart from the rest
+// of the NVML code so it can be driven by a stub nvmlDeviceGetSamples.
+namespace GpuSamples {
+    constexpr int64_t kBucket = 100;   // ms per partial snapshot
+    constexpr size_t kTypes = 3;       // utilisation, power, SM clock
+
+    // Whether the driver keeps a buffer of the type, in the order above
+    bool Probe(nvmlDeviceGetSamples_t getSamples, void* device, size_t type);
+
+    // Appends every sample newer than lastSeen (us since epoch) as a reading
+    // of sensor, in the sensor's unit, and advances lastSeen. Driver
+    // timestamps are wall clock; wallToSteady moves them to SteadyNow().
+    // buffer is grown to the driver's count once and kept across calls.
+    void Read(nvmlDeviceGetSamples_t getSamples, void* device, size_t type, uint16_t sensor,
+        unsigned long long& lastSeen, std::vector<unsigned char>& buffer, int64_t wallToSteady,
+        std::vector<SensorReading>& readings);
+
+    // Readings older than their sensor's value in the snapshot came out of
+    // a driver buffer; they are sorted and grouped into partial snapshots,
+    // one per kBucket ms, stamped with wall-clock time via steadyToWall
+    void Split(const SensorSnapshot& snapshot, std::vector<SensorReading>& readings,
+        int64_t steadyToWall, std::vector<SensorSnapshot>& between);
+}
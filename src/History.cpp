@@ -0,0 +1,394 @@
+#include "History.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+std::wstring HistoryFormat::SegmentFileName(int64_t startTime, int64_t endTime, unsigned sequence) {
+    std::wstring name = L"seg_" + std::to_wstring(startTime) + L"_" + std::to_wstring(endTime);
+    if (sequence > 0) name += L"_" + std::to_wstring(sequence);
+    return name + L".tmh";
+}
+
+bool HistoryFormat::ParseSegmentFileName(const std::wstring& fileName, int64_t& startTime, int64_t& endTime) {
+    const std::wstring prefix = L"seg_";
+    const std::wstring suffix = L".tmh";
+    if (fileName.size() <= prefix.size() + suffix.size() ||
+        fileName.compare(0, prefix.size(), prefix) != 0 ||
+        fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return false;
+    }
+
+    std::wstring body = fileName.substr(prefix.size(), fileName.size() - prefix.size() - suffix.size());
+    size_t sep = body.find(L'_');
+    if (sep == std::wstring::npos) return false;
+    size_t sequence = body.find(L'_', sep + 1);
+
+    try {
+        size_t used = 0;
+        startTime = std::stoll(body.substr(0, sep), &used);
+        if (used != sep) return false;
+        std::wstring end = body.substr(sep + 1, sequence == std::wstring::npos ? std::wstring::npos : sequence - sep - 1);
+        endTime = std::stoll(end, &used);
+        if (used != end.size()) return false;
+        if (sequence != std::wstring::npos) {
+            std::wstring number = body.substr(sequence + 1);
+            std::stoul(number, &used);
+            if (used != number.size()) return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    return startTime <= endTime;
+}
+
+namespace {
+    struct JournalHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t channelCount;
+    };
+
+    void WriteChannelNames(std::ofstream& out, const std::vector<std::string>& channels) {
+        for (const auto& name : channels) {
+            char buffer[HistoryFormat::kChannelNameSize] = {};
+            strncpy(buffer, name.c_str(), HistoryFormat::kChannelNameSize - 1);
+            out.write(buffer, HistoryFormat::kChannelNameSize);
+        }
+    }
+}
+
+History::History(const std::wstring& dir, const std::vector<std::string>& chans)
+    : directory(dir), channels(chans), columns(chans.size()), lastJournalFlush(0) {
+    std::error_code ec;
+    fs::create_directories(fs::path(directory), ec);
+
+    // A journal that could not be turned into a segment is left alone for
+    // the next run; rows are then only kept in memory until they are written
+    if (RecoverJournal()) {
+        OpenJournal();
+    }
+}
+
+History::~History() {
+    if (Flush() && journal.is_open()) {
+        journal.close();
+        std::error_code ec;
+        fs::remove(fs::path(directory) / HistoryFormat::kJournalFileName, ec);
+    }
+}
+
+bool History::OpenJournal() {
+    journal.close();
+    journal.clear();
+    journal.open(fs::path(directory) / HistoryFormat::kJournalFileName, std::ios::binary | std::ios::trunc);
+    if (!journal) return false;
+
+    JournalHeader header = { HistoryFormat::kJournalMagic, HistoryFormat::kVersion, (uint16_t)channels.size() };
+    journal.write((const char*)&header, sizeof(header));
+    WriteChannelNames(journal, channels);
+    journal.flush();
+    return journal.good();
+}
+
+// A journal left behind by a crash holds the rows of the segment that was
+// open; it keeps its own channel list in case the sensors changed since.
+// Returns false while those rows are not safely in a segment, so the
+// journal must not be truncated yet.
+bool History::RecoverJournal() {
+    using namespace HistoryFormat;
+
+    fs::path path = fs::path(directory) / kJournalFileName;
+    std::ifstream in(path, std::ios::binary);
+    JournalHeader header;
+    if (!in || !in.read((char*)&header, sizeof(header)) ||
+        header.magic != kJournalMagic || header.version != kVersion) {
+        return true;
+    }
+
+    std::vector<std::string> names(header.channelCount);
+    for (auto& name : names) {
+        char buffer[kChannelNameSize];
+        if (!in.read(buffer, kChannelNameSize)) return true;
+        buffer[kChannelNameSize - 1] = '\0';
+        name = buffer;
+    }
+
+    // A row cut short by the crash is dropped
+    std::vector<int64_t> times;
+    std::vector<std::vector<float>> values(names.size());
+    std::vector<float> row(names.size());
+    int64_t timestamp;
+    while (in.read((char*)&timestamp, sizeof(timestamp)) &&
+        in.read((char*)row.data(), row.size() * sizeof(float))) {
+        times.push_back(timestamp);
+        for (size_t c = 0; c < names.size(); c++) {
+            values[c].push_back(row[c]);
+        }
+    }
+    in.close();
+
+    return times.empty() || WriteSegment(directory, names, times, values);
+}
+
+int64_t History::Now() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void History::Append(int64_t timestamp, const float* values) {
+    // Segments cover a fixed span of time whatever the sample rate
+    if (!timestamps.empty() && timestamp - timestamps.front() >= HistoryFormat::kSegmentDuration) {
+        Flush();
+    }
+
+    timestamps.push_back(timestamp);
+    for (size_t c = 0; c < columns.size(); c++) {
+        columns[c].push_back(values[c]);
+    }
+
+    if (journal.is_open()) {
+        journal.write((const char*)&timestamp, sizeof(timestamp));
+        journal.write((const char*)values, columns.size() * sizeof(float));
+        if (timestamp - lastJournalFlush >= HistoryFormat::kFlushInterval || timestamp < lastJournalFlush) {
+            journal.flush();
+            lastJournalFlush = timestamp;
+        }
+    }
+
+    if (timestamps.size() >= HistoryFormat::kSegmentSamples) {
+        Flush();
+    }
+}
+
+bool History::Flush() {
+    if (timestamps.empty()) return true;
+
+    bool ok = WriteSegment(directory, channels, timestamps, columns);
+    if (!ok) return false;
+
+    timestamps.clear();
+    for (auto& column : columns) {
+        column.clear();
+    }
+
+    // The rows are in the segment now; a crash from here on must not
+    // recover them a second time. A journal left from an earlier run is
+    // only replaced once its own rows are written too.
+    if (journal.is_open() || RecoverJournal()) {
+        OpenJournal();
+    }
+    return true;
+}
+
+bool History::WriteSegment(const std::wstring& directory, const std::vector<std::string>& channels,
+    const std::vector<int64_t>& timestamps, const std::vector<std::vector<float>>& columns) {
+    using namespace HistoryFormat;
+
+    // Buffered samples from a late read arrive after newer rows; readers
+    // rely on each segment being in time order
+    if (!std::is_sorted(timestamps.begin(), timestamps.end())) {
+        std::vector<size_t> order(timestamps.size());
+        std::iota(order.begin(), order.end(), (size_t)0);
+        std::stable_sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return timestamps[a] < timestamps[b]; });
+
+        std::vector<int64_t> sortedTimes(order.size());
+        std::vector<std::vector<float>> sortedColumns(columns.size(), std::vector<float>(order.size()));
+        for (size_t i = 0; i < order.size(); i++) {
+            sortedTimes[i] = timestamps[order[i]];
+            for (size_t c = 0; c < columns.size(); c++) {
+                sortedColumns[c][i] = columns[c][order[i]];
+            }
+        }
+        return WriteSegment(directory, channels, sortedTimes, sortedColumns);
+    }
+
+    const uint32_t sampleCount = (uint32_t)timestamps.size();
+    const uint32_t blockCount = (sampleCount + kBlockSamples - 1) / kBlockSamples;
+
+    SegmentHeader header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.channelCount = (uint16_t)channels.size();
+    header.sampleCount = sampleCount;
+    header.blockCount = blockCount;
+    header.startTime = timestamps.front();
+    header.endTime = timestamps.back();
+
+    // Summaries are stored block-major: all channels of block 0, then block 1...
+    std::vector<BlockSummary> summaries(blockCount * channels.size());
+    for (uint32_t b = 0; b < blockCount; b++) {
+        uint32_t first = b * kBlockSamples;
+        uint32_t last = (first + kBlockSamples < sampleCount) ? first + kBlockSamples : sampleCount;
+
+        for (size_t c = 0; c < channels.size(); c++) {
+            BlockSummary& s = summaries[b * channels.size() + c];
+            s.startTime = timestamps[first];
+            s.endTime = timestamps[last - 1];
+            s.minValue = NAN;
+            s.maxValue = NAN;
+            for (uint32_t i = first; i < last; i++) {
+                float v = columns[c][i];
+                if (std::isnan(v)) continue;
+                if (s.count == 0 || v < s.minValue) s.minValue = v;
+                if (s.count == 0 || v > s.maxValue) s.maxValue = v;
+                s.sum += v;
+                s.count++;
+            }
+        }
+    }
+
+    // Readers only list finished names, so they never open a half-written
+    // segment. Another segment with the same range is never replaced.
+    std::error_code ec;
+    fs::path path = fs::path(directory) / SegmentFileName(header.startTime, header.endTime);
+    for (unsigned sequence = 1; fs::exists(path, ec); sequence++) {
+        path = fs::path(directory) / SegmentFileName(header.startTime, header.endTime, sequence);
+    }
+    fs::path temporary = path;
+    temporary += L".tmp";
+
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    out.write((const char*)&header, sizeof(header));
+    WriteChannelNames(out, channels);
+    out.write((const char*)summaries.data(), summaries.size() * sizeof(BlockSummary));
+    out.write((const char*)timestamps.data(), sampleCount * sizeof(int64_t));
+    for (const auto& column : columns) {
+        out.write((const char*)column.data(), sampleCount * sizeof(float));
+    }
+
+    out.close();
+
+    if (!out.fail()) {
+        fs::rename(temporary, path, ec);
+        if (!ec) return true;
+    }
+    fs::remove(temporary, ec);
+    return false;
+}
+
+bool History::AppendEvent(int64_t timestamp, const std::string& text) {
+    std::ofstream out(fs::path(directory) / L"events.log", std::ios::binary | std::ios::app);
+    if (!out) return false;
+
+    out << timestamp << '\t' << text << "\r\n";
+    return out.good();
+}
+
+HistoryReader::HistoryReader()
+    : startTime(0), endTime(0), segmentIndex(0), row(0) {
+}
+
+bool HistoryReader::Open(const std::wstring& dir, const std::vector<std::string>& chans,
+    int64_t start, int64_t end) {
+    channels = chans;
+    startTime = start;
+    endTime = end;
+    segmentIndex = 0;
+    row = 0;
+    segments.clear();
+    timestamps.clear();
+
+    std::vector<std::pair<int64_t, std::wstring>> found;
+    std::error_code ec;
+    for (fs::directory_iterator it(fs::path(dir), ec), last; !ec && it != last; it.increment(ec)) {
+        int64_t segStart, segEnd;
+        if (!HistoryFormat::ParseSegmentFileName(it->path().filename().wstring(), segStart, segEnd)) {
+            continue;
+        }
+        if (segEnd < startTime || segStart >= endTime) continue;
+        found.emplace_back(segStart, it->path().wstring());
+    }
+
+    std::sort(found.begin(), found.end());
+    for (auto& f : found) {
+        segments.push_back(f.second);
+    }
+    return !segments.empty();
+}
+
+bool HistoryReader::ReadHeader(std::ifstream& in, HistoryFormat::SegmentHeader& header,
+    std::vector<std::string>& names) {
+    using namespace HistoryFormat;
+
+    if (!in || !in.read((char*)&header, sizeof(header)) ||
+        header.magic != kMagic || header.version != kVersion) {
+        return false;
+    }
+
+    names.resize(header.channelCount);
+    for (auto& name : names) {
+        char buffer[kChannelNameSize];
+        if (!in.read(buffer, kChannelNameSize)) return false;
+        buffer[kChannelNameSize - 1] = '\0';
+        name = buffer;
+    }
+    return true;
+}
+
+bool HistoryReader::GetStoredChannels(std::vector<std::string>& names) {
+    if (segments.empty()) return false;
+
+    std::ifstream in(fs::path(segments.front()), std::ios::binary);
+    HistoryFormat::SegmentHeader header;
+    return ReadHeader(in, header, names);
+}
+
+bool HistoryReader::LoadSegment(const std::wstring& path) {
+    using namespace HistoryFormat;
+
+    std::ifstream in(fs::path(path), std::ios::binary);
+    SegmentHeader header;
+    std::vector<std::string> names;
+    if (!ReadHeader(in, header, names)) return false;
+
+    in.seekg((std::streamoff)header.blockCount * header.channelCount * sizeof(BlockSummary), std::ios::cur);
+
+    timestamps.resize(header.sampleCount);
+    if (!in.read((char*)timestamps.data(), header.sampleCount * sizeof(int64_t))) return false;
+
+    std::vector<std::vector<float>> stored(header.channelCount, std::vector<float>(header.sampleCount));
+    for (auto& column : stored) {
+        if (!in.read((char*)column.data(), header.sampleCount * sizeof(float))) return false;
+    }
+
+    columns.assign(channels.size(), std::vector<float>(header.sampleCount, NAN));
+    for (size_t c = 0; c < channels.size(); c++) {
+        auto it = std::find(names.begin(), names.end(), channels[c]);
+        if (it != names.end()) {
+            columns[c].swap(stored[it - names.begin()]);
+        }
+    }
+    row = 0;
+    return true;
+}
+
+bool HistoryReader::Next(int64_t& timestamp, float* values) {
+    for (;;) {
+        while (row < timestamps.size()) {
+            size_t r = row++;
+            if (timestamps[r] < startTime) continue;
+            if (timestamps[r] >= endTime) return false;
+
+            timestamp = timestamps[r];
+            for (size_t c = 0; c < columns.size(); c++) {
+                values[c] = columns[c][r];
+            }
+            return true;
+        }
+
+        timestamps.clear();
+        if (segmentIndex >= segments.size()) return false;
+        if (!LoadSegment(segments[segmentIndex++])) {
+            timestamps.clear();
+        }
+    }
+}
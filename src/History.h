@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// On-disk layout of a history segment. A segment covers up to
+// kSegmentDuration, or kSegmentSamples rows at high sample rates, stored
+// column by column in time order, preceded by one summary per block of
+// kBlockSamples samples so readers can skip data they do not need.
+namespace HistoryFormat {
+    const uint32_t kMagic = 0x53484D54;  // "TMHS"
+    const uint32_t kJournalMagic = 0x4A484D54;  // "TMHJ"
+    const uint16_t kVersion = 1;
+    const uint32_t kBlockSamples = 256;
+    const int64_t kSegmentDuration = 3600 * 1000;  // ms
+    const uint32_t kSegmentSamples = 65536;  // an hour of 100 ms buffered GPU rows, with room
+    const size_t kChannelNameSize = 16;
+    const int64_t kFlushInterval = 10000;  // ms between journal flushes
+
+    struct SegmentHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t channelCount;
+        uint32_t sampleCount;
+        uint32_t blockCount;
+        int64_t startTime;
+        int64_t endTime;
+    };
+
+    // One per block and channel. min/max/sum/count only cover valid samples.
+    struct BlockSummary {
+        int64_t startTime;
+        int64_t endTime;
+        float minValue;
+        float maxValue;
+        double sum;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    // Segment files are named seg_<startTime>_<endTime>.tmh so a reader can
+    // prune by time range without opening them. A segment whose range is
+    // already taken gets seg_<startTime>_<endTime>_<sequence>.tmh.
+    std::wstring SegmentFileName(int64_t startTime, int64_t endTime, unsigned sequence = 0);
+    bool ParseSegmentFileName(const std::wstring& fileName, int64_t& startTime, int64_t& endTime);
+
+    // Rows of the open segment, appended as they arrive: a header with the
+    // channel names, then (timestamp, values) rows. Never matches a segment name.
+    const wchar_t* const kJournalFileName = L"journal.tmj";
+}
+
+// Appends timestamped samples to columnar segment files.
+// Timestamps are milliseconds since the Unix epoch; invalid readings are NaN.
+// Rows may arrive slightly out of order and are sorted when written.
+// Rows also go to a journal flushed every kFlushInterval, so a crash loses
+// at most that much; the next History on the directory turns the journal
+// into a segment. Segments are written under a temporary name and renamed,
+// so readers never see a partial file.
+class History {
+public:
+    History(const std::wstring& directory, const std::vector<std::string>& channels);
+    ~History();
+
+    void Append(int64_t timestamp, const float* values);
+
+    // Writes the open rows as a segment and starts a new journal
+    bool Flush();
+
+    // Appends a UTF-8 line to events.log next to the segments
+    bool AppendEvent(int64_t timestamp, const std::string& text);
+
+    const std::wstring& GetDirectory() const { return directory; }
+    const std::vector<std::string>& GetChannels() const { return channels; }
+
+    static int64_t Now();
+
+private:
+    std::wstring directory;
+    std::vector<std::string> channels;
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<float>> columns;
+    std::ofstream journal;
+    int64_t lastJournalFlush;
+
+    bool OpenJournal();
+    bool RecoverJournal();
+    static bool WriteSegment(const std::wstring& directory, const std::vector<std::string>& channels,
+        const std::vector<int64_t>& timestamps, const std::vector<std::vector<float>>& columns);
+};
+
+// Reads recorded samples back in time order, one row at a time.
+class HistoryReader {
+public:
+    HistoryReader();
+
+    // Selects the segments overlapping [startTime, endTime) and the
+    // channels to return. Unknown channels read as NaN.
+    bool Open(const std::wstring& directory, const std::vector<std::string>& channels,
+        int64_t startTime, int64_t endTime);
+    bool Next(int64_t& timestamp, float* values);
+
+    // Channels stored in the first selected segment
+    bool GetStoredChannels(std::vector<std::string>& names);
+
+private:
+    std::vector<std::wstring> segments;
+    std::vector<std::string> channels;
+    int64_t startTime;
+    int64_t endTime;
+    size_t segmentIndex;
+    size_t row;
+    std::vector<int64_t> timestamps;
+    std::vector<std::vector<float>> columns;
+
+    bool LoadSegment(const std::wstring& path);
+    static bool ReadHeader(std::ifstream& in, HistoryFormat::SegmentHeader& header,
+        std::vector<std::string>& names);
+};
@@ -0,0 +1,142 @@
+#include "HwmonSensors.h"
+#include "History.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // hwmon drivers and thermal zone types that report the CPU's own temperatures
+    const char* const kCpuDrivers[] = { "coretemp", "k10temp", "zenpower", "acpitz", "cpu_thermal" };
+    const char* const kCpuZones[] = { "x86_pkg_temp", "acpitz", "cpu-thermal", "cpu_thermal" };
+    const char* const kGpuDrivers[] = { "amdgpu", "radeon", "nouveau", "i915" };
+    const char* const kStorageDrivers[] = { "nvme", "drivetemp" };
+
+    template <size_t N>
+    bool Contains(const char* const (&names)[N], const std::string& name) {
+        return std::find(std::begin(names), std::end(names), name) != std::end(names);
+    }
+
+    bool EndsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    std::string ReadLine(const fs::path& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    std::vector<fs::path> ListDirectory(const fs::path& root) {
+        std::error_code ec;
+        std::vector<fs::path> entries;
+        for (fs::directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+            entries.push_back(it->path());
+        }
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+
+    SensorKind KindOf(const HwmonInput& input) {
+        if (input.cpu) {
+            if (input.label.compare(0, 7, "Package") == 0 || input.label == "Tctl" || input.device == "x86_pkg_temp") {
+                return SensorKind::CpuPackage;
+            }
+            if (input.label.compare(0, 4, "Core") == 0) return SensorKind::CpuCore;
+            return SensorKind::ThermalZone;
+        }
+        if (Contains(kGpuDrivers, input.device)) return SensorKind::Gpu;
+        if (Contains(kStorageDrivers, input.device)) return SensorKind::Storage;
+        return SensorKind::Other;
+    }
+
+    const char* KeyPrefix(SensorKind kind) {
+        switch (kind) {
+        case SensorKind::ThermalZone:
+        case SensorKind::CpuPackage: return "cpu";
+        case SensorKind::CpuCore: return "core";
+        case SensorKind::Gpu: return "gpu";
+        case SensorKind::Storage: return "disk";
+        default: return "temp";
+        }
+    }
+}
+
+std::vector<HwmonInput> FindHwmonInputs(const std::string& hwmonRoot, const std::string& thermalRoot) {
+    std::vector<HwmonInput> inputs;
+    for (const auto& device : ListDirectory(hwmonRoot)) {
+        std::string name = ReadLine(device / "name");
+        for (const auto& path : ListDirectory(device)) {
+            std::string file = path.filename().string();
+            if (file.compare(0, 4, "temp") != 0 || !EndsWith(file, "_input")) continue;
+
+            std::string stem = file.substr(0, file.size() - 6);
+            inputs.push_back({ path.string(), name, ReadLine(device / (stem + "_label")),
+                Contains(kCpuDrivers, name), -1 });
+        }
+    }
+
+    for (const auto& zone : ListDirectory(thermalRoot)) {
+        std::string file = zone.filename().string();
+        if (file.compare(0, 12, "thermal_zone") != 0 || !fs::exists(zone / "temp")) continue;
+
+        std::string type = ReadLine(zone / "type");
+        inputs.push_back({ (zone / "temp").string(), type, "", Contains(kCpuZones, type), atoi(file.c_str() + 12) });
+    }
+    return inputs;
+}
+
+std::vector<std::string> FindHwmonAlarms(const std::string& hwmonRoot) {
+    std::vector<std::string> alarms;
+    for (const auto& device : ListDirectory(hwmonRoot)) {
+        if (!Contains(kCpuDrivers, ReadLine(device / "name"))) continue;
+        for (const auto& path : ListDirectory(device)) {
+            if (EndsWith(path.filename().string(), "_alarm")) alarms.push_back(path.string());
+        }
+    }
+    return alarms;
+}
+
+HwmonReader::HwmonReader() {
+}
+
+HwmonReader::~HwmonReader() {
+    for (int fd : files) close(fd);
+}
+
+bool HwmonReader::Initialize(const std::string& hwmonRoot, const std::string& thermalRoot) {
+    for (const auto& input : FindHwmonInputs(hwmonRoot, thermalRoot)) {
+        int fd = open(input.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+
+        SensorKind kind = KindOf(input);
+        std::string label = input.label.empty() ? input.device : input.device + " " + input.label;
+        int id = registry.Register(kind, SensorUnit::Celsius, registry.MakeKey(KeyPrefix(kind)), label);
+        if (id < 0) {
+            close(fd);
+            break;
+        }
+        files.push_back(fd);
+        sensors.push_back(id);
+    }
+    return !files.empty();
+}
+
+void HwmonReader::Sample(SensorSnapshot& snapshot) {
+    snapshot.Clear((uint32_t)registry.Count());
+    snapshot.time = History::Now();
+
+    // The files stay open; sysfs regenerates their contents on each read
+    char buffer[32];
+    for (size_t i = 0; i < files.size(); i++) {
+        ssize_t size = pread(files[i], buffer, sizeof(buffer) - 1, 0);
+        if (size <= 0) continue;
+        buffer[size] = '\0';
+        snapshot.Set(sensors[i], atoi(buffer) / 1000.0f, SteadyNow());
+    }
+}
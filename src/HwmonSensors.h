@@ -0,0 +1,41 @@
+#pragma once
+#include "Sensor.h"
+#include <string>
+#include <vector>
+
+// A temperature file of an hwmon device or a thermal zone, in millidegrees
+struct HwmonInput {
+    std::string path;     // hwmonN/tempM_input or thermal_zoneN/temp
+    std::string device;   // the hwmon driver's name or the zone's type
+    std::string label;    // tempM_label, empty when there is none
+    bool cpu;             // the driver or zone reports the CPU's own temperature
+    int zone;             // the thermal zone's number, -1 for hwmon
+};
+
+// Every temperature input under the hwmon and thermal class directories,
+// hwmon first and in path order
+std::vector<HwmonInput> FindHwmonInputs(const std::string& hwmonRoot, const std::string& thermalRoot);
+
+// The *_alarm files of the CPU hwmon devices
+std::vector<std::string> FindHwmonAlarms(const std::string& hwmonRoot);
+
+// Reads every hwmon and thermal zone temperature as a sensor, where
+// TempMonitor's WMI and NVML sources don't exist
+class HwmonReader {
+public:
+    HwmonReader();
+    ~HwmonReader();
+
+    // False when no temperature input can be opened
+    bool Initialize(const std::string& hwmonRoot = "/sys/class/hwmon",
+        const std::string& thermalRoot = "/sys/class/thermal");
+
+    const SensorRegistry& GetRegistry() const { return registry; }
+
+    void Sample(SensorSnapshot& snapshot);
+
+private:
+    SensorRegistry registry;
+    std::vector<int> files;
+    std::vector<int> sensors;   // registry id of each file
+};
@@ -0,0 +1,101 @@
+#include "IconRasterizer.h"
+
+namespace {
+    // Rows of each glyph, three bits per row with the leftmost pixel in bit 2.
+    // 0-9 are the digits, 10 is the minus sign.
+    const uint8_t kGlyphs[11][IconRasterizer::kGlyphHeight] = {
+        { 7, 5, 5, 5, 7 },  // 0
+        { 2, 6, 2, 2, 7 },  // 1
+        { 7, 1, 7, 4, 7 },  // 2
+        { 7, 1, 7, 1, 7 },  // 3
+        { 5, 5, 7, 1, 1 },  // 4
+        { 7, 4, 7, 1, 7 },  // 5
+        { 7, 4, 7, 5, 7 },  // 6
+        { 7, 1, 1, 1, 1 },  // 7
+        { 7, 5, 7, 5, 7 },  // 8
+        { 7, 5, 7, 1, 7 },  // 9
+        { 0, 0, 7, 0, 0 },  // -
+    };
+    const int kMinusGlyph = 10;
+}
+
+uint32_t IconRasterizer::BackgroundColor(TempLevel level) {
+    // Same palette as the floating window, fully opaque
+    switch (level) {
+    case TempLevel::Danger:
+        return 0xFFFF6496;
+    case TempLevel::Warning:
+        return 0xFFFFC864;
+    case TempLevel::Normal:
+    default:
+        return 0xFFFFC0CB;
+    }
+}
+
+void IconRasterizer::DrawGlyph(int glyph, int x, int y, int scale, int size, uint32_t* pixels) {
+    for (int row = 0; row < kGlyphHeight; row++) {
+        for (int col = 0; col < kGlyphWidth; col++) {
+            if (!(kGlyphs[glyph][row] & (4 >> col))) continue;
+
+            for (int dy = 0; dy < scale; dy++) {
+                for (int dx = 0; dx < scale; dx++) {
+                    int px = x + col * scale + dx;
+                    int py = y + row * scale + dy;
+                    if (px >= 0 && px < size && py >= 0 && py < size) {
+                        pixels[py * size + px] = kTextColor;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void IconRasterizer::Render(int value, TempLevel level, int size, uint32_t* pixels) {
+    // Background with the four corner pixels cut for a rounded look
+    uint32_t background = BackgroundColor(level);
+    for (int i = 0; i < size * size; i++) {
+        pixels[i] = background;
+    }
+    if (size >= 8) {
+        pixels[0] = 0;
+        pixels[size - 1] = 0;
+        pixels[(size - 1) * size] = 0;
+        pixels[size * size - 1] = 0;
+    }
+
+    int glyphs[3];
+    int count = 0;
+    if (value < 0 || value > 999) {
+        glyphs[0] = kMinusGlyph;
+        glyphs[1] = kMinusGlyph;
+        count = 2;
+    } else if (value >= 100) {
+        glyphs[0] = value / 100;
+        glyphs[1] = (value / 10) % 10;
+        glyphs[2] = value % 10;
+        count = 3;
+    } else if (value >= 10) {
+        glyphs[0] = value / 10;
+        glyphs[1] = value % 10;
+        count = 2;
+    } else {
+        glyphs[0] = value;
+        count = 1;
+    }
+
+    // Largest integer scale that fits, with one scaled pixel between glyphs
+    int unitsWide = count * kGlyphWidth + (count - 1);
+    int scale = size / unitsWide;
+    if (size / kGlyphHeight < scale) scale = size / kGlyphHeight;
+    if (scale < 1) scale = 1;
+
+    int width = unitsWide * scale;
+    int height = kGlyphHeight * scale;
+    int x = (size - width) / 2;
+    int y = (size - height) / 2;
+
+    for (int i = 0; i < count; i++) {
+        DrawGlyph(glyphs[i], x, y, scale, size, pixels);
+        x += (kGlyphWidth + 1) * scale;
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include "Sensor.h"
+
+// Draws the tray icon: an integer temperature on a background coloured by
+// level, using a built-in 3x5 digit atlas scaled to the icon size. Pure
+// pixel math with no GDI calls, so output is identical on every platform.
+class IconRasterizer {
+public:
+    // pixels receives size * size top-down ARGB values (0xAARRGGBB).
+    // Values outside 0-999 render as "--".
+    static void Render(int value, TempLevel level, int size, uint32_t* pixels);
+
+    static uint32_t BackgroundColor(TempLevel level);
+
+    static const uint32_t kTextColor = 0xFF000000;
+    static const int kGlyphWidth = 3;
+    static const int kGlyphHeight = 5;
+
+private:
+    static void DrawGlyph(int glyph, int x, int y, int scale, int size, uint32_t* pixels);
+};
@@ -0,0 +1,429 @@
+#include "LiveStream.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    typedef WSAPOLLFD PollFd;
+    const short kReadable = POLLRDNORM;
+    const short kWritable = POLLWRNORM;
+    const int kSendFlags = 0;
+
+    bool StartSockets() {
+        WSADATA wsaData;
+        return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    }
+
+    void StopSockets() {
+        WSACleanup();
+    }
+
+    void CloseSocket(SOCKET s) {
+        closesocket(s);
+    }
+
+    bool SetNonBlocking(SOCKET s) {
+        u_long nonBlocking = 1;
+        return ioctlsocket(s, FIONBIO, &nonBlocking) != SOCKET_ERROR;
+    }
+
+    bool WouldBlock() {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    int PollSockets(PollFd* fds, size_t count, int timeoutMs) {
+        return WSAPoll(fds, (ULONG)count, timeoutMs);
+    }
+#else
+    typedef int SOCKET;
+    typedef pollfd PollFd;
+    const SOCKET INVALID_SOCKET = -1;
+    const int SOCKET_ERROR = -1;
+    const short kReadable = POLLIN;
+    const short kWritable = POLLOUT;
+    const int kSendFlags = MSG_NOSIGNAL;   // a closed client must not raise SIGPIPE
+
+    bool StartSockets() {
+        return true;
+    }
+
+    void StopSockets() {
+    }
+
+    void CloseSocket(SOCKET s) {
+        close(s);
+    }
+
+    bool SetNonBlocking(SOCKET s) {
+        int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+
+    bool WouldBlock() {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    int PollSockets(PollFd* fds, size_t count, int timeoutMs) {
+        return poll(fds, (nfds_t)count, timeoutMs);
+    }
+#endif
+
+    const char kNotFound[] =
+        "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+
+    const size_t kMaxRequestSize = 4096;
+
+    std::string JsonString(const char* text) {
+        std::string out = "\"";
+        for (const char* p = text; *p; p++) {
+            unsigned char c = (unsigned char)*p;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += (char)c;
+            }
+        }
+        return out + "\"";
+    }
+
+    const char* UnitName(SensorUnit unit) {
+        switch (unit) {
+        case SensorUnit::Percent: return "%";
+        case SensorUnit::Rpm: return "rpm";
+        case SensorUnit::Watt: return "W";
+        case SensorUnit::Megahertz: return "MHz";
+        default: return "C";
+        }
+    }
+
+    void FormatValue(const SensorSnapshot& snapshot, uint32_t i, char* buffer, size_t size) {
+        if (snapshot.valid[i]) {
+            snprintf(buffer, size, "%.1f", snapshot.values[i]);
+        } else {
+            snprintf(buffer, size, "null");
+        }
+    }
+}
+
+LiveStream::LiveStream(SampleBus& b, const SensorRegistry& reg)
+    : bus(b), registry(reg), sink(b.AddSink(SinkPolicy::Conflate)),
+      listenSocket(INVALID_SOCKET), boundPort(0), stopping(false), clientCount(0), droppedClients(0),
+      haveSnapshot(false) {
+    lastSnapshot.Clear(0);
+}
+
+LiveStream::~LiveStream() {
+    Stop();
+}
+
+bool LiveStream::Start(unsigned short port) {
+    // No sink left on the bus means nothing to stream
+    if (sink < 0 || !StartSockets()) return false;
+
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) {
+        StopSockets();
+        return false;
+    }
+
+#ifdef _WIN32
+    BOOL exclusive = TRUE;
+    setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive));
+#else
+    // Lets a restart bind while old connections sit in TIME_WAIT
+    int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    // Loopback only; a reverse proxy can publish it further if needed
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen_t length = sizeof(address);
+    if (bind(s, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(s, SOMAXCONN) == SOCKET_ERROR ||
+        !SetNonBlocking(s) ||
+        getsockname(s, (sockaddr*)&address, &length) == SOCKET_ERROR) {
+        CloseSocket(s);
+        StopSockets();
+        return false;
+    }
+
+    listenSocket = s;
+    boundPort = ntohs(address.sin_port);
+    headerFrame = BuildHeaderFrame();
+    lastText.assign(registry.Count(), std::string());
+    stopping = false;
+    thread = std::thread(&LiveStream::Run, this);
+    return true;
+}
+
+void LiveStream::Stop() {
+    if (!thread.joinable()) return;
+
+    stopping = true;
+    thread.join();
+
+    for (auto& client : clients) {
+        Close(client);
+    }
+    clients.clear();
+    clientCount = 0;
+
+    CloseSocket((SOCKET)listenSocket);
+    listenSocket = INVALID_SOCKET;
+    StopSockets();
+}
+
+LiveStream::Frame LiveStream::BuildHeaderFrame() const {
+    std::string frame =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n"
+        "retry: 2000\n"
+        "event: sensors\n"
+        "data: [";
+
+    for (size_t i = 0; i < registry.Count(); i++) {
+        const SensorInfo& info = registry.Get(i);
+        if (i > 0) frame += ",";
+        frame += "{\"key\":" + JsonString(info.key) +
+            ",\"label\":" + JsonString(info.label) +
+            ",\"unit\":" + JsonString(UnitName(info.unit)) + "}";
+    }
+    frame += "]\n\n";
+    return std::make_shared<const std::string>(std::move(frame));
+}
+
+LiveStream::Frame LiveStream::BuildFullFrame() const {
+    std::string frame = "data: {\"full\":true,\"t\":" + std::to_string(lastSnapshot.time) + ",\"v\":{";
+
+    char value[32];
+    for (uint32_t i = 0; i < lastSnapshot.count && i < registry.Count(); i++) {
+        FormatValue(lastSnapshot, i, value, sizeof(value));
+        if (i > 0) frame += ",";
+        frame += JsonString(registry.Get(i).key) + ":" + value;
+    }
+    frame += "}}\n\n";
+    return std::make_shared<const std::string>(std::move(frame));
+}
+
+void LiveStream::Publish(const SensorSnapshot& snapshot) {
+    // Only sensors whose displayed value changed go into the delta
+    std::string values;
+    char value[32];
+    for (uint32_t i = 0; i < snapshot.count && i < lastText.size(); i++) {
+        FormatValue(snapshot, i, value, sizeof(value));
+        if (lastText[i] == value) continue;
+
+        lastText[i] = value;
+        if (!values.empty()) values += ",";
+        values += JsonString(registry.Get(i).key) + ":" + value;
+    }
+
+    lastSnapshot = snapshot;
+    haveSnapshot = true;
+    fullFrame.reset();
+
+    Frame delta;
+    if (!values.empty()) {
+        delta = std::make_shared<const std::string>(
+            "data: {\"t\":" + std::to_string(snapshot.time) + ",\"v\":{" + values + "}}\n\n");
+    }
+
+    for (auto& client : clients) {
+        if (!client.streaming) continue;
+
+        if (client.needsFull) {
+            // Conflated: one full frame replaces everything it missed
+            if (!fullFrame) fullFrame = BuildFullFrame();
+            client.pending.push_back(fullFrame);
+            client.needsFull = false;
+        } else if (delta) {
+            Enqueue(client, delta);
+        }
+    }
+}
+
+void LiveStream::Enqueue(Client& client, const Frame& frame) {
+    if (client.pending.size() < kMaxPendingFrames) {
+        client.pending.push_back(frame);
+        return;
+    }
+
+    // Too far behind: keep only a partly sent frame so the stream stays
+    // well-formed, and send a full frame on the next tick
+    Frame partial = (client.offset > 0) ? client.pending.front() : Frame();
+    client.pending.clear();
+    if (partial) client.pending.push_back(partial);
+    client.needsFull = true;
+}
+
+void LiveStream::Accept() {
+    for (;;) {
+        SOCKET s = accept((SOCKET)listenSocket, NULL, NULL);
+        if (s == INVALID_SOCKET) return;
+
+        if (clients.size() >= kMaxClients || !SetNonBlocking(s)) {
+            CloseSocket(s);
+            continue;
+        }
+
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+        Client client;
+        client.socket = s;
+        client.streaming = false;
+        client.offset = 0;
+        client.needsFull = false;
+        client.lastProgress = SteadyNow();
+        clients.push_back(std::move(client));
+    }
+}
+
+void LiveStream::ReadRequest(Client& client) {
+    char buffer[1024];
+    int received = (int)recv((SOCKET)client.socket, buffer, sizeof(buffer), 0);
+    if (received == 0 || (received == SOCKET_ERROR && !WouldBlock())) {
+        Close(client);
+        return;
+    }
+    if (received <= 0 || client.streaming) return;   // later input is ignored
+
+    client.request.append(buffer, received);
+    if (client.request.find("\r\n\r\n") == std::string::npos) {
+        if (client.request.size() > kMaxRequestSize) Close(client);
+        return;
+    }
+
+    if (client.request.compare(0, 12, "GET /stream ") != 0 &&
+        client.request.compare(0, 12, "GET /stream?") != 0) {
+        send((SOCKET)client.socket, kNotFound, sizeof(kNotFound) - 1, kSendFlags);
+        Close(client);
+        return;
+    }
+
+    client.request.clear();
+    client.request.shrink_to_fit();
+    client.streaming = true;
+    client.pending.push_back(headerFrame);
+    if (haveSnapshot) {
+        if (!fullFrame) fullFrame = BuildFullFrame();
+        client.pending.push_back(fullFrame);
+    }
+}
+
+bool LiveStream::Flush(Client& client, int64_t now) {
+    while (!client.pending.empty()) {
+        const std::string& frame = *client.pending.front();
+        int sent = (int)send((SOCKET)client.socket, frame.data() + client.offset,
+            (int)(frame.size() - client.offset), kSendFlags);
+        if (sent == SOCKET_ERROR) {
+            if (!WouldBlock()) return false;
+            break;
+        }
+
+        client.lastProgress = now;
+        client.offset += sent;
+        if (client.offset == frame.size()) {
+            client.pending.pop_front();
+            client.offset = 0;
+        }
+    }
+
+    // An idle stream is not stalled; a connection that never sends its
+    // request is
+    if (client.pending.empty() && client.streaming) {
+        client.lastProgress = now;
+    } else if (now - client.lastProgress > kStallTimeout) {
+        droppedClients++;
+        return false;
+    }
+    return true;
+}
+
+void LiveStream::Close(Client& client) {
+    if ((SOCKET)client.socket != INVALID_SOCKET) {
+        CloseSocket((SOCKET)client.socket);
+        client.socket = INVALID_SOCKET;
+    }
+}
+
+void LiveStream::Run() {
+    std::vector<PollFd> fds;
+    SensorSnapshot snapshot;
+
+    while (!stopping) {
+        fds.resize(clients.size() + 1);
+        fds[0].fd = (SOCKET)listenSocket;
+        fds[0].events = kReadable;
+        fds[0].revents = 0;
+        for (size_t i = 0; i < clients.size(); i++) {
+            fds[i + 1].fd = (SOCKET)clients[i].socket;
+            fds[i + 1].events = kReadable | (clients[i].pending.empty() ? 0 : kWritable);
+            fds[i + 1].revents = 0;
+        }
+
+        PollSockets(fds.data(), fds.size(), kPollInterval);
+
+        // Accept appends, so the indices of existing clients stay valid
+        const size_t polled = fds.size() - 1;
+        if (fds[0].revents & kReadable) Accept();
+
+        for (size_t i = 0; i < polled; i++) {
+            short events = fds[i + 1].revents;
+            if (events & (POLLERR | POLLNVAL)) {
+                Close(clients[i]);
+            } else if (events & (kReadable | POLLHUP)) {
+                ReadRequest(clients[i]);
+            }
+        }
+
+        // Dashboards run at tick rate; high-rate samples in between are for history
+        if (bus.Poll(sink, snapshot) && !snapshot.partial) {
+            Publish(snapshot);
+        }
+
+        int64_t now = SteadyNow();
+        for (auto& client : clients) {
+            if ((SOCKET)client.socket != INVALID_SOCKET && !Flush(client, now)) {
+                Close(client);
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < clients.size(); i++) {
+            if ((SOCKET)clients[i].socket == INVALID_SOCKET) continue;
+            if (kept != i) clients[kept] = std::move(clients[i]);
+            kept++;
+        }
+        clients.resize(kept);
+        clientCount = kept;
+    }
+}
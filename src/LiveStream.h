@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SampleBus.h"
+#include "Sensor.h"
+
+// Server-Sent Events endpoint on 127.0.0.1 for live dashboards. Clients
+// GET /stream once; they first receive the sensor list and a full frame,
+// then per tick a frame holding only the sensors whose displayed value
+// changed. Each frame is serialized once and shared by every client. One
+// thread runs a non-blocking poll loop over all sockets (WSAPoll on
+// Windows, poll elsewhere); a client that falls kMaxPendingFrames behind
+// has its queue replaced by a single full frame, and one that makes no
+// progress for kStallTimeout is disconnected.
+class LiveStream {
+public:
+    LiveStream(SampleBus& bus, const SensorRegistry& registry);
+    ~LiveStream();
+
+    // Port 0 binds any free port; GetPort() then tells which
+    bool Start(unsigned short port);
+    void Stop();
+
+    unsigned short GetPort() const { return boundPort; }
+    size_t GetClientCount() const { return clientCount.load(std::memory_order_relaxed); }
+    uint64_t GetDroppedClients() const { return droppedClients.load(std::memory_order_relaxed); }
+
+    static const size_t kMaxClients = 4096;
+    static const size_t kMaxPendingFrames = 16;
+    static const int64_t kStallTimeout = 10000;   // ms
+    static const int kPollInterval = 50;          // ms
+
+private:
+    typedef std::shared_ptr<const std::string> Frame;
+
+    struct Client {
+        uintptr_t socket;
+        bool streaming;           // request read and headers queued
+        std::string request;
+        std::deque<Frame> pending;
+        size_t offset;            // bytes of pending.front() already sent
+        bool needsFull;
+        int64_t lastProgress;
+    };
+
+    SampleBus& bus;
+    const SensorRegistry& registry;
+    int sink;
+
+    uintptr_t listenSocket;
+    unsigned short boundPort;
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> clientCount;
+    std::atomic<uint64_t> droppedClients;
+
+    std::vector<Client> clients;
+    Frame headerFrame;            // HTTP response headers and sensor list
+    Frame fullFrame;              // every sensor at the latest tick
+    bool haveSnapshot;
+    SensorSnapshot lastSnapshot;
+    std::vector<std::string> lastText;   // formatted value per sensor as last sent
+
+    void Run();
+    void Accept();
+    void ReadRequest(Client& client);
+    bool Flush(Client& client, int64_t now);
+    void Publish(const SensorSnapshot& snapshot);
+    void Enqueue(Client& client, const Frame& frame);
+    void Close(Client& client);
+
+    Frame BuildHeaderFrame() const;
+    Frame BuildFullFrame() const;
+};
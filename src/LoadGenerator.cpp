@@ -0,0 +1,222 @@
+#include "LoadGenerator.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SOAK_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SOAK_AVX2
+#else
+#include <cpuid.h>
+#define SOAK_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace {
+    // Sinks for kernel results so the optimizer can't drop the work
+    volatile uint64_t scalarSink;
+    volatile float vectorSink;
+
+    void ScalarUnit(uint64_t& state, double& chain) {
+        for (int i = 0; i < (1 << 16); i++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            state *= 0x9E3779B97F4A7C15ull;
+            chain = chain * 0.9999999 + (double)(state & 0xFF) * 1e-9;
+        }
+    }
+
+#ifdef SOAK_X86
+    SOAK_AVX2 float Avx2Unit(float seed) {
+        __m256 acc[8];
+        for (int k = 0; k < 8; k++) acc[k] = _mm256_set1_ps(seed + k);
+        const __m256 mul = _mm256_set1_ps(0.9999999f);
+        const __m256 add = _mm256_set1_ps(1e-7f);
+
+        // Eight independent chains keep both FMA ports busy every cycle
+        for (int i = 0; i < (1 << 14); i++) {
+            for (int k = 0; k < 8; k++) acc[k] = _mm256_fmadd_ps(acc[k], mul, add);
+        }
+        for (int k = 1; k < 8; k++) acc[0] = _mm256_add_ps(acc[0], acc[k]);
+        return _mm_cvtss_f32(_mm256_castps256_ps128(acc[0]));
+    }
+
+    float SseUnit(float seed) {
+        __m128 acc[8];
+        for (int k = 0; k < 8; k++) acc[k] = _mm_set1_ps(seed + k);
+        const __m128 mul = _mm_set1_ps(0.9999999f);
+        const __m128 add = _mm_set1_ps(1e-7f);
+
+        for (int i = 0; i < (1 << 14); i++) {
+            for (int k = 0; k < 8; k++) acc[k] = _mm_add_ps(_mm_mul_ps(acc[k], mul), add);
+        }
+        for (int k = 1; k < 8; k++) acc[0] = _mm_add_ps(acc[0], acc[k]);
+        return _mm_cvtss_f32(acc[0]);
+    }
+#endif
+
+    // One store per cache line, so the sweep is bound by memory bandwidth
+    void MemoryUnit(uint64_t* buffer, size_t words, size_t& offset) {
+        const size_t kStride = 64 / sizeof(uint64_t);
+        const size_t kUnitWords = (1 << 20) / sizeof(uint64_t);
+        for (size_t i = 0; i < kUnitWords; i += kStride) {
+            buffer[offset] += i;
+            offset += kStride;
+            if (offset >= words) offset = 0;
+        }
+    }
+
+    // The processors workers are pinned to, one per worker
+    std::vector<int> UsableProcessors() {
+        std::vector<int> cpus;
+#ifdef _WIN32
+        // Affinity masks cover one processor group
+        DWORD_PTR process = 0;
+        DWORD_PTR system = 0;
+        if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+            for (int cpu = 0; cpu < (int)(sizeof(DWORD_PTR) * 8); cpu++) {
+                if (process & ((DWORD_PTR)1 << cpu)) cpus.push_back(cpu);
+            }
+        }
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            unsigned count = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned cpu = 0; cpu < count; cpu++) cpus.push_back((int)cpu);
+        }
+        return cpus;
+    }
+
+    void PinThread(int cpu) {
+#ifdef _WIN32
+        SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+#endif
+    }
+
+    void LowerThreadPriority() {
+#ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+        // Linux keeps a nice value per thread; elsewhere it would lower the
+        // whole process, sampler included
+        int result = nice(5);
+        (void)result;
+#endif
+    }
+}
+
+LoadGenerator::LoadGenerator() : running(false), workUnits(0) {
+}
+
+LoadGenerator::~LoadGenerator() {
+    Stop();
+}
+
+bool LoadGenerator::HasAvx2() {
+#ifdef SOAK_X86
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool fma = (regs[2] & (1 << 12)) != 0;
+    if (!osxsave || !fma) return false;
+    // The OS must save the upper halves of the YMM registers
+    if ((_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+#else
+    return false;
+#endif
+}
+
+void LoadGenerator::Start(SoakLoad load, int threads) {
+    Stop();
+
+    std::vector<int> cpus = UsableProcessors();
+    if (threads <= 0) threads = (int)cpus.size();
+
+    // Workers beyond the usable processors float
+    running = true;
+    workUnits = 0;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&LoadGenerator::Run, this, load, i, i < (int)cpus.size() ? cpus[i] : -1);
+    }
+}
+
+void LoadGenerator::Stop() {
+    running = false;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void LoadGenerator::Run(SoakLoad load, int index, int cpu) {
+    if (cpu >= 0) PinThread(cpu);
+    LowerThreadPriority();
+
+    uint64_t state = 0x2545F4914F6CDD1Dull + index;
+    double chain = 1.0;
+    float seed = (float)index;
+#ifdef SOAK_X86
+    bool avx2 = HasAvx2();
+#endif
+
+    std::unique_ptr<uint64_t[]> buffer;
+    size_t words = 0;
+    size_t offset = 0;
+    if (load == SoakLoad::Memory) {
+        words = kMemoryBytes / sizeof(uint64_t);
+        buffer.reset(new uint64_t[words]);
+        memset(buffer.get(), 0, words * sizeof(uint64_t));
+    }
+
+    while (running.load(std::memory_order_relaxed)) {
+        switch (load) {
+        case SoakLoad::Vector:
+#ifdef SOAK_X86
+            seed = avx2 ? Avx2Unit(seed) : SseUnit(seed);
+            break;
+#endif
+        case SoakLoad::Scalar:
+            ScalarUnit(state, chain);
+            break;
+        case SoakLoad::Memory:
+            MemoryUnit(buffer.get(), words, offset);
+            break;
+        }
+        workUnits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    scalarSink = state + (uint64_t)chain;
+    vectorSink = seed;
+}
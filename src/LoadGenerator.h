@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+enum class SoakLoad {
+    Scalar,   // integer and dependent floating-point chains
+    Vector,   // independent 256-bit FMA chains (128-bit without AVX2/FMA)
+    Memory    // read-modify-write sweeps over a buffer larger than the caches
+};
+
+// Keeps one worker per logical processor busy with a synthetic load until
+// stopped. Workers are pinned so every core heats evenly, and run below
+// normal priority so the sampler keeps its rate.
+class LoadGenerator {
+public:
+    LoadGenerator();
+    ~LoadGenerator();
+
+    // threads <= 0 uses every logical processor the process may run on
+    void Start(SoakLoad load, int threads);
+    void Stop();
+
+    int GetThreadCount() const { return (int)workers.size(); }
+
+    // Work units completed so far; drops in the rate show throttling
+    uint64_t GetWorkUnits() const { return workUnits.load(std::memory_order_relaxed); }
+
+    static bool HasAvx2();
+
+    static constexpr size_t kMemoryBytes = 16 * 1024 * 1024;   // per worker
+
+private:
+    std::vector<std::thread> workers;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> workUnits;
+
+    void Run(SoakLoad load, int index, int cpu);
+};
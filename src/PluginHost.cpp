@@ -0,0 +1,153 @@
+#include "PluginHost.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+#ifdef _WIN32
+    void* OpenModule(const fs::path& path) {
+        return LoadLibraryW(path.c_str());
+    }
+
+    void* FindSymbol(void* module, const char* name) {
+        return (void*)GetProcAddress((HMODULE)module, name);
+    }
+
+    void CloseModule(void* module) {
+        FreeLibrary((HMODULE)module);
+    }
+#else
+    void* OpenModule(const fs::path& path) {
+        return dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    }
+
+    void* FindSymbol(void* module, const char* name) {
+        return dlsym(module, name);
+    }
+
+    void CloseModule(void* module) {
+        dlclose(module);
+    }
+#endif
+}
+
+#ifdef _WIN32
+const wchar_t* const PluginHost::kExtension = L".dll";
+#else
+const wchar_t* const PluginHost::kExtension = L".so";
+#endif
+
+PluginHost::PluginHost() {
+}
+
+PluginHost::~PluginHost() {
+    Unload();
+}
+
+size_t PluginHost::Load(const std::wstring& directory, SensorRegistry& registry) {
+    std::error_code ec;
+    std::vector<fs::path> paths;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == kExtension) {
+            paths.push_back(it->path());
+        }
+    }
+
+    // Same order on every start, so plugin sensors keep their keys
+    std::sort(paths.begin(), paths.end());
+    for (const auto& path : paths) {
+        LoadPlugin(path.wstring(), registry);
+    }
+    return plugins.size();
+}
+
+bool PluginHost::LoadPlugin(const std::wstring& path, SensorRegistry& registry) {
+    void* module = OpenModule(path);
+    if (!module) return false;
+
+    auto open = (tm_plugin_open_fn)FindSymbol(module, "tm_plugin_open");
+    auto read = (tm_plugin_read_fn)FindSymbol(module, "tm_plugin_read");
+    auto close = (tm_plugin_close_fn)FindSymbol(module, "tm_plugin_close");
+    if (!open || !read) {
+        CloseModule(module);
+        return false;
+    }
+
+    std::unique_ptr<Plugin> plugin(new Plugin());
+    plugin->module = module;
+    plugin->read = read;
+    plugin->close = close;
+    plugin->reading = false;
+
+    // A failed open owns no context, so there is nothing to close
+    if (open(TM_PLUGIN_ABI_VERSION, &plugin->info, &plugin->context) != 0) {
+        CloseModule(module);
+        return false;
+    }
+    if (plugin->info.abi_version != TM_PLUGIN_ABI_VERSION ||
+        plugin->info.sensor_count > TM_PLUGIN_MAX_SENSORS) {
+        if (close) close(plugin->context);
+        CloseModule(module);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < plugin->info.sensor_count; i++) {
+        tm_sensor_desc& desc = plugin->info.sensors[i];
+        desc.key[sizeof(desc.key) - 1] = '\0';
+        desc.label[sizeof(desc.label) - 1] = '\0';
+
+        SensorKind kind = desc.kind <= TM_KIND_OTHER ? (SensorKind)desc.kind : SensorKind::Other;
+        SensorUnit unit = desc.unit <= TM_UNIT_RPM ? (SensorUnit)desc.unit : SensorUnit::Celsius;
+        plugin->sensorIds[i] = registry.Register(kind, unit, registry.MakeKey(desc.key), desc.label);
+    }
+
+    plugins.push_back(std::move(plugin));
+    return true;
+}
+
+void PluginHost::Unload() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kShutdownTimeout);
+    for (auto& plugin : plugins) {
+        while (plugin->reading && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        // A read stuck inside the plugin keeps it and its module loaded
+        if (plugin->reading) {
+            plugin.release();
+            continue;
+        }
+
+        if (plugin->close) {
+            plugin->close(plugin->context);
+        }
+        CloseModule(plugin->module);
+    }
+    plugins.clear();
+}
+
+void PluginHost::ReadPlugin(size_t index, std::vector<SensorReading>& readings) {
+    // Only the plugin is touched from here on, so a read that outlives
+    // Unload finds it leaked rather than freed
+    Plugin* plugin = plugins[index].get();
+    plugin->reading = true;
+
+    bool ok = plugin->read(plugin->context, plugin->values, plugin->valid, plugin->info.sensor_count) == 0;
+    if (ok) {
+        int64_t now = SteadyNow();
+        for (uint32_t i = 0; i < plugin->info.sensor_count; i++) {
+            if (plugin->sensorIds[i] >= 0 && plugin->valid[i]) {
+                readings.push_back({ (uint16_t)plugin->sensorIds[i], plugin->values[i], now });
+            }
+        }
+    }
+    plugin->reading = false;
+}
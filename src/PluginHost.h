@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Sensor.h"
+#include "ReadPool.h"
+#include "TempMonitorPlugin.h"
+
+// Loads sensor plugins (see TempMonitorPlugin.h). Each plugin is read as
+// its own ReadPool source, under the deadline it declares.
+// Plugins are DLLs on Windows and shared objects (dlopen) elsewhere.
+class PluginHost {
+public:
+    PluginHost();
+    ~PluginHost();
+
+    // Loads every plugin library in the directory, in name order, and
+    // registers the sensors they declare. Returns the number of plugins loaded.
+    size_t Load(const std::wstring& directory, SensorRegistry& registry);
+
+    // Stop the read pool first. A plugin still inside a read after
+    // kShutdownTimeout is left loaded.
+    void Unload();
+
+    // A ReadPool source body; at most one call per plugin at a time
+    void ReadPlugin(size_t index, std::vector<SensorReading>& readings);
+
+    size_t GetPluginCount() const { return plugins.size(); }
+    // The plugin's read_deadline_ms, for its ReadPool source; 0 = the tick's
+    int GetReadDeadline(size_t index) const { return (int)plugins[index]->info.read_deadline_ms; }
+
+    static constexpr int kShutdownTimeout = 1000;       // ms to wait for a hung read
+    static const wchar_t* const kExtension;             // L".dll" or L".so"
+
+private:
+    struct Plugin {
+        void* module;
+        void* context;
+        tm_plugin_read_fn read;
+        tm_plugin_close_fn close;
+        tm_plugin_info info;
+        int sensorIds[TM_PLUGIN_MAX_SENSORS];
+        float values[TM_PLUGIN_MAX_SENSORS];
+        uint8_t valid[TM_PLUGIN_MAX_SENSORS];
+        std::atomic<bool> reading;   // a pool thread is inside tm_plugin_read
+    };
+
+    std::vector<std::unique_ptr<Plugin>> plugins;
+
+    bool LoadPlugin(const std::wstring& path, SensorRegistry& registry);
+};
@@ -0,0 +1,284 @@
+#include "ProcessSampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+#include <sstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winternl.h>
+#include "TempMonitor.h"
+
+// Full layout of SYSTEM_PROCESS_INFORMATION; winternl.h hides the time fields
+struct ProcessInfoEntry {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount;
+    ULONG NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime;
+    LARGE_INTEGER UserTime;
+    LARGE_INTEGER KernelTime;
+    UNICODE_STRING ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId;
+};
+
+typedef NTSTATUS (NTAPI *NtQuerySystemInformation_t)(ULONG, PVOID, ULONG, PULONG);
+
+const ULONG SYSTEM_PROCESS_INFORMATION_CLASS = 5;
+const NTSTATUS STATUS_INFO_LENGTH_MISMATCH_VALUE = (NTSTATUS)0xC0000004L;
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#endif
+
+ProcessSampler::ProcessSampler(TempMonitor* mon, const std::string& root)
+    : monitor(mon), procRoot(root), queryFunction(nullptr), lastSampleTime(0), processorCount(1),
+      lastSampleMicros(0.0), ticksToClock(1) {
+}
+
+ProcessSampler::~ProcessSampler() {
+}
+
+#ifdef _WIN32
+bool ProcessSampler::Initialize() {
+    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+    if (!ntdll) return false;
+
+    queryFunction = (void*)GetProcAddress(ntdll, "NtQuerySystemInformation");
+    if (!queryFunction) return false;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    processorCount = si.dwNumberOfProcessors ? si.dwNumberOfProcessors : 1;
+
+    buffer.resize(256 * 1024);
+    current.reserve(1024);
+    previous.reserve(1024);
+    return true;
+}
+
+// Fills current with CPU times in 100 ns units
+bool ProcessSampler::ReadProcesses(int64_t& sampleTime) {
+    if (!queryFunction) return false;
+
+    auto query = (NtQuerySystemInformation_t)queryFunction;
+    ULONG needed = 0;
+    NTSTATUS status;
+    while ((status = query(SYSTEM_PROCESS_INFORMATION_CLASS, buffer.data(), (ULONG)buffer.size(), &needed))
+        == STATUS_INFO_LENGTH_MISMATCH_VALUE) {
+        // Leave headroom for processes started between the two calls
+        buffer.resize(needed + needed / 4);
+    }
+    if (status < 0) return false;
+
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    sampleTime = ((int64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+
+    const BYTE* p = buffer.data();
+    for (;;) {
+        const ProcessInfoEntry* info = (const ProcessInfoEntry*)p;
+
+        Entry entry;
+        entry.pid = (uint32_t)(ULONG_PTR)info->UniqueProcessId;
+        entry.createTime = info->CreateTime.QuadPart;
+        entry.cpuTime = info->UserTime.QuadPart + info->KernelTime.QuadPart;
+        entry.cpuPercent = 0.0f;
+        entry.gpuPercent = 0.0f;
+
+        size_t length = info->ImageName.Length / sizeof(WCHAR);
+        if (length > 31) length = 31;
+        if (info->ImageName.Buffer) {
+            wmemcpy(entry.name, info->ImageName.Buffer, length);
+        } else {
+            length = 0;
+        }
+        entry.name[length] = L'\0';
+
+        if (entry.pid != 0) {
+            current.push_back(entry);
+        }
+
+        if (info->NextEntryOffset == 0) break;
+        p += info->NextEntryOffset;
+    }
+    return true;
+}
+#else
+bool ProcessSampler::Initialize() {
+    DIR* dir = opendir(procRoot.c_str());
+    if (!dir) return false;
+    closedir(dir);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    processorCount = cpus > 0 ? (uint32_t)cpus : 1;
+    long ticks = sysconf(_SC_CLK_TCK);
+    ticksToClock = ticks > 0 ? 1000000000 / ticks : 10000000;
+
+    // One stat line at a time; comm is capped at 16 bytes so this is plenty
+    buffer.resize(1024);
+    current.reserve(1024);
+    previous.reserve(1024);
+    return true;
+}
+
+// Fills current with CPU times in nanoseconds from /proc/[pid]/stat
+bool ProcessSampler::ReadProcesses(int64_t& sampleTime) {
+    DIR* dir = opendir(procRoot.c_str());
+    if (!dir) return false;
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    sampleTime = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+    char path[256];
+    char* line = (char*)buffer.data();
+    while (dirent* item = readdir(dir)) {
+        char* endPid = nullptr;
+        unsigned long pid = strtoul(item->d_name, &endPid, 10);
+        if (endPid == item->d_name || *endPid != '\0' || pid == 0) continue;
+
+        snprintf(path, sizeof(path), "%s/%lu/stat", procRoot.c_str(), pid);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;   // exited since readdir
+        ssize_t length = read(fd, line, buffer.size() - 1);
+        close(fd);
+        if (length <= 0) continue;
+        line[length] = '\0';
+
+        // "pid (comm) state ppid ..."; comm may itself contain ')' so use the last one
+        char* nameStart = strchr(line, '(');
+        char* nameEnd = strrchr(line, ')');
+        if (!nameStart || !nameEnd || nameEnd < nameStart) continue;
+
+        Entry entry;
+        entry.pid = (uint32_t)pid;
+        entry.cpuPercent = 0.0f;
+        entry.gpuPercent = 0.0f;
+
+        size_t nameLength = std::min<size_t>(nameEnd - nameStart - 1, 31);
+        for (size_t i = 0; i < nameLength; i++) {
+            entry.name[i] = (wchar_t)(unsigned char)nameStart[1 + i];
+        }
+        entry.name[nameLength] = L'\0';
+
+        // Fields after comm, counting state as 0: utime 11, stime 12, starttime 19
+        char* field = nameEnd + 2;
+        unsigned long long values[20] = {};
+        int index = 0;
+        for (; index < 20 && *field; index++) {
+            while (*field == ' ') field++;
+            if (index == 0) {
+                while (*field && *field != ' ') field++;
+                continue;
+            }
+            values[index] = strtoull(field, &field, 10);
+        }
+        if (index < 20) continue;
+
+        entry.cpuTime = (int64_t)(values[11] + values[12]) * ticksToClock;
+        entry.createTime = (int64_t)values[19];
+        current.push_back(entry);
+    }
+    closedir(dir);
+    return true;
+}
+#endif
+
+bool ProcessSampler::Sample() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Last tick's table becomes "previous"; its storage is reused for this tick
+    current.swap(previous);
+    current.clear();
+
+    int64_t sampleTime = 0;
+    if (!ReadProcesses(sampleTime)) {
+        current.swap(previous);
+        return false;
+    }
+
+    std::sort(current.begin(), current.end(), [](const Entry& a, const Entry& b) {
+        return a.pid < b.pid;
+    });
+
+    // Merge-join against the previous table; a changed create time means
+    // the PID was reused and there is nothing to diff against
+    int64_t elapsed = sampleTime - lastSampleTime;
+    if (lastSampleTime != 0 && elapsed > 0) {
+        size_t j = 0;
+        for (auto& entry : current) {
+            while (j < previous.size() && previous[j].pid < entry.pid) j++;
+            if (j < previous.size() && previous[j].pid == entry.pid &&
+                previous[j].createTime == entry.createTime) {
+                int64_t delta = entry.cpuTime - previous[j].cpuTime;
+                entry.cpuPercent = (float)(100.0 * delta / ((double)elapsed * processorCount));
+            }
+        }
+    }
+    lastSampleTime = sampleTime;
+
+#ifdef _WIN32
+    if (monitor && monitor->GetGPUProcessUtilization(gpuSamples)) {
+        for (const auto& sample : gpuSamples) {
+            auto it = std::lower_bound(current.begin(), current.end(), sample.pid,
+                [](const Entry& e, uint32_t pid) { return e.pid < pid; });
+            if (it != current.end() && it->pid == sample.pid && sample.smUtil > it->gpuPercent) {
+                it->gpuPercent = (float)sample.smUtil;
+            }
+        }
+    }
+#endif
+
+    lastSampleMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void ProcessSampler::GetTopConsumers(size_t count, std::vector<ProcessUsage>& out) {
+    out.clear();
+
+    std::vector<const Entry*> ranked;
+    ranked.reserve(current.size());
+    for (const auto& entry : current) {
+        if (entry.cpuPercent > 0.0f || entry.gpuPercent > 0.0f) {
+            ranked.push_back(&entry);
+        }
+    }
+
+    count = std::min(count, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+        [](const Entry* a, const Entry* b) {
+            return (a->cpuPercent + a->gpuPercent) > (b->cpuPercent + b->gpuPercent);
+        });
+
+    for (size_t i = 0; i < count; i++) {
+        ProcessUsage usage;
+        usage.pid = ranked[i]->pid;
+        usage.cpuPercent = ranked[i]->cpuPercent;
+        usage.gpuPercent = ranked[i]->gpuPercent;
+        wmemcpy(usage.name, ranked[i]->name, 32);
+        out.push_back(usage);
+    }
+}
+
+std::wstring ProcessSampler::FormatConsumers(const std::vector<ProcessUsage>& consumers) {
+    std::wstringstream ss;
+    ss << std::fixed << std::setprecision(0);
+    for (size_t i = 0; i < consumers.size(); i++) {
+        if (i > 0) ss << L", ";
+        ss << consumers[i].name << L" " << consumers[i].cpuPercent << L"%";
+        if (consumers[i].gpuPercent > 0.0f) {
+            ss << L"/" << consumers[i].gpuPercent << L"%";
+        }
+    }
+    return ss.str();
+}
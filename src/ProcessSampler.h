@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class TempMonitor;
+
+struct GPUProcessSample {
+    uint32_t pid;
+    unsigned int smUtil;   // percent
+};
+
+struct ProcessUsage {
+    uint32_t pid;
+    float cpuPercent;   // share of all logical processors since the last sample
+    float gpuPercent;   // SM utilisation reported by NVML, 0 when unavailable
+    wchar_t name[32];
+};
+
+// Diffs per-process CPU time between ticks to find what is heating the
+// machine. On Windows that is one NtQuerySystemInformation call per tick
+// into a buffer reused across ticks; elsewhere one read of /proc/[pid]/stat
+// per process into a fixed buffer. The per-process tables are recycled as well.
+class ProcessSampler {
+public:
+    // procRoot replaces /proc, for tests; unused on Windows
+    explicit ProcessSampler(TempMonitor* monitor = nullptr, const std::string& procRoot = "/proc");
+    ~ProcessSampler();
+
+    bool Initialize();
+    bool Sample();
+
+    // Heaviest consumers from the last Sample(), by CPU + GPU share
+    void GetTopConsumers(size_t count, std::vector<ProcessUsage>& out);
+
+    // Wall time of the last Sample() call, for keeping an eye on overhead
+    double GetLastSampleMicros() const { return lastSampleMicros; }
+    size_t GetProcessCount() const { return current.size(); }
+
+    static std::wstring FormatConsumers(const std::vector<ProcessUsage>& consumers);
+
+private:
+    struct Entry {
+        uint32_t pid;
+        int64_t createTime;
+        int64_t cpuTime;      // user + kernel, in units of the sample clock
+        float cpuPercent;
+        float gpuPercent;
+        wchar_t name[32];
+    };
+
+    TempMonitor* monitor;
+    std::string procRoot;
+    void* queryFunction;
+    std::vector<unsigned char> buffer;
+    std::vector<Entry> current;
+    std::vector<Entry> previous;
+    std::vector<GPUProcessSample> gpuSamples;
+    int64_t lastSampleTime;
+    uint32_t processorCount;
+    double lastSampleMicros;
+    int64_t ticksToClock;   // /proc CPU times are in clock ticks
+
+    bool ReadProcesses(int64_t& sampleTime);
+};
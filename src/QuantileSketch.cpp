@@ -0,0 +1,189 @@
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    const uint32_t kSketchMagic = 0x53514D54;   // "TMQS"
+    const uint16_t kSketchVersion = 1;
+
+#pragma pack(push, 1)
+    struct SketchHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        double accuracy;
+        int32_t offset;
+        uint32_t binCount;
+        uint64_t zeroCount;
+        uint64_t count;
+        double minValue;
+        double maxValue;
+        double sum;
+    };
+#pragma pack(pop)
+}
+
+QuantileSketch::QuantileSketch(double relativeAccuracy)
+    : accuracy(relativeAccuracy) {
+    if (!(accuracy > 0.0 && accuracy < 1.0)) accuracy = kDefaultAccuracy;
+    gamma = (1.0 + accuracy) / (1.0 - accuracy);
+    logGamma = std::log(gamma);
+    Clear();
+}
+
+void QuantileSketch::Clear() {
+    offset = 0;
+    bins.clear();
+    zeroCount = 0;
+    count = 0;
+    minValue = NAN;
+    maxValue = NAN;
+    sum = 0.0;
+}
+
+int32_t QuantileSketch::Key(double value) const {
+    return (int32_t)std::ceil(std::log(value) / logGamma);
+}
+
+double QuantileSketch::Value(int32_t key) const {
+    // Midpoint of (gamma^(key-1), gamma^key] in relative terms
+    return 2.0 * std::exp(key * logGamma) / (gamma + 1.0);
+}
+
+void QuantileSketch::AddKey(int32_t key, uint64_t n) {
+    if (bins.empty()) {
+        offset = key;
+        bins.assign(1, 0);
+    } else if (key < offset) {
+        // Grow downwards as far as the bin limit allows, then fold into the lowest bin
+        size_t grow = (size_t)(offset - key);
+        if (bins.size() + grow > kMaxBins) grow = kMaxBins - bins.size();
+        bins.insert(bins.begin(), grow, 0);
+        offset -= (int32_t)grow;
+        key = std::max(key, offset);
+    } else if ((size_t)(key - offset) >= bins.size()) {
+        size_t needed = (size_t)(key - offset) + 1;
+        if (needed > kMaxBins) {
+            // Fold everything below the new window into its lowest bin
+            int32_t newOffset = key - (int32_t)kMaxBins + 1;
+            size_t folded = std::min(bins.size(), (size_t)(newOffset - offset));
+            uint64_t carry = 0;
+            for (size_t i = 0; i < folded; i++) {
+                carry += bins[i];
+            }
+            bins.erase(bins.begin(), bins.begin() + folded);
+            offset = newOffset;
+            if (bins.empty()) bins.assign(1, 0);
+            bins[0] += carry;
+        }
+        bins.resize((size_t)(key - offset) + 1, 0);
+    }
+    bins[(size_t)(key - offset)] += n;
+}
+
+void QuantileSketch::Add(double value) {
+    Add(value, 1);
+}
+
+void QuantileSketch::Add(double value, uint64_t n) {
+    if (n == 0 || std::isnan(value)) return;
+
+    if (value <= kMinIndexable) {
+        zeroCount += n;
+    } else {
+        AddKey(Key(value), n);
+    }
+
+    if (count == 0 || value < minValue) minValue = value;
+    if (count == 0 || value > maxValue) maxValue = value;
+    count += n;
+    sum += value * n;
+}
+
+bool QuantileSketch::Merge(const QuantileSketch& other) {
+    if (other.accuracy != accuracy) return false;
+    if (other.count == 0) return true;
+
+    // Add the highest bins first so a fold only ever drops low ones
+    for (size_t i = other.bins.size(); i-- > 0;) {
+        if (other.bins[i] != 0) {
+            AddKey(other.offset + (int32_t)i, other.bins[i]);
+        }
+    }
+    zeroCount += other.zeroCount;
+
+    if (count == 0 || other.minValue < minValue) minValue = other.minValue;
+    if (count == 0 || other.maxValue > maxValue) maxValue = other.maxValue;
+    count += other.count;
+    sum += other.sum;
+    return true;
+}
+
+double QuantileSketch::Quantile(double q) const {
+    if (count == 0) return NAN;
+    q = std::min(std::max(q, 0.0), 1.0);
+
+    double rank = q * (double)(count - 1);
+    if (rank < (double)zeroCount) return minValue;
+
+    uint64_t seen = zeroCount;
+    for (size_t i = 0; i < bins.size(); i++) {
+        seen += bins[i];
+        if ((double)seen > rank) {
+            double value = Value(offset + (int32_t)i);
+            return std::min(std::max(value, minValue), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+std::string QuantileSketch::Serialize() const {
+    SketchHeader header = {};
+    header.magic = kSketchMagic;
+    header.version = kSketchVersion;
+    header.accuracy = accuracy;
+    header.offset = offset;
+    header.binCount = (uint32_t)bins.size();
+    header.zeroCount = zeroCount;
+    header.count = count;
+    header.minValue = minValue;
+    header.maxValue = maxValue;
+    header.sum = sum;
+
+    std::string data(sizeof(header) + bins.size() * sizeof(uint64_t), '\0');
+    memcpy(&data[0], &header, sizeof(header));
+    if (!bins.empty()) {
+        memcpy(&data[sizeof(header)], bins.data(), bins.size() * sizeof(uint64_t));
+    }
+    return data;
+}
+
+bool QuantileSketch::Deserialize(const std::string& data) {
+    SketchHeader header;
+    if (data.size() < sizeof(header)) return false;
+    memcpy(&header, data.data(), sizeof(header));
+
+    if (header.magic != kSketchMagic || header.version != kSketchVersion ||
+        header.binCount > kMaxBins ||
+        data.size() != sizeof(header) + (size_t)header.binCount * sizeof(uint64_t)) {
+        return false;
+    }
+
+    QuantileSketch loaded(header.accuracy);
+    if (loaded.accuracy != header.accuracy) return false;
+
+    loaded.offset = header.offset;
+    loaded.bins.resize(header.binCount);
+    if (header.binCount > 0) {
+        memcpy(loaded.bins.data(), data.data() + sizeof(header), header.binCount * sizeof(uint64_t));
+    }
+    loaded.zeroCount = header.zeroCount;
+    loaded.count = header.count;
+    loaded.minValue = header.minValue;
+    loaded.maxValue = header.maxValue;
+    loaded.sum = header.sum;
+
+    *this = loaded;
+    return true;
+}
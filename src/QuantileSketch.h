@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Streaming quantile estimate with a fixed relative error (DDSketch).
+// Values fall into logarithmic bins, so any quantile is within
+// relativeAccuracy of the true value. Bins are bounded by kMaxBins; when
+// the range grows beyond that, the lowest bins are folded together, which
+// keeps the high percentiles we care about exact to the error bound.
+// Two sketches with the same accuracy merge by adding their bins.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = kDefaultAccuracy);
+
+    void Add(double value);
+    void Add(double value, uint64_t count);
+
+    // False when the sketches were built with different accuracies
+    bool Merge(const QuantileSketch& other);
+
+    // q in [0, 1]; NaN when empty
+    double Quantile(double q) const;
+
+    uint64_t GetCount() const { return count; }
+    double GetMin() const { return minValue; }
+    double GetMax() const { return maxValue; }
+    double GetSum() const { return sum; }
+    double GetAccuracy() const { return accuracy; }
+
+    void Clear();
+
+    // Portable binary form, for files or sending to another host
+    std::string Serialize() const;
+    bool Deserialize(const std::string& data);
+
+    static constexpr double kDefaultAccuracy = 0.01;
+    static const size_t kMaxBins = 1024;
+
+    // Values at or below this are counted together and reported as the minimum
+    static constexpr double kMinIndexable = 1e-3;
+
+private:
+    double accuracy;
+    double gamma;
+    double logGamma;
+
+    int32_t offset;                // key of bins[0]
+    std::vector<uint64_t> bins;
+    uint64_t zeroCount;
+    uint64_t count;
+    double minValue;
+    double maxValue;
+    double sum;
+
+    int32_t Key(double value) const;
+    double Value(int32_t key) const;
+    void AddKey(int32_t key, uint64_t n);
+};
@@ -0,0 +1,171 @@
+#include "ReadPool.h"
+#include <algorithm>
+#include <chrono>
+
+ReadPool::ReadPool()
+    : state(std::make_shared<State>()) {
+    state->active = 0;
+    state->stopping = false;
+    lastGood.Clear((uint32_t)kMaxSensors);
+}
+
+ReadPool::~ReadPool() {
+    Stop();
+}
+
+int ReadPool::AddSource(ReadFunction read, int deadlineMs) {
+    Source source;
+    source.read = read;
+    source.deadline = std::max(deadlineMs, 0);
+    source.running = false;
+    source.finished = false;
+    source.arrived = false;
+    source.late = 0;
+    state->sources.push_back(std::move(source));
+    return (int)state->sources.size() - 1;
+}
+
+void ReadPool::Start(ThreadHook onThreadStart, ThreadHook onThreadExit) {
+    // One thread per source up to the cap, so a hung source only blocks
+    // its own thread
+    size_t count = std::min(std::max<size_t>(state->sources.size(), 1), kMaxThreads);
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&ReadPool::WorkerLoop, state, onThreadStart, onThreadExit);
+    }
+}
+
+bool ReadPool::Stop() {
+    if (threads.empty()) return true;
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->stopping = true;
+    state->queue.clear();
+    state->work.notify_all();
+
+    bool idle = state->done.wait_for(lock, std::chrono::milliseconds(kShutdownTimeout),
+        [this] { return state->active == 0; });
+    lock.unlock();
+
+    for (auto& thread : threads) {
+        // A worker stuck in a driver call cannot be interrupted; leave it
+        // behind rather than hang shutdown
+        if (idle) thread.join(); else thread.detach();
+    }
+    threads.clear();
+    return idle;
+}
+
+uint64_t ReadPool::GetLateCount(int source) const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->sources[source].late;
+}
+
+void ReadPool::WorkerLoop(std::shared_ptr<State> state, ThreadHook onStart, ThreadHook onExit) {
+    if (onStart) onStart();
+
+    std::vector<SensorReading> readings;
+    for (;;) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->work.wait(lock, [&] { return state->stopping || !state->queue.empty(); });
+            if (state->stopping) break;
+
+            index = state->queue.front();
+            state->queue.pop_front();
+            state->active++;
+        }
+
+        readings.clear();
+        state->sources[index].read(readings);
+
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            Source& source = state->sources[index];
+            source.result.swap(readings);
+            source.finished = true;
+            source.running = false;
+            state->active--;
+        }
+        state->done.notify_all();
+    }
+
+    if (onExit) onExit();
+}
+
+void ReadPool::Take(Source& source) {
+    source.taken.insert(source.taken.end(), source.result.begin(), source.result.end());
+    source.result.clear();
+    source.finished = false;
+    source.arrived = true;
+}
+
+void ReadPool::Collect(SensorSnapshot& snapshot, int deadlineMs, std::vector<SensorReading>* fresh) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + std::chrono::milliseconds(deadlineMs);
+    std::vector<Source>& sources = state->sources;
+    std::vector<char> started(sources.size(), 0);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+
+    // Results that arrived after the previous deadline are taken before
+    // their source starts again; they are still fresh for this tick
+    for (auto& source : sources) {
+        if (source.finished) Take(source);
+    }
+
+    for (size_t i = 0; i < sources.size(); i++) {
+        if (!sources[i].running) {
+            sources[i].running = true;
+            state->queue.push_back(i);
+            started[i] = 1;
+        }
+    }
+    state->work.notify_all();
+
+    // Until every started source is done or past its own deadline
+    for (;;) {
+        auto now = std::chrono::steady_clock::now();
+        auto until = deadline;
+        bool waiting = false;
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (!started[i] || !sources[i].running) continue;
+            auto own = sources[i].deadline > 0 ? start + std::chrono::milliseconds(sources[i].deadline) : deadline;
+            if (own > now) {
+                waiting = true;
+                until = std::min(until, own);
+            }
+        }
+        if (!waiting || now >= deadline) break;
+        state->done.wait_until(lock, until);
+    }
+
+    for (auto& source : sources) {
+        if (source.finished) Take(source);
+        if (!source.arrived) {
+            source.late++;
+            continue;
+        }
+
+        for (const auto& reading : source.taken) {
+            // Buffered sources report several readings per sensor; keep the newest
+            if (snapshot.valid[reading.sensor] && reading.timestamp < snapshot.timestamps[reading.sensor]) continue;
+            snapshot.Set(reading.sensor, reading.value, reading.timestamp);
+        }
+        if (fresh) fresh->insert(fresh->end(), source.taken.begin(), source.taken.end());
+        source.taken.clear();
+        source.arrived = false;
+    }
+    lock.unlock();
+
+    // Sensors without a fresh reading fall back to their own last good value
+    const int64_t now = SteadyNow();
+    for (uint32_t sensor = 0; sensor < snapshot.count && sensor < kMaxSensors; sensor++) {
+        if (snapshot.valid[sensor]) {
+            lastGood.Set(sensor, snapshot.values[sensor], snapshot.timestamps[sensor]);
+        } else if (lastGood.valid[sensor] && now - lastGood.timestamps[sensor] <= kMaxStaleAge) {
+            snapshot.Set(sensor, lastGood.values[sensor], lastGood.timestamps[sensor]);
+            snapshot.stale[sensor] = 1;
+        }
+    }
+}
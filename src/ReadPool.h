@@ -0,0 +1,81 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Sensor.h"
+
+struct SensorReading {
+    uint16_t sensor;
+    float value;
+    int64_t timestamp;   // SteadyNow() when read
+};
+
+// Reads every source in parallel on a small pool and waits no longer than
+// a per-tick deadline. A source that misses it keeps running; its sensors
+// report their last good values flagged stale, and its result counts as
+// fresh on the first tick after it arrives. A source is never started again while still busy,
+// so one hung device ties up at most one thread.
+class ReadPool {
+public:
+    // Appends the source's readings; sensors it leaves out keep their last
+    // good value, flagged stale
+    typedef std::function<void(std::vector<SensorReading>&)> ReadFunction;
+    typedef std::function<void()> ThreadHook;
+
+    ReadPool();
+    ~ReadPool();
+
+    // Sources must be added before Start. A source with its own deadline
+    // is waited for no longer than that, nor than the tick's deadline.
+    int AddSource(ReadFunction read, int deadlineMs = 0);
+    void Start(ThreadHook onThreadStart = ThreadHook(), ThreadHook onThreadExit = ThreadHook());
+    // Returns false when a hung source had to be left running; whatever it
+    // reads must then stay alive until the process exits
+    bool Stop();
+
+    // The snapshot gets each sensor's newest reading; fresh, when given,
+    // receives every reading that arrived, older ones included
+    void Collect(SensorSnapshot& snapshot, int deadlineMs, std::vector<SensorReading>* fresh = nullptr);
+
+    size_t GetSourceCount() const { return state->sources.size(); }
+    uint64_t GetLateCount(int source) const;
+
+    static constexpr size_t kMaxThreads = 8;
+    static constexpr int64_t kMaxStaleAge = 30000;   // ms; older values become invalid
+    static constexpr int kShutdownTimeout = 1000;    // ms
+
+private:
+    struct Source {
+        ReadFunction read;
+        int deadline;                        // ms, 0 = the tick's deadline
+        bool running;
+        bool finished;                       // result holds a reading not yet taken
+        bool arrived;                        // a reading was taken since the last tick
+        std::vector<SensorReading> result;
+        std::vector<SensorReading> taken;    // readings not yet collected, oldest first
+        uint64_t late;
+    };
+
+    // Shared with the workers so a hung worker can outlive the pool
+    struct State {
+        std::mutex mutex;
+        std::condition_variable work;
+        std::condition_variable done;
+        std::deque<size_t> queue;
+        std::vector<Source> sources;
+        int active;
+        bool stopping;
+    };
+
+    std::shared_ptr<State> state;
+    std::vector<std::thread> threads;
+    SensorSnapshot lastGood;   // newest reading per sensor
+
+    static void Take(Source& source);
+    static void WorkerLoop(std::shared_ptr<State> state, ThreadHook onStart, ThreadHook onExit);
+};
@@ -0,0 +1,157 @@
+#include "ReplayProvider.h"
+#include <algorithm>
+#include <cmath>
+
+ReplayProvider::ReplayProvider()
+    : recorded(false), trace(), startTime(0), clock(0), index(0), rngState(1), lagged(0.0f) {
+}
+
+void ReplayProvider::SetSynthetic(const SyntheticTrace& t, int64_t start) {
+    recorded = false;
+    trace = t;
+    if (trace.interval <= 0) trace.interval = 2000;
+    if (trace.period <= 0) trace.period = trace.duration > 0 ? trace.duration : 1;
+    startTime = start;
+    clock = start;
+    index = 0;
+    rngState = trace.seed ? trace.seed : 1;
+    lagged = ShapeAt(0);
+
+    registry = SensorRegistry();
+    if (trace.sensorCount <= 0) {
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        registry.Register(SensorKind::Gpu, SensorUnit::Celsius, "gpu", "GPU");
+    } else {
+        for (int i = 0; i < trace.sensorCount && i < (int)kMaxSensors; i++) {
+            registry.Register(SensorKind::Other, SensorUnit::Celsius,
+                registry.MakeKey("sim"), "Sensor " + std::to_string(i + 1));
+        }
+    }
+    if (trace.withLoad) {
+        registry.Register(SensorKind::Load, SensorUnit::Percent, "load", "Load");
+    }
+}
+
+static SensorKind KindFromKey(const std::string& key) {
+    if (key.compare(0, 3, "cpu") == 0) return SensorKind::ThermalZone;
+    if (key.compare(0, 3, "gpu") == 0) return SensorKind::Gpu;
+    if (key.compare(0, 3, "fan") == 0) return SensorKind::Fan;
+    if (key.compare(0, 4, "load") == 0) return SensorKind::Load;
+    if (key.compare(0, 5, "power") == 0) return SensorKind::Power;
+    if (key.compare(0, 5, "clock") == 0) return SensorKind::Clock;
+    return SensorKind::Other;
+}
+
+static SensorUnit UnitFromKind(SensorKind kind) {
+    switch (kind) {
+    case SensorKind::Fan:
+    case SensorKind::Load: return SensorUnit::Percent;
+    case SensorKind::Power: return SensorUnit::Watt;
+    case SensorKind::Clock: return SensorUnit::Megahertz;
+    default: return SensorUnit::Celsius;
+    }
+}
+
+bool ReplayProvider::OpenRecording(const std::wstring& historyDir, int64_t start, int64_t end) {
+    recorded = true;
+    startTime = start;
+    clock = start;
+    index = 0;
+    registry = SensorRegistry();
+
+    // Replay the sensors stored in the first segment of the range
+    std::vector<std::string> keys;
+    if (!reader.Open(historyDir, {}, start, end) || !reader.GetStoredChannels(keys)) {
+        return false;
+    }
+    for (const auto& key : keys) {
+        SensorKind kind = KindFromKey(key);
+        registry.Register(kind, UnitFromKind(kind), key, key);
+    }
+    row.resize(registry.Count());
+    return reader.Open(historyDir, registry.GetKeys(), start, end);
+}
+
+// xorshift32 keeps traces identical across compilers, unlike <random> distributions
+float ReplayProvider::NextNoise() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return ((rngState >> 8) / 16777216.0f) * 2.0f - 1.0f;
+}
+
+bool ReplayProvider::NextDropout() {
+    if (trace.dropoutRate <= 0.0f) return false;
+    return (NextNoise() + 1.0f) * 0.5f < trace.dropoutRate;
+}
+
+float ReplayProvider::ShapeAt(int64_t elapsed) const {
+    float base = trace.baseTemp;
+    float peak = trace.peakTemp;
+
+    switch (trace.shape) {
+    case SyntheticTrace::Shape::Ramp:
+        if (elapsed >= trace.period) return peak;
+        return base + (peak - base) * (float)elapsed / (float)trace.period;
+    case SyntheticTrace::Shape::Spike:
+        return (elapsed % trace.period) < trace.spikeWidth ? peak : base;
+    case SyntheticTrace::Shape::Square:
+        return (elapsed % trace.period) < trace.period / 2 ? base : peak;
+    case SyntheticTrace::Shape::Soak: {
+        if (elapsed < trace.period) return base;
+        double tau = trace.timeConstant > 0 ? (double)trace.timeConstant : 1e-9;
+        int64_t heating = std::min(elapsed - trace.period, trace.spikeWidth);
+        float hot = base + (peak - base) * (float)(1.0 - std::exp(-heating / tau));
+        if (elapsed < trace.period + trace.spikeWidth) return hot;
+        return base + (hot - base) * (float)std::exp(-(elapsed - trace.period - trace.spikeWidth) / tau);
+    }
+    case SyntheticTrace::Shape::Constant:
+    default:
+        return base;
+    }
+}
+
+bool ReplayProvider::Next(SensorSnapshot& snapshot) {
+    snapshot.Clear((uint32_t)registry.Count());
+
+    if (recorded) {
+        int64_t timestamp;
+        if (!reader.Next(timestamp, row.data())) return false;
+
+        clock = timestamp;
+        for (size_t i = 0; i < row.size(); i++) {
+            if (!std::isnan(row[i])) {
+                snapshot.Set(i, row[i], clock);
+            }
+        }
+    } else {
+        int64_t elapsed = (int64_t)index * trace.interval;
+        if (elapsed >= trace.duration) return false;
+
+        clock = startTime + elapsed;
+        // Load changes at once; temperatures follow it through the lag
+        float value = ShapeAt(elapsed);
+        float temp = value;
+        if (trace.timeConstant > 0 && trace.shape != SyntheticTrace::Shape::Soak) {
+            lagged += (value - lagged) * (float)(1.0 - std::exp(-(double)trace.interval / trace.timeConstant));
+            temp = lagged;
+        }
+        float offset = (trace.degradeBy != 0.0f && elapsed >= trace.degradeAt) ? trace.degradeBy : 0.0f;
+        for (size_t i = 0; i < registry.Count(); i++) {
+            if (registry.Get(i).kind == SensorKind::Load) {
+                float range = trace.peakTemp - trace.baseTemp;
+                float load = range != 0.0f ? (value - trace.baseTemp) / range * 100.0f : 0.0f;
+                snapshot.Set(i, std::min(100.0f, std::max(0.0f, load)), clock);
+                continue;
+            }
+            float noisy = temp + offset + NextNoise() * trace.noise;
+            if (!NextDropout()) {
+                snapshot.Set(i, noisy, clock);
+            }
+        }
+    }
+
+    snapshot.time = clock;
+    index++;
+    return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "Sensor.h"
+#include "History.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parameters for a generated temperature trace. Every shape is applied to
+// each generated sensor, with independent noise per sensor.
+struct SyntheticTrace {
+    enum class Shape {
+        Constant,
+        Ramp,     // baseTemp -> peakTemp over period, then holds
+        Spike,    // peakTemp for spikeWidth at the start of every period
+        Square,   // alternates base/peak every half period
+        Soak      // idle for period, loaded for spikeWidth, then cools; first-order
+                  // response with timeConstant, like a heatsink under a step load
+    };
+
+    Shape shape;
+    float baseTemp;
+    float peakTemp;
+    int64_t period;       // ms
+    int64_t spikeWidth;   // ms
+    int64_t timeConstant; // ms; other shapes reach temperatures through the same lag
+    float noise;          // peak-to-peak amplitude / 2, in degrees
+    float dropoutRate;    // chance that a sample reads as missing
+    int64_t interval;     // ms between samples
+    int64_t duration;     // ms of trace to generate
+    uint32_t seed;
+    int sensorCount;      // temperature sensors to generate, 0 means CPU + GPU
+    bool withLoad;        // adds a "load" sensor that follows the shape from 0 to 100%
+    int64_t degradeAt;    // ms; from here on temperatures read degradeBy higher
+    float degradeBy;      // for the same load, like a clogged heatsink (0 = never)
+};
+
+// Feeds recorded or synthetic samples under a virtual clock instead of
+// reading hardware. Output is fully deterministic for a given input.
+class ReplayProvider {
+public:
+    ReplayProvider();
+
+    void SetSynthetic(const SyntheticTrace& trace, int64_t startTime = 0);
+    bool OpenRecording(const std::wstring& historyDir, int64_t startTime, int64_t endTime);
+
+    const SensorRegistry& GetRegistry() const { return registry; }
+
+    // Produces the next sample and advances the virtual clock to its timestamp
+    bool Next(SensorSnapshot& snapshot);
+    int64_t GetTime() const { return clock; }
+
+private:
+    bool recorded;
+    SensorRegistry registry;
+    std::vector<float> row;
+    HistoryReader reader;
+    SyntheticTrace trace;
+    int64_t startTime;
+    int64_t clock;
+    uint64_t index;
+    uint32_t rngState;
+    float lagged;         // shape value after the timeConstant lag
+
+    float NextNoise();
+    bool NextDropout();
+    float ShapeAt(int64_t elapsed) const;
+};
@@ -0,0 +1,182 @@
+#include "SampleBus.h"
+#include <chrono>
+#include <cstring>
+
+namespace {
+    // Publishing never takes the wait mutex, so a waiter can miss a
+    // notification; it re-checks at least this often
+    const int kWakeSlice = 10;   // ms
+
+    // Worker threads wake this often to notice Stop()
+    const int kWorkerPoll = 100;   // ms
+}
+
+SampleBus::SampleBus(size_t capacity)
+    : mask(0), sinkCount(0), published(0), blockTimeouts(0), closed(false) {
+    size_t size = 2;
+    while (size < capacity) size <<= 1;
+    mask = size - 1;
+
+    slots.reset(new Slot[size]());
+    for (size_t i = 0; i < size; i++) {
+        slots[i].version.store(0, std::memory_order_relaxed);
+    }
+}
+
+SampleBus::~SampleBus() {
+    Close();
+}
+
+int SampleBus::AddSink(SinkPolicy policy) {
+    int id = sinkCount.load(std::memory_order_relaxed);
+    if (id >= (int)kMaxSinks) return -1;
+
+    // Filled in before the count covers it, so the producer never sees a
+    // half-initialised sink and existing ones never move
+    Sink& sink = sinks[id];
+    sink.policy = policy;
+    sink.cursor.store(published.load(std::memory_order_acquire), std::memory_order_relaxed);
+    sink.dropped.store(0, std::memory_order_relaxed);
+    sinkCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+void SampleBus::WaitForBlockingSinks(uint64_t seq) {
+    const uint64_t capacity = mask + 1;
+    if (seq < capacity) return;
+
+    // The slot about to be reused holds seq - capacity
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kBlockTimeout);
+    const int count = sinkCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        const Sink* sink = &sinks[i];
+        if (sink->policy != SinkPolicy::Block) continue;
+
+        for (int spins = 0; sink->cursor.load(std::memory_order_acquire) + capacity <= seq; spins++) {
+            if (std::chrono::steady_clock::now() >= deadline) {
+                // Give up on it; the sink notices the overwrite and skips ahead
+                blockTimeouts.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            if (spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+}
+
+void SampleBus::Publish(const SensorSnapshot& snapshot) {
+    const uint64_t seq = published.load(std::memory_order_relaxed);
+    WaitForBlockingSinks(seq);
+
+    Slot& slot = slots[seq & mask];
+    slot.version.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&slot.data, &snapshot, sizeof(SensorSnapshot));
+    slot.version.store(2 * seq + 2, std::memory_order_release);
+
+    published.store(seq + 1, std::memory_order_release);
+    waitCondition.notify_all();
+}
+
+bool SampleBus::ReadSlot(uint64_t seq, SensorSnapshot& out) const {
+    const Slot& slot = slots[seq & mask];
+    const uint64_t expected = 2 * seq + 2;
+
+    if (slot.version.load(std::memory_order_acquire) != expected) return false;
+    memcpy(&out, &slot.data, sizeof(SensorSnapshot));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.version.load(std::memory_order_relaxed) == expected;
+}
+
+bool SampleBus::Poll(int sinkId, SensorSnapshot& out) {
+    if (sinkId < 0 || sinkId >= sinkCount.load(std::memory_order_acquire)) return false;
+    Sink& sink = sinks[sinkId];
+    const uint64_t capacity = mask + 1;
+
+    for (;;) {
+        uint64_t head = published.load(std::memory_order_acquire);
+        uint64_t cursor = sink.cursor.load(std::memory_order_relaxed);
+        if (cursor >= head) return false;
+
+        uint64_t target = cursor;
+        if (sink.policy == SinkPolicy::Conflate) {
+            target = head - 1;
+        } else if (head - cursor > capacity) {
+            // Lapped: only the last full ring is still readable
+            target = head - capacity;
+        }
+
+        if (ReadSlot(target, out)) {
+            if (target > cursor) {
+                sink.dropped.fetch_add(target - cursor, std::memory_order_relaxed);
+            }
+            sink.cursor.store(target + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Overwritten while copying; retry against the new head
+        std::this_thread::yield();
+    }
+}
+
+bool SampleBus::Wait(int sinkId, SensorSnapshot& out, int timeoutMs) {
+    if (sinkId < 0 || sinkId >= sinkCount.load(std::memory_order_acquire)) return false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    for (;;) {
+        if (Poll(sinkId, out)) return true;
+        if (closed.load(std::memory_order_acquire)) return false;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) return false;
+
+        auto wake = now + std::chrono::milliseconds(kWakeSlice);
+        std::unique_lock<std::mutex> lock(waitMutex);
+        waitCondition.wait_until(lock, wake < deadline ? wake : deadline);
+    }
+}
+
+void SampleBus::Close() {
+    closed.store(true, std::memory_order_release);
+    waitCondition.notify_all();
+}
+
+uint64_t SampleBus::GetDropped(int sinkId) const {
+    if (sinkId < 0 || sinkId >= sinkCount.load(std::memory_order_acquire)) return 0;
+    return sinks[sinkId].dropped.load(std::memory_order_relaxed);
+}
+
+SinkWorker::SinkWorker(SampleBus& b, SinkPolicy policy, Handler h)
+    : bus(b), sink(b.AddSink(policy)), handler(h), stopping(false) {
+    if (sink >= 0) {
+        thread = std::thread(&SinkWorker::Run, this);
+    }
+}
+
+SinkWorker::~SinkWorker() {
+    Stop();
+}
+
+void SinkWorker::Stop() {
+    stopping.store(true, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SinkWorker::Run() {
+    SensorSnapshot snapshot;
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (bus.Wait(sink, snapshot, kWorkerPoll)) {
+            handler(snapshot);
+        }
+    }
+
+    // Drain what was published before Stop()
+    while (bus.Poll(sink, snapshot)) {
+        handler(snapshot);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Sensor.h"
+
+// What a sink gives up when it falls behind the producer by a full ring
+enum class SinkPolicy {
+    Block,        // producer waits for it, but never longer than kBlockTimeout
+    DropOldest,   // skips to the oldest snapshot still in the ring
+    Conflate      // only ever sees the latest snapshot
+};
+
+// Single-producer, multi-consumer ring of snapshots. Every sink keeps its
+// own cursor, so each consumes at its own pace. Slots are guarded by a
+// per-slot sequence number (seqlock), so publishing takes no locks and
+// readers detect slots that were overwritten while they copied them.
+class SampleBus {
+public:
+    explicit SampleBus(size_t capacity = 64);
+    ~SampleBus();
+
+    // Sinks live in a fixed table, so one can be added from the producer
+    // thread while other sinks are already polling. It starts at the next
+    // published snapshot. Returns -1 once kMaxSinks exist.
+    int AddSink(SinkPolicy policy);
+
+    void Publish(const SensorSnapshot& snapshot);
+
+    // Next snapshot for the sink according to its policy; false when there
+    // is nothing new or the sink does not exist
+    bool Poll(int sink, SensorSnapshot& out);
+    bool Wait(int sink, SensorSnapshot& out, int timeoutMs);
+
+    // Wakes all waiting sinks; Wait returns false from then on
+    void Close();
+
+    uint64_t GetPublished() const { return published.load(std::memory_order_acquire); }
+    uint64_t GetDropped(int sink) const;
+    uint64_t GetBlockTimeouts() const { return blockTimeouts.load(std::memory_order_relaxed); }
+
+    static constexpr int kBlockTimeout = 50;   // ms
+    static constexpr size_t kMaxSinks = 16;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> version;   // 2 * seq + 1 while writing, 2 * seq + 2 when done
+        SensorSnapshot data;
+    };
+
+    struct Sink {
+        SinkPolicy policy;
+        std::atomic<uint64_t> cursor;    // next sequence to read
+        std::atomic<uint64_t> dropped;
+    };
+
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    Sink sinks[kMaxSinks];
+    std::atomic<int> sinkCount;
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> blockTimeouts;
+    std::atomic<bool> closed;
+
+    std::mutex waitMutex;
+    std::condition_variable waitCondition;
+
+    bool ReadSlot(uint64_t seq, SensorSnapshot& out) const;
+    void WaitForBlockingSinks(uint64_t seq);
+};
+
+// Runs a handler for every snapshot a sink receives, on its own thread.
+// When the bus has no room for another sink, no thread is started and the
+// handler is never called.
+class SinkWorker {
+public:
+    typedef std::function<void(const SensorSnapshot&)> Handler;
+
+    SinkWorker(SampleBus& bus, SinkPolicy policy, Handler handler);
+    ~SinkWorker();
+
+    bool IsAttached() const { return sink >= 0; }
+
+    // Handles whatever is still queued for this sink, then stops
+    void Stop();
+
+private:
+    SampleBus& bus;
+    int sink;
+    Handler handler;
+    std::atomic<bool> stopping;
+    std::thread thread;
+
+    void Run();
+};
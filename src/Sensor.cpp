@@ -0,0 +1,135 @@
+#include "Sensor.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+void SensorSnapshot::Clear(uint32_t sensorCount) {
+    count = sensorCount;
+    memset(valid, 0, sizeof(valid));
+    memset(stale, 0, sizeof(stale));
+    partial = false;
+}
+
+void SensorSnapshot::Set(size_t id, float value, int64_t timestamp) {
+    if (id >= kMaxSensors) return;
+    values[id] = value;
+    timestamps[id] = timestamp;
+    valid[id] = 1;
+}
+
+int SensorRegistry::Register(SensorKind kind, SensorUnit unit, const std::string& key, const std::string& label) {
+    int existing = Find(key);
+    if (existing >= 0) return existing;
+    if (sensors.size() >= kMaxSensors) return -1;
+
+    SensorInfo info = {};
+    info.id = (uint16_t)sensors.size();
+    info.kind = kind;
+    info.unit = unit;
+    strncpy(info.key, key.c_str(), sizeof(info.key) - 1);
+    strncpy(info.label, label.c_str(), sizeof(info.label) - 1);
+    sensors.push_back(info);
+    return info.id;
+}
+
+int SensorRegistry::Find(const std::string& key) const {
+    for (const auto& info : sensors) {
+        if (key == info.key) return info.id;
+    }
+    return -1;
+}
+
+std::vector<std::string> SensorRegistry::GetKeys() const {
+    std::vector<std::string> keys;
+    for (const auto& info : sensors) {
+        keys.push_back(info.key);
+    }
+    return keys;
+}
+
+std::string SensorRegistry::MakeKey(const std::string& prefix) const {
+    if (Find(prefix) < 0) return prefix;
+    for (int i = 1; ; i++) {
+        std::string key = prefix + std::to_string(i);
+        if (Find(key) < 0) return key;
+    }
+}
+
+int64_t SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int HottestSensor(const SensorSnapshot& snapshot, const SensorRegistry& registry) {
+    int hottest = -1;
+    for (uint32_t i = 0; i < snapshot.count; i++) {
+        if (!snapshot.valid[i] || !SensorRegistry::IsTemperature(registry.Get(i))) continue;
+        if (hottest < 0 || snapshot.values[i] > snapshot.values[hottest]) {
+            hottest = (int)i;
+        }
+    }
+    return hottest;
+}
+
+namespace {
+    struct SensorGroup {
+        const wchar_t* name;
+        SensorKind kinds[3];
+        int kindCount;
+        const wchar_t* unit;
+    };
+
+    const SensorGroup kGroups[] = {
+        { L"CPU", { SensorKind::ThermalZone, SensorKind::CpuPackage, SensorKind::CpuCore }, 3, L"\u00B0C" },
+        { L"GPU", { SensorKind::Gpu }, 1, L"\u00B0C" },
+        { L"NVMe", { SensorKind::Storage }, 1, L"\u00B0C" },
+        { L"VRM", { SensorKind::Vrm }, 1, L"\u00B0C" },
+        { L"Other", { SensorKind::Other }, 1, L"\u00B0C" },
+        { L"Fan", { SensorKind::Fan }, 1, L"%" },
+    };
+}
+
+std::wstring SummarizeSnapshot(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+    const wchar_t* separator) {
+    std::wstringstream ss;
+    ss << std::fixed;
+    bool first = true;
+
+    for (const auto& group : kGroups) {
+        bool registered = false;
+        bool found = false;
+        bool stale = false;
+        float best = 0.0f;
+
+        for (uint32_t i = 0; i < snapshot.count; i++) {
+            const SensorInfo& info = registry.Get(i);
+            bool member = false;
+            for (int k = 0; k < group.kindCount; k++) {
+                member = member || info.kind == group.kinds[k];
+            }
+            if (!member) continue;
+
+            registered = true;
+            if (snapshot.valid[i] && (!found || snapshot.values[i] > best)) {
+                best = snapshot.values[i];
+                stale = snapshot.stale[i] != 0;
+                found = true;
+            }
+        }
+        if (!registered) continue;
+
+        if (!first) ss << separator;
+        first = false;
+
+        ss << group.name << L": ";
+        if (!found) {
+            ss << L"--";
+        } else {
+            if (stale) ss << L"~";
+            ss << std::setprecision(group.kinds[0] == SensorKind::Fan ? 0 : 1) << best;
+        }
+        ss << group.unit;
+    }
+    return ss.str();
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum class TempLevel {
+    Normal,
+    Warning,
+    Danger
+};
+
+enum class SensorKind {
+    ThermalZone,   // ACPI/WMI zone, reported as CPU
+    CpuPackage,
+    CpuCore,
+    Gpu,
+    Storage,
+    Vrm,
+    Fan,
+    Other,
+    Load,          // CPU/GPU utilisation in percent; never shown as a temperature
+    Power,
+    Clock
+};
+
+enum class SensorUnit {
+    Celsius,
+    Percent,
+    Rpm,
+    Watt,
+    Megahertz
+};
+
+// Registered once when a source is discovered; the id is the sensor's
+// index in every SensorSnapshot for the rest of the session.
+struct SensorInfo {
+    uint16_t id;
+    SensorKind kind;
+    SensorUnit unit;
+    char key[16];     // short stable name used for history columns, e.g. "cpu1"
+    char label[32];   // display name, e.g. "CPU Zone 2"
+};
+
+const size_t kMaxSensors = 64;
+
+// One reading of every registered sensor, stored as parallel arrays so
+// per-sensor loops run over contiguous memory. Trivially copyable: handing
+// a snapshot to another thread is a single memcpy.
+struct SensorSnapshot {
+    uint32_t count;
+    int64_t time;                      // wall clock when taken, ms since epoch
+    float values[kMaxSensors];
+    int64_t timestamps[kMaxSensors];   // steady clock, ms
+    uint8_t valid[kMaxSensors];
+    uint8_t stale[kMaxSensors];        // last good value from a source that missed its deadline
+    bool partial;                      // only sensors sampled between two full readings are set
+
+    void Clear(uint32_t sensorCount);
+    void Set(size_t id, float value, int64_t timestamp);
+};
+
+static_assert(std::is_trivially_copyable<SensorSnapshot>::value,
+    "SensorSnapshot must stay memcpy-able");
+
+class SensorRegistry {
+public:
+    // Returns the existing id when the key is already registered, or -1
+    // once kMaxSensors sensors exist
+    int Register(SensorKind kind, SensorUnit unit, const std::string& key, const std::string& label);
+
+    size_t Count() const { return sensors.size(); }
+    const SensorInfo& Get(size_t id) const { return sensors[id]; }
+    int Find(const std::string& key) const;
+
+    std::vector<std::string> GetKeys() const;
+
+    // Next free key for a kind: "cpu", "cpu1", "cpu2"...
+    std::string MakeKey(const std::string& prefix) const;
+
+    static bool IsTemperature(const SensorInfo& info) { return info.unit == SensorUnit::Celsius; }
+
+private:
+    std::vector<SensorInfo> sensors;
+};
+
+// Monotonic milliseconds used for snapshot timestamps
+int64_t SteadyNow();
+
+// Hottest valid temperature sensor, or -1 when none is valid
+int HottestSensor(const SensorSnapshot& snapshot, const SensorRegistry& registry);
+
+// "CPU: 61.0°C | GPU: 72.0°C | Fan: 40%" style summary: the hottest sensor
+// of each group, in a fixed group order. Stale values are shown as "~61.0".
+std::wstring SummarizeSnapshot(const SensorSnapshot& snapshot, const SensorRegistry& registry,
+    const wchar_t* separator);
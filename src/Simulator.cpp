@@ -0,0 +1,66 @@
+#include "Simulator.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+Simulator::Simulator(int warning, int danger)
+    : warningTemp(warning), dangerTemp(danger) {
+}
+
+SimResult Simulator::Run(ReplayProvider& provider, double speed) {
+    using Clock = std::chrono::steady_clock;
+
+    SimResult result = {};
+    AlertEvaluator evaluator;
+    BaselineModel baseline(provider.GetRegistry());
+    SensorSnapshot snapshot;
+
+    auto wallStart = Clock::now();
+    bool first = true;
+    int64_t virtualStart = 0;
+    bool degradedSensors[kMaxSensors] = {};
+
+    while (provider.Next(snapshot)) {
+        int64_t now = provider.GetTime();
+        if (first) {
+            virtualStart = now;
+            first = false;
+        }
+
+        if (speed > 0.0) {
+            auto due = wallStart + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>((now - virtualStart) / speed));
+            std::this_thread::sleep_until(due);
+        }
+
+        result.ticks++;
+        if (baseline.Update(snapshot)) {
+            for (uint32_t i = 0; i < snapshot.count; i++) {
+                bool degraded = baseline.IsDegraded(i);
+                if (degraded == degradedSensors[i]) continue;
+                degradedSensors[i] = degraded;
+                result.events.push_back({ now, degraded ? SimEventType::Degraded : SimEventType::Recovered,
+                    TempLevel::Normal, snapshot.valid[i] ? snapshot.values[i] : NAN, baseline.GetExcess(i), (int)i });
+            }
+        }
+
+        AlertDecision decision = evaluator.Evaluate(snapshot, provider.GetRegistry(), warningTemp, dangerTemp);
+        if (decision.hottestSensor < 0) {
+            result.invalidTicks++;
+            continue;
+        }
+
+        if (decision.level != decision.previousLevel) {
+            result.events.push_back({ now, SimEventType::LevelChange, decision.level, decision.maxTemp, NAN, -1 });
+        }
+        if (decision.action == AlertAction::Show) {
+            result.events.push_back({ now, SimEventType::Show, decision.level, decision.maxTemp, NAN, -1 });
+        } else if (decision.action == AlertAction::Hide) {
+            result.events.push_back({ now, SimEventType::Hide, decision.level, decision.maxTemp, NAN, -1 });
+        }
+    }
+
+    result.simulatedTime = first ? 0 : provider.GetTime() - virtualStart;
+    result.wallSeconds = std::chrono::duration<double>(Clock::now() - wallStart).count();
+    return result;
+}
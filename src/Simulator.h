@@ -0,0 +1,46 @@
+#pragma once
+#include "AlertEvaluator.h"
+#include "BaselineModel.h"
+#include "ReplayProvider.h"
+#include <cstdint>
+#include <vector>
+
+enum class SimEventType {
+    LevelChange,
+    Show,
+    Hide,
+    Degraded,    // the baseline model flagged a sensor's cooling
+    Recovered
+};
+
+struct SimEvent {
+    int64_t timestamp;   // virtual time, ms
+    SimEventType type;
+    TempLevel level;
+    float maxTemp;       // hottest sensor, or for Degraded/Recovered the sensor's own temperature
+    float excess;        // for Degraded/Recovered, degrees above the baseline; NaN otherwise
+    int sensor;          // for Degraded/Recovered, -1 otherwise
+};
+
+struct SimResult {
+    std::vector<SimEvent> events;
+    uint64_t ticks;
+    uint64_t invalidTicks;
+    int64_t simulatedTime;   // ms of virtual time covered
+    double wallSeconds;
+};
+
+// Runs a replayed trace through the same evaluation path as OnTimer(),
+// baseline model included, and records every decision that would have
+// reached the UI.
+class Simulator {
+public:
+    Simulator(int warningTemp, int dangerTemp);
+
+    // speed is the virtual/real time ratio; 0 runs as fast as possible
+    SimResult Run(ReplayProvider& provider, double speed = 0.0);
+
+private:
+    int warningTemp;
+    int dangerTemp;
+};
@@ -0,0 +1,190 @@
+#include "Soak.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    const int64_t kSlopeWindow = 30000;   // ms of load the initial slope is fitted over
+    const size_t kSmoothRadius = 2;       // samples either side for crossing detection
+    const float kMinRise = 1.0f;          // C; below this the load didn't heat the sensor
+
+    std::string JsonString(const std::string& text) {
+        std::string out = "\"";
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += (char)c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += (char)c;
+            }
+        }
+        return out + "\"";
+    }
+
+    std::string JsonNumber(double value) {
+        if (std::isnan(value)) return "null";
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.2f", value);
+        return buffer;
+    }
+
+    // Centered moving average; noise would otherwise trip the crossings early
+    std::vector<float> Smooth(const std::vector<float>& values) {
+        std::vector<float> smoothed(values.size());
+        for (size_t i = 0; i < values.size(); i++) {
+            size_t first = i > kSmoothRadius ? i - kSmoothRadius : 0;
+            size_t last = std::min(values.size() - 1, i + kSmoothRadius);
+            float sum = 0.0f;
+            for (size_t j = first; j <= last; j++) sum += values[j];
+            smoothed[i] = sum / (float)(last - first + 1);
+        }
+        return smoothed;
+    }
+}
+
+SoakRecorder::SoakRecorder(const SensorRegistry& r) : registry(r), series(r.Count()) {
+}
+
+void SoakRecorder::Add(const SensorSnapshot& snapshot, int64_t elapsed) {
+    for (uint32_t i = 0; i < snapshot.count && i < series.size(); i++) {
+        if (!snapshot.valid[i] || snapshot.stale[i]) continue;
+        series[i].times.push_back(elapsed);
+        series[i].values.push_back(snapshot.values[i]);
+    }
+}
+
+std::vector<SoakResult> SoakRecorder::Analyze(const SoakPhases& phases) const {
+    std::vector<SoakResult> results;
+    for (size_t i = 0; i < series.size(); i++) {
+        if (SensorRegistry::IsTemperature(registry.Get(i))) {
+            results.push_back(AnalyzeSeries(i, phases));
+        }
+    }
+    return results;
+}
+
+SoakResult SoakRecorder::AnalyzeSeries(size_t sensor, const SoakPhases& phases) const {
+    const Series& s = series[sensor];
+    const int64_t loadStart = phases.idle;
+    const int64_t loadEnd = phases.idle + phases.load;
+
+    SoakResult result;
+    result.key = registry.Get(sensor).key;
+    result.label = registry.Get(sensor).label;
+    result.idleTemp = NAN;
+    result.steadyTemp = NAN;
+    result.peakTemp = NAN;
+    result.slope = NAN;
+    result.plateauTime = NAN;
+    result.heatTau = NAN;
+    result.coolTau = NAN;
+    result.samples = (uint32_t)s.values.size();
+    if (s.values.empty()) return result;
+
+    std::vector<float> smoothed = Smooth(s.values);
+
+    // Idle and steady state means, peak, and a least-squares slope over the
+    // start of the load
+    double idleSum = 0, steadySum = 0;
+    size_t idleCount = 0, steadyCount = 0;
+    double st = 0, sv = 0, stt = 0, stv = 0;
+    size_t slopeCount = 0;
+    size_t lastLoad = s.values.size();
+    for (size_t i = 0; i < s.values.size(); i++) {
+        int64_t t = s.times[i];
+        float v = s.values[i];
+        if (t < loadStart) {
+            idleSum += v;
+            idleCount++;
+            continue;
+        }
+        if (t >= loadEnd) continue;
+
+        lastLoad = i;
+        if (std::isnan(result.peakTemp) || v > result.peakTemp) result.peakTemp = v;
+        if (t >= loadEnd - phases.load / 5) {
+            steadySum += v;
+            steadyCount++;
+        }
+        if (t < loadStart + std::min(kSlopeWindow, phases.load)) {
+            double x = (t - loadStart) / 1000.0;
+            st += x;
+            sv += v;
+            stt += x * x;
+            stv += x * v;
+            slopeCount++;
+        }
+    }
+
+    if (idleCount > 0) result.idleTemp = (float)(idleSum / idleCount);
+    if (steadyCount > 0) result.steadyTemp = (float)(steadySum / steadyCount);
+    double denominator = slopeCount * stt - st * st;
+    if (slopeCount >= 2 && denominator > 0) {
+        result.slope = (float)((slopeCount * stv - st * sv) / denominator);
+    }
+
+    float rise = result.steadyTemp - result.idleTemp;
+    if (std::isnan(rise) || rise < kMinRise) return result;
+
+    // Heating crossings, measured from the load start
+    for (size_t i = 0; i < s.values.size() && s.times[i] < loadEnd; i++) {
+        if (s.times[i] < loadStart) continue;
+        float seconds = (s.times[i] - loadStart) / 1000.0f;
+        if (std::isnan(result.heatTau) && smoothed[i] >= result.idleTemp + 0.632f * rise) {
+            result.heatTau = seconds;
+        }
+        if (smoothed[i] >= result.idleTemp + 0.95f * rise) {
+            result.plateauTime = seconds;
+            break;
+        }
+    }
+
+    // Cooling decays from wherever the load left off towards idle
+    if (lastLoad < s.values.size()) {
+        float hot = smoothed[lastLoad];
+        float fall = hot - result.idleTemp;
+        if (fall >= kMinRise) {
+            for (size_t i = lastLoad + 1; i < s.values.size(); i++) {
+                if (smoothed[i] <= hot - 0.632f * fall) {
+                    result.coolTau = (s.times[i] - loadEnd) / 1000.0f;
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::string FormatSoakJson(const SoakReport& report) {
+    std::string out = "{\n";
+    out += "  \"load\": " + JsonString(report.load) + ",\n";
+    out += "  \"threads\": " + std::to_string(report.threads) + ",\n";
+    out += "  \"interval\": " + std::to_string(report.interval) + ",\n";
+    out += "  \"idle\": " + JsonNumber(report.phases.idle / 1000.0) + ",\n";
+    out += "  \"duration\": " + JsonNumber(report.phases.load / 1000.0) + ",\n";
+    out += "  \"cooldown\": " + JsonNumber(report.phases.cooldown / 1000.0) + ",\n";
+    out += "  \"started\": " + std::to_string(report.started) + ",\n";
+    out += "  \"workRate\": " + JsonNumber(report.workRate) + ",\n";
+    out += "  \"sensors\": [";
+
+    for (size_t i = 0; i < report.sensors.size(); i++) {
+        const SoakResult& r = report.sensors[i];
+        out += i ? ",\n    {" : "\n    {";
+        out += "\"key\": " + JsonString(r.key);
+        out += ", \"label\": " + JsonString(r.label);
+        out += ", \"idle\": " + JsonNumber(r.idleTemp);
+        out += ", \"steady\": " + JsonNumber(r.steadyTemp);
+        out += ", \"peak\": " + JsonNumber(r.peakTemp);
+        out += ", \"slope\": " + JsonNumber(r.slope);
+        out += ", \"plateau\": " + JsonNumber(r.plateauTime);
+        out += ", \"heatTau\": " + JsonNumber(r.heatTau);
+        out += ", \"coolTau\": " + JsonNumber(r.coolTau);
+        out += ", \"samples\": " + std::to_string(r.samples) + "}";
+    }
+    out += report.sensors.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    return out;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Sensor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Phase lengths of a soak run, ms from its start
+struct SoakPhases {
+    int64_t idle;       // load starts here
+    int64_t load;       // and runs this long
+    int64_t cooldown;
+};
+
+// Cooling figures of one temperature sensor; NAN where the run can't tell
+// (no idle samples, no rise, or a phase too short to reach the crossing)
+struct SoakResult {
+    std::string key;
+    std::string label;
+    float idleTemp;      // mean before the load started
+    float steadyTemp;    // mean over the last fifth of the load
+    float peakTemp;
+    float slope;         // C/s over the first 30 s of load
+    float plateauTime;   // s from load start to 95% of the rise
+    float heatTau;       // s from load start to 63% of the rise
+    float coolTau;       // s from load end to 63% of the fall
+    uint32_t samples;
+};
+
+struct SoakReport {
+    std::string load;    // "scalar", "vector", "memory" or "replay"
+    int threads;
+    int interval;        // ms between samples
+    SoakPhases phases;
+    int64_t started;     // wall clock, ms since epoch
+    double workRate;     // load work units per second, 0 for replay
+    std::vector<SoakResult> sensors;
+};
+
+// Collects every temperature sensor over a run and derives the cooling
+// figures. A step load against a heatsink is close to a first-order
+// response, so the 63% crossings estimate its time constants.
+class SoakRecorder {
+public:
+    explicit SoakRecorder(const SensorRegistry& registry);
+
+    // elapsed is ms since the start of the run; stale values are skipped
+    void Add(const SensorSnapshot& snapshot, int64_t elapsed);
+
+    std::vector<SoakResult> Analyze(const SoakPhases& phases) const;
+
+private:
+    struct Series {
+        std::vector<int64_t> times;
+        std::vector<float> values;
+    };
+
+    const SensorRegistry& registry;
+    std::vector<Series> series;
+
+    SoakResult AnalyzeSeries(size_t sensor, const SoakPhases& phases) const;
+};
+
+std::string FormatSoakJson(const SoakReport& report);
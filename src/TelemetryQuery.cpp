@@ -0,0 +1,273 @@
+#include "TelemetryQuery.h"
+#include "History.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+TelemetryQuery::TelemetryQuery(const std::wstring& historyDir, unsigned threadCount)
+    : directory(historyDir), threads(threadCount) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+    }
+}
+
+std::vector<TelemetryQuery::Segment> TelemetryQuery::ListSegments(int64_t startTime, int64_t endTime) const {
+    std::vector<Segment> segments;
+    std::error_code ec;
+
+    for (fs::directory_iterator it(fs::path(directory), ec), end; !ec && it != end; it.increment(ec)) {
+        Segment segment;
+        if (!HistoryFormat::ParseSegmentFileName(it->path().filename().wstring(),
+            segment.startTime, segment.endTime)) {
+            continue;
+        }
+        if (segment.endTime < startTime || segment.startTime >= endTime) continue;
+
+        segment.path = it->path().wstring();
+        segments.push_back(segment);
+    }
+
+    // Larger work items first keeps the threads evenly loaded
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return (a.endTime - a.startTime) > (b.endTime - b.startTime);
+    });
+    return segments;
+}
+
+size_t TelemetryQuery::BucketCount(const QuerySpec& spec) const {
+    if (spec.bucketSize <= 0 || spec.endTime <= spec.startTime) return 1;
+    return (size_t)((spec.endTime - spec.startTime + spec.bucketSize - 1) / spec.bucketSize);
+}
+
+size_t TelemetryQuery::BucketIndex(const QuerySpec& spec, int64_t timestamp) const {
+    if (spec.bucketSize <= 0) return 0;
+    return (size_t)((timestamp - spec.startTime) / spec.bucketSize);
+}
+
+void TelemetryQuery::ScanSegment(const Segment& segment, const QuerySpec& spec, std::vector<Partial>& partials) const {
+    using namespace HistoryFormat;
+
+    std::ifstream in(fs::path(segment.path), std::ios::binary);
+    if (!in) return;
+
+    SegmentHeader header;
+    if (!in.read((char*)&header, sizeof(header)) ||
+        header.magic != kMagic || header.version != kVersion || header.sampleCount == 0) {
+        return;
+    }
+
+    int channel = -1;
+    for (uint16_t c = 0; c < header.channelCount; c++) {
+        char name[kChannelNameSize];
+        if (!in.read(name, kChannelNameSize)) return;
+        name[kChannelNameSize - 1] = '\0';
+        if (spec.channel == name) channel = c;
+    }
+    if (channel < 0) return;
+
+    std::vector<BlockSummary> summaries((size_t)header.blockCount * header.channelCount);
+    if (!in.read((char*)summaries.data(), summaries.size() * sizeof(BlockSummary))) return;
+
+    const std::streamoff dataOffset = sizeof(SegmentHeader) +
+        (std::streamoff)header.channelCount * kChannelNameSize +
+        (std::streamoff)summaries.size() * sizeof(BlockSummary);
+    const std::streamoff valuesOffset = dataOffset +
+        (std::streamoff)header.sampleCount * sizeof(int64_t) +
+        (std::streamoff)channel * header.sampleCount * sizeof(float);
+
+    std::vector<int64_t> times;
+    std::vector<float> values;
+
+    // Appends up to count rows of both columns after the ones loaded from first
+    auto readRows = [&](uint32_t first, uint32_t count) {
+        uint32_t start = first + (uint32_t)times.size();
+        count = std::min(count, header.sampleCount - start);
+        if (count == 0) return false;
+
+        size_t loaded = times.size();
+        times.resize(loaded + count);
+        values.resize(loaded + count);
+        in.seekg(dataOffset + (std::streamoff)start * sizeof(int64_t));
+        if (in.read((char*)&times[loaded], count * sizeof(int64_t))) {
+            in.seekg(valuesOffset + (std::streamoff)start * sizeof(float));
+            if (in.read((char*)&values[loaded], count * sizeof(float))) return true;
+        }
+        times.resize(loaded);
+        values.resize(loaded);
+        return false;
+    };
+
+    for (uint32_t b = 0; b < header.blockCount; b++) {
+        const BlockSummary& s = summaries[(size_t)b * header.channelCount + channel];
+        if (s.count == 0) continue;
+        if (s.endTime < spec.startTime || s.startTime >= spec.endTime) continue;
+
+        bool fullyInside = s.startTime >= spec.startTime && s.endTime < spec.endTime &&
+            BucketIndex(spec, s.startTime) == BucketIndex(spec, s.endTime);
+
+        // Answer from the summary alone when possible
+        if (fullyInside && spec.aggregate != Aggregate::Percentile && spec.aggregate != Aggregate::TimeAbove) {
+            Partial& p = partials[BucketIndex(spec, s.startTime)];
+            if (p.count == 0 || s.minValue < p.minValue) p.minValue = s.minValue;
+            if (p.count == 0 || s.maxValue > p.maxValue) p.maxValue = s.maxValue;
+            p.sum += s.sum;
+            p.count += s.count;
+            continue;
+        }
+        if (spec.aggregate == Aggregate::TimeAbove && s.maxValue < spec.threshold) {
+            if (fullyInside) {
+                partials[BucketIndex(spec, s.startTime)].count += s.count;
+            }
+            continue;
+        }
+
+        uint32_t first = b * kBlockSamples;
+        uint32_t last = std::min(first + kBlockSamples, header.sampleCount);
+
+        times.clear();
+        values.clear();
+        if (!readRows(first, last - first)) return;
+
+        for (size_t i = 0; i < last - first; i++) {
+            float v = values[i];
+            int64_t t = times[i];
+            if (std::isnan(v) || t < spec.startTime || t >= spec.endTime) continue;
+
+            Partial& p = partials[BucketIndex(spec, t)];
+            switch (spec.aggregate) {
+            case Aggregate::Percentile:
+                p.sketch.Add(v);
+                break;
+            case Aggregate::TimeAbove:
+                if (v >= spec.threshold) {
+                    // A reading holds until the channel's next one; rows in
+                    // between may belong to high-rate channels only, and the
+                    // next one may be in a later block. The last sample of a
+                    // segment reuses the interval from the channel's previous one.
+                    int64_t interval = -1;
+                    for (size_t j = i + 1; interval < 0; j++) {
+                        if (j == times.size() && !readRows(first, kBlockSamples)) break;
+                        if (!std::isnan(values[j]) || times[j] - t >= kMaxSampleInterval) {
+                            interval = times[j] - t;
+                        }
+                    }
+                    for (size_t j = i; interval < 0 && j-- > 0;) {
+                        if (!std::isnan(values[j]) || t - times[j] >= kMaxSampleInterval) {
+                            interval = t - times[j];
+                        }
+                    }
+                    if (interval < 0) interval = 0;
+                    p.timeAbove += std::min(interval, kMaxSampleInterval);
+                }
+                break;
+            default:
+                if (p.count == 0 || v < p.minValue) p.minValue = v;
+                if (p.count == 0 || v > p.maxValue) p.maxValue = v;
+                p.sum += v;
+                break;
+            }
+            p.count++;
+        }
+    }
+}
+
+std::vector<TelemetryQuery::Partial> TelemetryQuery::Scan(const QuerySpec& spec) const {
+    std::vector<Segment> segments = ListSegments(spec.startTime, spec.endTime);
+    const size_t bucketCount = BucketCount(spec);
+
+    unsigned workerCount = (unsigned)std::min<size_t>(threads, segments.size());
+    if (workerCount == 0) workerCount = 1;
+
+    std::vector<std::vector<Partial>> results(workerCount, std::vector<Partial>(bucketCount, Partial()));
+    std::atomic<size_t> next(0);
+
+    auto worker = [&](unsigned index) {
+        for (size_t i = next++; i < segments.size(); i = next++) {
+            ScanSegment(segments[i], spec, results[index]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < workerCount; i++) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& t : pool) {
+        t.join();
+    }
+
+    // Merge per-thread partials into the first one
+    std::vector<Partial>& merged = results[0];
+    for (unsigned w = 1; w < workerCount; w++) {
+        for (size_t b = 0; b < bucketCount; b++) {
+            Partial& dst = merged[b];
+            Partial& src = results[w][b];
+            if (src.count == 0) continue;
+            if (dst.count == 0 || src.minValue < dst.minValue) dst.minValue = src.minValue;
+            if (dst.count == 0 || src.maxValue > dst.maxValue) dst.maxValue = src.maxValue;
+            dst.sum += src.sum;
+            dst.count += src.count;
+            dst.timeAbove += src.timeAbove;
+            dst.sketch.Merge(src.sketch);
+        }
+    }
+    return std::move(merged);
+}
+
+std::vector<QueryRow> TelemetryQuery::Run(const QuerySpec& spec) const {
+    std::vector<Partial> merged = Scan(spec);
+    const size_t bucketCount = merged.size();
+
+    std::vector<QueryRow> rows(bucketCount);
+    for (size_t b = 0; b < bucketCount; b++) {
+        Partial& p = merged[b];
+        QueryRow& row = rows[b];
+        row.bucketStart = spec.startTime + (int64_t)b * spec.bucketSize;
+        row.samples = p.count;
+        row.value = NAN;
+
+        if (spec.aggregate == Aggregate::TimeAbove) {
+            row.value = p.timeAbove / 1000.0;  // seconds
+            continue;
+        }
+        if (p.count == 0) continue;
+
+        switch (spec.aggregate) {
+        case Aggregate::Min:
+            row.value = p.minValue;
+            break;
+        case Aggregate::Max:
+            row.value = p.maxValue;
+            break;
+        case Aggregate::Mean:
+            row.value = p.sum / p.count;
+            break;
+        case Aggregate::Percentile:
+            row.value = p.sketch.Quantile(std::min(std::max(spec.percentile, 0.0), 100.0) / 100.0);
+            break;
+        default:
+            break;
+        }
+    }
+    return rows;
+}
+
+std::vector<QuantileSketch> TelemetryQuery::Sketch(const QuerySpec& spec) const {
+    QuerySpec sketchSpec = spec;
+    sketchSpec.aggregate = Aggregate::Percentile;
+
+    std::vector<Partial> merged = Scan(sketchSpec);
+    std::vector<QuantileSketch> sketches;
+    sketches.reserve(merged.size());
+    for (auto& p : merged) {
+        sketches.push_back(p.sketch);
+    }
+    return sketches;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "QuantileSketch.h"
+
+enum class Aggregate {
+    Min,
+    Max,
+    Mean,
+    Percentile,
+    TimeAbove
+};
+
+struct QuerySpec {
+    std::string channel;
+    Aggregate aggregate;
+    double percentile;   // 0-100, used by Aggregate::Percentile
+    float threshold;     // used by Aggregate::TimeAbove
+    int64_t startTime;   // inclusive, ms since epoch
+    int64_t endTime;     // exclusive, ms since epoch
+    int64_t bucketSize;  // ms, 0 = one bucket for the whole range
+};
+
+struct QueryRow {
+    int64_t bucketStart;
+    double value;        // NaN when the bucket has no valid samples
+    uint64_t samples;
+};
+
+// Answers aggregate questions over the segments written by History.
+// Segments are scanned in parallel; segments outside the time range are
+// skipped by file name and blocks are skipped using their summaries.
+class TelemetryQuery {
+public:
+    explicit TelemetryQuery(const std::wstring& historyDir, unsigned threadCount = 0);
+
+    std::vector<QueryRow> Run(const QuerySpec& spec) const;
+
+    // One quantile sketch per bucket of the spec, ignoring its aggregate.
+    // Sketches from other ranges or hosts can be merged into these.
+    std::vector<QuantileSketch> Sketch(const QuerySpec& spec) const;
+
+    // A sample counts towards TimeAbove for the interval up to the channel's
+    // next valid sample, but never longer than this (covers gaps while the
+    // app was off).
+    static constexpr int64_t kMaxSampleInterval = 10000;
+
+private:
+    std::wstring directory;
+    unsigned threads;
+
+    struct Segment {
+        std::wstring path;
+        int64_t startTime;
+        int64_t endTime;
+    };
+
+    struct Partial {
+        double minValue;
+        double maxValue;
+        double sum;
+        uint64_t count;
+        int64_t timeAbove;
+        QuantileSketch sketch;
+    };
+
+    std::vector<Partial> Scan(const QuerySpec& spec) const;
+    std::vector<Segment> ListSegments(int64_t startTime, int64_t endTime) const;
+    void ScanSegment(const Segment& segment, const QuerySpec& spec, std::vector<Partial>& partials) const;
+    size_t BucketIndex(const QuerySpec& spec, int64_t timestamp) const;
+    size_t BucketCount(const QuerySpec& spec) const;
+};
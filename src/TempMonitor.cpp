@@ -1,249 +1,516 @@
-#include "TempMonitor.h"
-#include <comdef.h>
-#include <Wbemidl.h>
-#include <sstream>
-#include <iomanip>
-
-#pragma comment(lib, "wbemuuid.lib")
-
-// NVML function pointers
-typedef int (*nvmlInit_t)();
-typedef int (*nvmlShutdown_t)();
-typedef int (*nvmlDeviceGetHandleByIndex_t)(unsigned int, void**);
-typedef int (*nvmlDeviceGetTemperature_t)(void*, int, unsigned int*);
-typedef int (*nvmlDeviceGetFanSpeed_t)(void*, unsigned int*);
-
-TempMonitor::TempMonitor() 
-    : nvmlHandle(nullptr), gpuDevice(nullptr), nvmlInitialized(false) {
-}
-
-TempMonitor::~TempMonitor() {
-    Shutdown();
-}
-
-bool TempMonitor::Initialize() {
-    CoInitializeEx(0, COINIT_MULTITHREADED);
-    InitNVML();
-    return true;
-}
-
-void TempMonitor::Shutdown() {
-    ShutdownNVML();
-    CoUninitialize();
-}
-
-bool TempMonitor::InitNVML() {
-    nvmlHandle = LoadLibraryA("nvml.dll");
-    if (!nvmlHandle) {
-        return false;
-    }
-
-    auto nvmlInit = (nvmlInit_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlInit_v2");
-    if (!nvmlInit) {
-        nvmlInit = (nvmlInit_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlInit");
-    }
-    
-    if (!nvmlInit || nvmlInit() != 0) {
-        FreeLibrary((HMODULE)nvmlHandle);
-        nvmlHandle = nullptr;
-        return false;
-    }
-
-    auto nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)
-        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetHandleByIndex_v2");
-    if (!nvmlDeviceGetHandleByIndex) {
-        nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)
-            GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetHandleByIndex");
-    }
-
-    if (nvmlDeviceGetHandleByIndex && nvmlDeviceGetHandleByIndex(0, &gpuDevice) == 0) {
-        nvmlInitialized = true;
-        return true;
-    }
-
-    return false;
-}
-
-void TempMonitor::ShutdownNVML() {
-    if (nvmlHandle) {
-        auto nvmlShutdown = (nvmlShutdown_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlShutdown");
-        if (nvmlShutdown) {
-            nvmlShutdown();
-        }
-        FreeLibrary((HMODULE)nvmlHandle);
-        nvmlHandle = nullptr;
-        nvmlInitialized = false;
-    }
-}
-
-float TempMonitor::GetCPUTemp() {
-    IWbemLocator* pLoc = nullptr;
-    IWbemServices* pSvc = nullptr;
-    float temp = 0.0f;
-
-    HRESULT hres = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER, 
-        IID_IWbemLocator, (LPVOID*)&pLoc);
-
-    if (FAILED(hres)) return 0.0f;
-
-    // Try method 1: MSAcpi_ThermalZoneTemperature
-    hres = pLoc->ConnectServer(_bstr_t(L"ROOT\\WMI"), NULL, NULL, 0, NULL, 0, 0, &pSvc);
-
-    if (SUCCEEDED(hres)) {
-        hres = CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL,
-            RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
-
-        if (SUCCEEDED(hres)) {
-            IEnumWbemClassObject* pEnumerator = nullptr;
-            hres = pSvc->ExecQuery(
-                bstr_t("WQL"),
-                bstr_t("SELECT * FROM MSAcpi_ThermalZoneTemperature"),
-                WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-                NULL, &pEnumerator);
-
-            if (SUCCEEDED(hres)) {
-                IWbemClassObject* pclsObj = nullptr;
-                ULONG uReturn = 0;
-
-                while (pEnumerator) {
-                    HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
-                    if (0 == uReturn) break;
-
-                    VARIANT vtProp;
-                    hr = pclsObj->Get(L"CurrentTemperature", 0, &vtProp, 0, 0);
-                    if (SUCCEEDED(hr)) {
-                        temp = (vtProp.uintVal / 10.0f) - 273.15f;
-                        VariantClear(&vtProp);
-                        pclsObj->Release();
-                        break;
-                    }
-                    pclsObj->Release();
-                }
-                pEnumerator->Release();
-            }
-        }
-        pSvc->Release();
-    }
-
-    // If method 1 failed, try method 2: Win32_TemperatureProbe
-    if (temp == 0.0f) {
-        hres = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), NULL, NULL, 0, NULL, 0, 0, &pSvc);
-        
-        if (SUCCEEDED(hres)) {
-            hres = CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL,
-                RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
-
-            if (SUCCEEDED(hres)) {
-                IEnumWbemClassObject* pEnumerator = nullptr;
-                hres = pSvc->ExecQuery(
-                    bstr_t("WQL"),
-                    bstr_t("SELECT * FROM Win32_TemperatureProbe"),
-                    WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
-                    NULL, &pEnumerator);
-
-                if (SUCCEEDED(hres)) {
-                    IWbemClassObject* pclsObj = nullptr;
-                    ULONG uReturn = 0;
-
-                    while (pEnumerator) {
-                        HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
-                        if (0 == uReturn) break;
-
-                        VARIANT vtProp;
-                        hr = pclsObj->Get(L"CurrentReading", 0, &vtProp, 0, 0);
-                        if (SUCCEEDED(hr) && vtProp.uintVal > 0) {
-                            temp = vtProp.uintVal / 10.0f;
-                            VariantClear(&vtProp);
-                            pclsObj->Release();
-                            break;
-                        }
-                        VariantClear(&vtProp);
-                        pclsObj->Release();
-                    }
-                    pEnumerator->Release();
-                }
-            }
-            pSvc->Release();
-        }
-    }
-
-    pLoc->Release();
-
-    // Validate temperature range (reasonable CPU temp: 20-100°C)
-    if (temp < 20.0f || temp > 100.0f) {
-        temp = 0.0f;
-    }
-
-    return temp;
-}
-
-float TempMonitor::GetGPUTemp() {
-    if (!nvmlInitialized || !gpuDevice || !nvmlHandle) {
-        return 0.0f;
-    }
-
-    auto nvmlDeviceGetTemperature = (nvmlDeviceGetTemperature_t)
-        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetTemperature");
-    
-    if (!nvmlDeviceGetTemperature) {
-        return 0.0f;
-    }
-
-    unsigned int temp = 0;
-    if (nvmlDeviceGetTemperature(gpuDevice, 0, &temp) == 0) {
-        return (float)temp;
-    }
-
-    return 0.0f;
-}
-
-int TempMonitor::GetFanSpeed() {
-    if (!nvmlInitialized || !gpuDevice || !nvmlHandle) {
-        return 0;
-    }
-
-    auto nvmlDeviceGetFanSpeed = (nvmlDeviceGetFanSpeed_t)
-        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetFanSpeed");
-    
-    if (!nvmlDeviceGetFanSpeed) {
-        return 0;
-    }
-
-    unsigned int speed = 0;
-    if (nvmlDeviceGetFanSpeed(gpuDevice, &speed) == 0) {
-        return (int)speed;
-    }
-
-    return 0;
-}
-
-TempData TempMonitor::GetCurrentTemp() {
-    TempData data;
-    data.cpuTemp = GetCPUTemp();
-    data.gpuTemp = GetGPUTemp();
-    data.fanSpeed = GetFanSpeed();
-    data.valid = (data.cpuTemp > 0 || data.gpuTemp > 0);
-    data.level = TempLevel::Normal;
-    
-    return data;
-}
-
-TempLevel TempMonitor::CheckThreshold(float temp, int warningTemp, int dangerTemp) {
-    if (temp >= dangerTemp) {
-        return TempLevel::Danger;
-    } else if (temp >= warningTemp) {
-        return TempLevel::Warning;
-    }
-    return TempLevel::Normal;
-}
-
-std::wstring TempMonitor::GetTempString() {
-    TempData data = GetCurrentTemp();
-    std::wstringstream ss;
-    ss << std::fixed << std::setprecision(1);
-    ss << L"CPU: " << data.cpuTemp << L"°C | GPU: " << data.gpuTemp << L"°C";
-    if (data.fanSpeed > 0) {
-        ss << L" | Fan: " << data.fanSpeed << L"%";
-    }
-    return ss.str();
-}
+#include "TempMonitor.h"
+#include "AlertEvaluator.h"
+#include "History.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <comdef.h>
+#include <Wbemidl.h>
+
+#pragma comment(lib, "wbemuuid.lib")
+
+// NVML function pointers
+typedef int (*nvmlInit_t)();
+typedef int (*nvmlShutdown_t)();
+typedef int (*nvmlDeviceGetCount_t)(unsigned int*);
+typedef int (*nvmlDeviceGetHandleByIndex_t)(unsigned int, void**);
+typedef int (*nvmlDeviceGetTemperature_t)(void*, int, unsigned int*);
+typedef int (*nvmlDeviceGetFanSpeed_t)(void*, unsigned int*);
+
+struct nvmlUtilization_t {
+    unsigned int gpu;
+    unsigned int memory;
+};
+typedef int (*nvmlDeviceGetUtilizationRates_t)(void*, nvmlUtilization_t*);
+
+struct nvmlProcessUtilizationSample_t {
+    unsigned int pid;
+    unsigned long long timeStamp;
+    unsigned int smUtil;
+    unsigned int memUtil;
+    unsigned int encUtil;
+    unsigned int decUtil;
+};
+typedef int (*nvmlDeviceGetProcessUtilization_t)(void*, nvmlProcessUtilizationSample_t*,
+    unsigned int*, unsigned long long);
+
+const int NVML_ERROR_INSUFFICIENT_SIZE = 7;
+
+const int kDefaultReadDeadline = 500;   // ms
+
+TempMonitor::TempMonitor() 
+    : cpuSelector((int)CpuSource::TemperatureProbe,
+          [this](int source, std::vector<float>& temps) { return ReadCPUTemps((CpuSource)source, temps); }),
+      loadSensor(-1), lastIdleTime(0), lastTotalTime(0),
+      wmiServices(), readDeadline(kDefaultReadDeadline),
+      nvmlHandle(nullptr), nvmlInitialized(false), initialized(false) {
+}
+
+TempMonitor::~TempMonitor() {
+    Shutdown();
+}
+
+bool TempMonitor::Initialize(const std::wstring& cachePath) {
+    capabilityPath = cachePath;
+    CoInitializeEx(0, COINIT_MULTITHREADED);
+    initialized = true;
+    InitNVML();
+
+    DiscoverCPU();
+    loadSensor = registry.Register(SensorKind::Load, SensorUnit::Percent, registry.MakeKey("load"), "CPU Load");
+    DiscoverGPUs();
+    InitPlugins();
+    StartReads();
+    return registry.Count() > 0;
+}
+
+bool TempMonitor::Shutdown() {
+    if (!initialized) return true;
+
+    // A read hung in a driver or plugin still uses NVML, WMI, the plugins
+    // and this object; all of them stay alive until the process exits
+    if (!reads.Stop()) return false;
+
+    plugins.Unload();
+    ShutdownNVML();
+    ReleaseWMI();
+    CoUninitialize();
+    initialized = false;
+    return true;
+}
+
+bool TempMonitor::InitNVML() {
+    nvmlHandle = LoadLibraryA("nvml.dll");
+    if (!nvmlHandle) {
+        return false;
+    }
+
+    auto nvmlInit = (nvmlInit_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlInit_v2");
+    if (!nvmlInit) {
+        nvmlInit = (nvmlInit_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlInit");
+    }
+    
+    if (!nvmlInit || nvmlInit() != 0) {
+        FreeLibrary((HMODULE)nvmlHandle);
+        nvmlHandle = nullptr;
+        return false;
+    }
+
+    auto nvmlDeviceGetCount = (nvmlDeviceGetCount_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetCount_v2");
+    if (!nvmlDeviceGetCount) {
+        nvmlDeviceGetCount = (nvmlDeviceGetCount_t)
+            GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetCount");
+    }
+
+    auto nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetHandleByIndex_v2");
+    if (!nvmlDeviceGetHandleByIndex) {
+        nvmlDeviceGetHandleByIndex = (nvmlDeviceGetHandleByIndex_t)
+            GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetHandleByIndex");
+    }
+
+    unsigned int count = 1;
+    if (nvmlDeviceGetCount && nvmlDeviceGetCount(&count) != 0) {
+        count = 1;
+    }
+
+    if (nvmlDeviceGetHandleByIndex) {
+        for (unsigned int i = 0; i < count; i++) {
+            GpuDevice gpu = {};
+            gpu.tempSensor = -1;
+            gpu.fanSensor = -1;
+            gpu.loadSensor = -1;
+            gpu.powerSensor = -1;
+            gpu.clockSensor = -1;
+            if (nvmlDeviceGetHandleByIndex(i, &gpu.handle) == 0) {
+                gpus.push_back(gpu);
+            }
+        }
+    }
+
+    nvmlInitialized = !gpus.empty();
+    return nvmlInitialized;
+}
+
+void TempMonitor::ShutdownNVML() {
+    if (nvmlHandle) {
+        auto nvmlShutdown = (nvmlShutdown_t)GetProcAddress((HMODULE)nvmlHandle, "nvmlShutdown");
+        if (nvmlShutdown) {
+            nvmlShutdown();
+        }
+        FreeLibrary((HMODULE)nvmlHandle);
+        nvmlHandle = nullptr;
+        nvmlInitialized = false;
+        gpus.clear();
+    }
+}
+
+void TempMonitor::InitPlugins() {
+    // Plugins live in a "plugins" folder next to the executable
+    WCHAR exePath[MAX_PATH];
+    DWORD length = GetModuleFileNameW(NULL, exePath, MAX_PATH);
+    if (length == 0 || length == MAX_PATH) return;
+
+    std::wstring dir(exePath, length);
+    dir = dir.substr(0, dir.find_last_of(L'\\')) + L"\\plugins";
+    plugins.Load(dir, registry);
+}
+
+void* TempMonitor::ConnectWMI(CpuSource source) {
+    const size_t index = (source == CpuSource::AcpiThermalZone) ? 0 : 1;
+    if (wmiServices[index]) return wmiServices[index];
+
+    IWbemLocator* pLoc = nullptr;
+    HRESULT hres = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER,
+        IID_IWbemLocator, (LPVOID*)&pLoc);
+    if (FAILED(hres)) return nullptr;
+
+    IWbemServices* pSvc = nullptr;
+    hres = pLoc->ConnectServer(_bstr_t(index == 0 ? L"ROOT\\WMI" : L"ROOT\\CIMV2"), NULL, NULL, 0, NULL, 0, 0, &pSvc);
+    pLoc->Release();
+    if (FAILED(hres)) return nullptr;
+
+    hres = CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL,
+        RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
+    if (FAILED(hres)) {
+        pSvc->Release();
+        return nullptr;
+    }
+
+    wmiServices[index] = pSvc;
+    return pSvc;
+}
+
+void TempMonitor::ReleaseWMI() {
+    for (auto& service : wmiServices) {
+        if (service) {
+            ((IWbemServices*)service)->Release();
+            service = nullptr;
+        }
+    }
+}
+
+// Reads every instance of the source's WMI class. Readings outside the
+// plausible CPU range (20-100°C) are returned as NaN.
+bool TempMonitor::ReadCPUTemps(CpuSource source, std::vector<float>& temps) {
+    temps.clear();
+    if (source == CpuSource::None) return false;
+
+    const bool acpi = (source == CpuSource::AcpiThermalZone);
+    IWbemServices* pSvc = (IWbemServices*)ConnectWMI(source);
+    if (!pSvc) return false;
+
+    IEnumWbemClassObject* pEnumerator = nullptr;
+    HRESULT hres = pSvc->ExecQuery(
+        bstr_t("WQL"),
+        bstr_t(acpi ? "SELECT * FROM MSAcpi_ThermalZoneTemperature" : "SELECT * FROM Win32_TemperatureProbe"),
+        WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY,
+        NULL, &pEnumerator);
+
+    if (FAILED(hres)) {
+        // The connection may be stale, e.g. after the WMI service restarted
+        pSvc->Release();
+        wmiServices[acpi ? 0 : 1] = nullptr;
+        return false;
+    }
+
+    IWbemClassObject* pclsObj = nullptr;
+    ULONG uReturn = 0;
+
+    while (pEnumerator) {
+        HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pclsObj, &uReturn);
+        if (0 == uReturn) break;
+
+        float temp = NAN;
+        VARIANT vtProp;
+        hr = pclsObj->Get(acpi ? L"CurrentTemperature" : L"CurrentReading", 0, &vtProp, 0, 0);
+        if (SUCCEEDED(hr) && vtProp.uintVal > 0) {
+            temp = acpi ? (vtProp.uintVal / 10.0f) - 273.15f : vtProp.uintVal / 10.0f;
+        }
+        if (SUCCEEDED(hr)) {
+            VariantClear(&vtProp);
+        }
+        pclsObj->Release();
+
+        // Validate temperature range (reasonable CPU temp: 20-100°C)
+        if (temp < 20.0f || temp > 100.0f) {
+            temp = NAN;
+        }
+        temps.push_back(temp);
+    }
+    pEnumerator->Release();
+
+    for (float t : temps) {
+        if (!std::isnan(t)) return true;
+    }
+    return false;
+}
+
+// Method 1: MSAcpi_ThermalZoneTemperature, method 2: Win32_TemperatureProbe
+void TempMonitor::DiscoverCPU() {
+    cpuSelector.Discover(capabilityPath, CapabilityCache::HardwareFingerprint(), History::Now(), SteadyNow());
+    cpuReadings.assign(cpuSelector.GetZoneCount(), NAN);
+
+    // Register at least one CPU sensor so the UI keeps its CPU field
+    size_t count = cpuReadings.empty() ? 1 : cpuReadings.size();
+    for (size_t i = 0; i < count; i++) {
+        std::string label = (count == 1) ? "CPU" : "CPU Zone " + std::to_string(i + 1);
+        int id = registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius,
+            registry.MakeKey("cpu"), label);
+        if (id >= 0) cpuSensors.push_back(id);
+    }
+}
+
+void TempMonitor::DiscoverGPUs() {
+    for (size_t i = 0; i < gpus.size(); i++) {
+        std::string suffix = (gpus.size() == 1) ? "" : " " + std::to_string(i + 1);
+        gpus[i].tempSensor = registry.Register(SensorKind::Gpu, SensorUnit::Celsius,
+            registry.MakeKey("gpu"), "GPU" + suffix);
+        gpus[i].fanSensor = registry.Register(SensorKind::Fan, SensorUnit::Percent,
+            registry.MakeKey("fan"), "GPU" + suffix + " Fan");
+        gpus[i].loadSensor = registry.Register(SensorKind::Load, SensorUnit::Percent,
+            registry.MakeKey("load"), "GPU" + suffix + " Load");
+
+        // Only what the driver samples on its own; the first read then
+        // starts with samples taken after discovery
+        for (size_t type = 0; type < GpuSamples::kTypes; type++) {
+            gpus[i].buffered[type] = ProbeGPUSamples(gpus[i], type);
+            gpus[i].lastSeen[type] = (unsigned long long)History::Now() * 1000;
+        }
+        if (gpus[i].buffered[1]) {
+            gpus[i].powerSensor = registry.Register(SensorKind::Power, SensorUnit::Watt,
+                registry.MakeKey("power"), "GPU" + suffix + " Power");
+        }
+        if (gpus[i].buffered[2]) {
+            gpus[i].clockSensor = registry.Register(SensorKind::Clock, SensorUnit::Megahertz,
+                registry.MakeKey("clock"), "GPU" + suffix + " Clock");
+        }
+    }
+}
+
+float TempMonitor::GetGPUTemp(void* device) {
+    if (!nvmlInitialized || !device || !nvmlHandle) {
+        return 0.0f;
+    }
+
+    auto nvmlDeviceGetTemperature = (nvmlDeviceGetTemperature_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetTemperature");
+    
+    if (!nvmlDeviceGetTemperature) {
+        return 0.0f;
+    }
+
+    unsigned int temp = 0;
+    if (nvmlDeviceGetTemperature(device, 0, &temp) == 0) {
+        return (float)temp;
+    }
+
+    return 0.0f;
+}
+
+int TempMonitor::GetFanSpeed(void* device) {
+    if (!nvmlInitialized || !device || !nvmlHandle) {
+        return 0;
+    }
+
+    auto nvmlDeviceGetFanSpeed = (nvmlDeviceGetFanSpeed_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetFanSpeed");
+    
+    if (!nvmlDeviceGetFanSpeed) {
+        return 0;
+    }
+
+    unsigned int speed = 0;
+    if (nvmlDeviceGetFanSpeed(device, &speed) == 0) {
+        return (int)speed;
+    }
+
+    return 0;
+}
+
+int TempMonitor::GetGPUUtilization(void* device) {
+    if (!nvmlInitialized || !device || !nvmlHandle) {
+        return -1;
+    }
+
+    auto nvmlDeviceGetUtilizationRates = (nvmlDeviceGetUtilizationRates_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetUtilizationRates");
+
+    if (!nvmlDeviceGetUtilizationRates) {
+        return -1;
+    }
+
+    nvmlUtilization_t utilization = {};
+    if (nvmlDeviceGetUtilizationRates(device, &utilization) == 0) {
+        return (int)utilization.gpu;
+    }
+
+    return -1;
+}
+
+bool TempMonitor::ProbeGPUSamples(GpuDevice& gpu, size_t type) {
+    if (!nvmlInitialized || !gpu.handle || !nvmlHandle) {
+        return false;
+    }
+
+    auto nvmlDeviceGetSamples = (nvmlDeviceGetSamples_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetSamples");
+    return GpuSamples::Probe(nvmlDeviceGetSamples, gpu.handle, type);
+}
+
+void TempMonitor::ReadGPUSamples(GpuDevice& gpu, size_t type, std::vector<SensorReading>& readings) {
+    int sensor = (type == 0) ? gpu.loadSensor : (type == 1) ? gpu.powerSensor : gpu.clockSensor;
+    if (sensor < 0) return;
+
+    auto nvmlDeviceGetSamples = (nvmlDeviceGetSamples_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetSamples");
+
+    // Driver timestamps are wall clock; readings use the steady clock
+    GpuSamples::Read(nvmlDeviceGetSamples, gpu.handle, type, (uint16_t)sensor, gpu.lastSeen[type],
+        gpu.sampleBuffer, SteadyNow() - History::Now(), readings);
+}
+
+bool TempMonitor::GetGPUProcessUtilization(std::vector<GPUProcessSample>& samples) {
+    samples.clear();
+    if (!nvmlInitialized || !nvmlHandle) {
+        return false;
+    }
+
+    auto nvmlDeviceGetProcessUtilization = (nvmlDeviceGetProcessUtilization_t)
+        GetProcAddress((HMODULE)nvmlHandle, "nvmlDeviceGetProcessUtilization");
+
+    if (!nvmlDeviceGetProcessUtilization) {
+        return false;
+    }
+
+    bool supported = false;
+    for (auto& gpu : gpus) {
+        // First call sizes the buffer, which is kept for later ticks
+        unsigned int count = 0;
+        int result = nvmlDeviceGetProcessUtilization(gpu.handle, nullptr, &count, gpu.processLastSeen);
+        if (result != NVML_ERROR_INSUFFICIENT_SIZE && result != 0) {
+            continue;
+        }
+        supported = true;
+        if (count == 0) {
+            continue;
+        }
+
+        size_t needed = count * sizeof(nvmlProcessUtilizationSample_t);
+        if (gpuProcessBuffer.size() < needed) {
+            gpuProcessBuffer.resize(needed);
+        }
+
+        auto raw = (nvmlProcessUtilizationSample_t*)gpuProcessBuffer.data();
+        if (nvmlDeviceGetProcessUtilization(gpu.handle, raw, &count, gpu.processLastSeen) != 0) {
+            continue;
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            samples.push_back({ raw[i].pid, raw[i].smUtil });
+            if (raw[i].timeStamp > gpu.processLastSeen) {
+                gpu.processLastSeen = raw[i].timeStamp;
+            }
+        }
+    }
+    return supported;
+}
+
+void TempMonitor::StartReads() {
+    if (!cpuSensors.empty()) {
+        reads.AddSource([this](std::vector<SensorReading>& readings) { ReadCPU(readings); });
+    }
+    if (loadSensor >= 0) {
+        reads.AddSource([this](std::vector<SensorReading>& readings) { ReadLoad(readings); });
+    }
+    for (auto& gpu : gpus) {
+        GpuDevice* device = &gpu;
+        reads.AddSource([this, device](std::vector<SensorReading>& readings) { ReadGPU(*device, readings); });
+    }
+    for (size_t i = 0; i < plugins.GetPluginCount(); i++) {
+        reads.AddSource([this, i](std::vector<SensorReading>& readings) { plugins.ReadPlugin(i, readings); },
+            plugins.GetReadDeadline(i));
+    }
+
+    // WMI needs COM on every thread that queries it
+    reads.Start([] { CoInitializeEx(0, COINIT_MULTITHREADED); }, [] { CoUninitialize(); });
+}
+
+void TempMonitor::ReadCPU(std::vector<SensorReading>& readings) {
+    TRACE_SCOPE("read cpu");
+    cpuSelector.Read(cpuReadings, History::Now(), SteadyNow());
+
+    int64_t now = SteadyNow();
+    for (size_t i = 0; i < cpuSensors.size() && i < cpuReadings.size(); i++) {
+        if (!std::isnan(cpuReadings[i])) {
+            readings.push_back({ (uint16_t)cpuSensors[i], cpuReadings[i], now });
+        }
+    }
+}
+
+void TempMonitor::ReadGPU(GpuDevice& gpu, std::vector<SensorReading>& readings) {
+    TRACE_SCOPE("read gpu");
+    float temp = GetGPUTemp(gpu.handle);
+    if (temp > 0 && gpu.tempSensor >= 0) {
+        readings.push_back({ (uint16_t)gpu.tempSensor, temp, SteadyNow() });
+    }
+    int fan = GetFanSpeed(gpu.handle);
+    if (fan > 0 && gpu.fanSensor >= 0) {
+        readings.push_back({ (uint16_t)gpu.fanSensor, (float)fan, SteadyNow() });
+    }
+
+    for (size_t type = 0; type < GpuSamples::kTypes; type++) {
+        if (gpu.buffered[type]) ReadGPUSamples(gpu, type, readings);
+    }
+    if (!gpu.buffered[0]) {
+        int utilization = GetGPUUtilization(gpu.handle);
+        if (utilization >= 0 && gpu.loadSensor >= 0) {
+            readings.push_back({ (uint16_t)gpu.loadSensor, (float)utilization, SteadyNow() });
+        }
+    }
+}
+
+void TempMonitor::ReadLoad(std::vector<SensorReading>& readings) {
+    FILETIME idle, kernel, user;
+    if (!GetSystemTimes(&idle, &kernel, &user)) return;
+
+    auto ticks = [](const FILETIME& ft) {
+        return ((unsigned long long)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    };
+    // Kernel time includes idle time
+    unsigned long long idleTime = ticks(idle);
+    unsigned long long totalTime = ticks(kernel) + ticks(user);
+    unsigned long long idleDelta = idleTime - lastIdleTime;
+    unsigned long long totalDelta = totalTime - lastTotalTime;
+    bool primed = lastTotalTime != 0;
+    lastIdleTime = idleTime;
+    lastTotalTime = totalTime;
+
+    if (!primed || totalDelta == 0 || idleDelta > totalDelta) return;
+    float load = 100.0f * (float)(totalDelta - idleDelta) / (float)totalDelta;
+    readings.push_back({ (uint16_t)loadSensor, load, SteadyNow() });
+}
+
+void TempMonitor::Sample(SensorSnapshot& snapshot, std::vector<SensorSnapshot>* between) {
+    snapshot.Clear((uint32_t)registry.Count());
+    {
+        TRACE_SCOPE("collect");
+        freshReadings.clear();
+        reads.Collect(snapshot, readDeadline, between ? &freshReadings : nullptr);
+    }
+    // Readings older than the sensor's newest one came out of a driver
+    // buffer; they become partial snapshots so history keeps every one
+    if (between) {
+        GpuSamples::Split(snapshot, freshReadings, History::Now() - SteadyNow(), *between);
+    }
+}
+
+TempLevel TempMonitor::CheckThreshold(float temp, int warningTemp, int dangerTemp) {
+    return AlertEvaluator::CheckThreshold(temp, warningTemp, dangerTemp);
+}
+
+std::wstring TempMonitor::GetTempString(const SensorSnapshot& snapshot) {
+    TRACE_SCOPE("format");
+    return SummarizeSnapshot(snapshot, registry, L" | ");
+}
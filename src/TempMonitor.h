@@ -1,43 +1,113 @@
-#pragma once
-#include <windows.h>
-#include <string>
-
-enum class TempLevel {
-    Normal,
-    Warning,
-    Danger
-};
-
-struct TempData {
-    float cpuTemp;
-    float gpuTemp;
-    int fanSpeed;
-    TempLevel level;
-    bool valid;
-};
-
-class TempMonitor {
-public:
-    TempMonitor();
-    ~TempMonitor();
-
-    bool Initialize();
-    void Shutdown();
-    
-    TempData GetCurrentTemp();
-    TempLevel CheckThreshold(float temp, int warningTemp, int dangerTemp);
-    
-    std::wstring GetTempString();
-
-private:
-    void* nvmlHandle;
-    void* gpuDevice;
-    bool nvmlInitialized;
-
-    float GetCPUTemp();
-    float GetGPUTemp();
-    int GetFanSpeed();
-    
-    bool InitNVML();
-    void ShutdownNVML();
-};
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include "Sensor.h"
+#include "PluginHost.h"
+#include "CapabilityCache.h"
+#include "GpuSamples.h"
+#include "ReadPool.h"
+#include "ProcessSampler.h"
+
+class TempMonitor {
+public:
+    TempMonitor();
+    ~TempMonitor();
+
+    // Discovers every readable sensor and registers it. With a capability
+    // file, backends found to work on this hardware before are used
+    // without probing.
+    bool Initialize(const std::wstring& capabilityPath = std::wstring());
+
+    // Returns false when a read is still hung; the monitor must then not
+    // be destroyed, since that read keeps using it
+    bool Shutdown();
+
+    const SensorRegistry& GetRegistry() const { return registry; }
+
+    // Reads all registered sensors into the snapshot. Sources are read in
+    // parallel; one that takes longer than the read deadline reports its
+    // last good values marked stale. Samples the GPU driver buffered since
+    // the previous call go into between as partial snapshots, oldest first,
+    // one per GpuSamples::kBucket ms.
+    void Sample(SensorSnapshot& snapshot, std::vector<SensorSnapshot>* between = nullptr);
+    void SetReadDeadline(int ms) { readDeadline = ms; }
+
+    // The CPU source came from the capability cache and still reads
+    bool HasCachedCPU() const { return cpuSelector.IsCachedWorking(); }
+    TempLevel CheckThreshold(float temp, int warningTemp, int dangerTemp);
+
+    std::wstring GetTempString(const SensorSnapshot& snapshot);
+
+    // Per-process GPU utilisation since the previous call; false when the
+    // driver does not support it
+    bool GetGPUProcessUtilization(std::vector<GPUProcessSample>& samples);
+
+private:
+    enum class CpuSource {
+        None,
+        AcpiThermalZone,    // MSAcpi_ThermalZoneTemperature in ROOT\WMI
+        TemperatureProbe    // Win32_TemperatureProbe in ROOT\CIMV2
+    };
+
+    struct GpuDevice {
+        void* handle;
+        int tempSensor;
+        int fanSensor;
+        int loadSensor;
+        int powerSensor;
+        int clockSensor;
+        unsigned long long processLastSeen;
+
+        // nvmlDeviceGetSamples per type: whether the driver keeps the
+        // buffer, and the newest sample taken from it (us since epoch)
+        bool buffered[GpuSamples::kTypes];
+        unsigned long long lastSeen[GpuSamples::kTypes];
+        std::vector<unsigned char> sampleBuffer;
+    };
+
+    SensorRegistry registry;
+    SourceSelector cpuSelector;   // over CpuSource, cached in capabilities.ini
+    std::vector<int> cpuSensors;
+    std::vector<float> cpuReadings;
+
+    // CPU utilisation from GetSystemTimes deltas
+    int loadSensor;
+    unsigned long long lastIdleTime;
+    unsigned long long lastTotalTime;
+
+    // IWbemServices per namespace, connected on first use
+    void* wmiServices[2];
+
+    std::wstring capabilityPath;
+
+    void* nvmlHandle;
+    bool nvmlInitialized;
+    std::vector<GpuDevice> gpus;
+    std::vector<unsigned char> gpuProcessBuffer;
+    std::vector<SensorReading> freshReadings;
+
+    PluginHost plugins;
+    ReadPool reads;
+    int readDeadline;
+    bool initialized;
+
+    bool ReadCPUTemps(CpuSource source, std::vector<float>& temps);
+    void* ConnectWMI(CpuSource source);
+    void ReleaseWMI();
+    void ReadCPU(std::vector<SensorReading>& readings);
+    void ReadGPU(GpuDevice& gpu, std::vector<SensorReading>& readings);
+    void ReadLoad(std::vector<SensorReading>& readings);
+    void ReadGPUSamples(GpuDevice& gpu, size_t type, std::vector<SensorReading>& readings);
+    bool ProbeGPUSamples(GpuDevice& gpu, size_t type);
+    void StartReads();
+    void DiscoverCPU();
+    void DiscoverGPUs();
+    float GetGPUTemp(void* device);
+    int GetFanSpeed(void* device);
+    int GetGPUUtilization(void* device);
+
+    bool InitNVML();
+    void ShutdownNVML();
+    void InitPlugins();
+};
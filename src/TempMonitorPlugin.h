@@ -0,0 +1,78 @@
+#pragma once
+/*
+ * Sensor plugin interface for Temperature Monitor.
+ *
+ * A plugin is a DLL in the "plugins" folder next to TempMonitor.exe that
+ * exports the three functions below with C linkage. The host calls
+ * tm_plugin_open() once; the plugin describes its sensors in the info
+ * struct. After that, every tick the host calls tm_plugin_read() with
+ * arrays sized to the declared sensor count, which the plugin fills in
+ * place. Nothing is allocated or passed as a string per read.
+ *
+ * Each plugin is read on its own thread of the host's read pool, alongside
+ * the built-in sensors. The host waits for a read no longer than the
+ * plugin's read_deadline_ms, or the per-tick deadline when that is 0 or
+ * longer. A read that misses its deadline leaves the plugin's last values
+ * shown as stale until the read returns, and the plugin is not read again
+ * meanwhile, so blocking reads (serial ports, USB devices) are safe.
+ */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TM_PLUGIN_ABI_VERSION 1
+
+#ifdef _WIN32
+#define TM_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define TM_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+/* Same values as SensorKind / SensorUnit in Sensor.h */
+enum {
+    TM_KIND_THERMAL_ZONE = 0,
+    TM_KIND_CPU_PACKAGE = 1,
+    TM_KIND_CPU_CORE = 2,
+    TM_KIND_GPU = 3,
+    TM_KIND_STORAGE = 4,
+    TM_KIND_VRM = 5,
+    TM_KIND_FAN = 6,
+    TM_KIND_OTHER = 7
+};
+
+enum {
+    TM_UNIT_CELSIUS = 0,
+    TM_UNIT_PERCENT = 1,
+    TM_UNIT_RPM = 2
+};
+
+#define TM_PLUGIN_MAX_SENSORS 16
+
+typedef struct tm_sensor_desc {
+    uint32_t kind;
+    uint32_t unit;
+    char key[16];     /* short unique name, e.g. "inlet"; the host may add a suffix */
+    char label[32];   /* display name */
+} tm_sensor_desc;
+
+typedef struct tm_plugin_info {
+    uint32_t abi_version;        /* set to TM_PLUGIN_ABI_VERSION */
+    uint32_t flags;              /* none defined yet; set to 0 */
+    uint32_t read_deadline_ms;   /* longest wait for a read per tick; 0 = the host's deadline */
+    uint32_t sensor_count;       /* at most TM_PLUGIN_MAX_SENSORS */
+    tm_sensor_desc sensors[TM_PLUGIN_MAX_SENSORS];
+} tm_plugin_info;
+
+/* Returns 0 on success. *context is passed back to the other calls. */
+typedef int (*tm_plugin_open_fn)(uint32_t host_abi_version, tm_plugin_info* info, void** context);
+
+/* Fills values[i] and valid[i] (0 or 1) for each declared sensor. Returns 0 on success. */
+typedef int (*tm_plugin_read_fn)(void* context, float* values, uint8_t* valid, uint32_t count);
+
+typedef void (*tm_plugin_close_fn)(void* context);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,463 @@
+#include "ThermalEvents.h"
+#include "AlertEvaluator.h"
+
+#ifdef _WIN32
+#include <comdef.h>
+#include <Wbemidl.h>
+
+#pragma comment(lib, "wbemuuid.lib")
+#else
+#include "HwmonSensors.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <cstring>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/thermal.h>
+#include <sys/socket.h>
+#endif
+#endif
+
+namespace {
+#ifdef _WIN32
+    struct ThermalClass {
+        const wchar_t* nameSpace;
+        const wchar_t* className;
+        const wchar_t* valueProperty;
+        const wchar_t* keyProperty;
+        bool kelvin;
+    };
+
+    // The same classes and conversions TempMonitor::ReadCPUTemps uses
+    const ThermalClass kClasses[2] = {
+        { L"ROOT\\WMI", L"MSAcpi_ThermalZoneTemperature", L"CurrentTemperature", L"InstanceName", true },
+        { L"ROOT\\CIMV2", L"Win32_TemperatureProbe", L"CurrentReading", L"DeviceID", false },
+    };
+#else
+#ifdef __linux__
+    // Calls visit(type, payload, length) for each netlink attribute in data
+    template <typename Visit>
+    void ForEachAttribute(const char* data, int size, Visit visit) {
+        while (size >= NLA_HDRLEN) {
+            auto attribute = (const nlattr*)data;
+            if (attribute->nla_len < NLA_HDRLEN || attribute->nla_len > size) return;
+            visit(attribute->nla_type & NLA_TYPE_MASK, data + NLA_HDRLEN, attribute->nla_len - NLA_HDRLEN);
+            int step = std::min((int)NLA_ALIGN(attribute->nla_len), size);
+            data += step;
+            size -= step;
+        }
+    }
+
+    // A socket in the thermal netlink family's event group, which reports
+    // every zone crossing a trip point; -1 on kernels without it
+    int OpenTripSocket() {
+        int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+        if (fd < 0) return -1;
+
+        struct {
+            nlmsghdr header;
+            genlmsghdr genl;
+            char attributes[NLA_HDRLEN + 16];
+        } request = {};
+        const char family[] = THERMAL_GENL_FAMILY_NAME;
+        auto name = (nlattr*)request.attributes;
+        name->nla_type = CTRL_ATTR_FAMILY_NAME;
+        name->nla_len = NLA_HDRLEN + sizeof(family);
+        memcpy(request.attributes + NLA_HDRLEN, family, sizeof(family));
+        request.header.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN + NLA_ALIGN(name->nla_len));
+        request.header.nlmsg_type = GENL_ID_CTRL;
+        request.header.nlmsg_flags = NLM_F_REQUEST;
+        request.genl.cmd = CTRL_CMD_GETFAMILY;
+        request.genl.version = 1;
+
+        sockaddr_nl kernel = {};
+        kernel.nl_family = AF_NETLINK;
+        alignas(nlmsghdr) char reply[8192];
+        ssize_t size = -1;
+        if (sendto(fd, &request, request.header.nlmsg_len, 0, (sockaddr*)&kernel, sizeof(kernel)) >= 0) {
+            size = recv(fd, reply, sizeof(reply), 0);
+        }
+
+        // The family's multicast groups are nested two deep in the reply
+        int group = -1;
+        auto header = (const nlmsghdr*)reply;
+        if (size > 0 && NLMSG_OK(header, size) && header->nlmsg_type != NLMSG_ERROR &&
+            header->nlmsg_len >= NLMSG_LENGTH(GENL_HDRLEN)) {
+            ForEachAttribute((const char*)NLMSG_DATA(header) + GENL_HDRLEN,
+                (int)(header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN)), [&](int type, const char* data, int length) {
+                if (type != CTRL_ATTR_MCAST_GROUPS) return;
+                ForEachAttribute(data, length, [&](int, const char* entry, int entryLength) {
+                    std::string groupName;
+                    int id = -1;
+                    ForEachAttribute(entry, entryLength, [&](int field, const char* value, int valueLength) {
+                        if (field == CTRL_ATTR_MCAST_GRP_NAME) groupName.assign(value, strnlen(value, valueLength));
+                        if (field == CTRL_ATTR_MCAST_GRP_ID && valueLength >= 4) memcpy(&id, value, 4);
+                    });
+                    if (groupName == THERMAL_GENL_EVENT_GROUP_NAME) group = id;
+                });
+            });
+        }
+
+        if (group < 0 || setsockopt(fd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+#endif
+#endif
+}
+
+#ifdef _WIN32
+
+// Receives event batches on WMI's threads and forwards readings to the owner
+class ThermalEvents::Sink : public IWbemObjectSink {
+public:
+    explicit Sink(ThermalEvents* events) : refs(1), owner(events) {}
+
+    void Detach() {
+        std::lock_guard<std::mutex> lock(ownerMutex);
+        owner = nullptr;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() override {
+        return InterlockedIncrement(&refs);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        LONG count = InterlockedDecrement(&refs);
+        if (count == 0) delete this;
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+        if (riid == IID_IUnknown || riid == IID_IWbemObjectSink) {
+            *ppv = (IWbemObjectSink*)this;
+            AddRef();
+            return WBEM_S_NO_ERROR;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE Indicate(LONG count, IWbemClassObject** objects) override {
+        std::lock_guard<std::mutex> lock(ownerMutex);
+        if (!owner) return WBEM_S_NO_ERROR;
+
+        for (LONG i = 0; i < count; i++) {
+            VARIANT target;
+            if (FAILED(objects[i]->Get(L"TargetInstance", 0, &target, 0, 0))) continue;
+
+            IWbemClassObject* instance = nullptr;
+            if (target.vt == VT_UNKNOWN && target.punkVal) {
+                target.punkVal->QueryInterface(IID_IWbemClassObject, (void**)&instance);
+            }
+            VariantClear(&target);
+            if (!instance) continue;
+
+            for (const auto& thermal : kClasses) {
+                if (instance->InheritsFrom(thermal.className) != WBEM_S_NO_ERROR) continue;
+
+                VARIANT value;
+                VARIANT key;
+                VariantInit(&key);
+                if (SUCCEEDED(instance->Get(thermal.valueProperty, 0, &value, 0, 0))) {
+                    if (value.vt == VT_I4 && value.lVal > 0) {
+                        float temp = thermal.kelvin ? (value.lVal / 10.0f) - 273.15f : value.lVal / 10.0f;
+                        instance->Get(thermal.keyProperty, 0, &key, 0, 0);
+                        owner->OnReading(key.vt == VT_BSTR ? key.bstrVal : L"", temp);
+                    }
+                    VariantClear(&value);
+                }
+                VariantClear(&key);
+                break;
+            }
+            instance->Release();
+        }
+        return WBEM_S_NO_ERROR;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetStatus(LONG, HRESULT, BSTR, IWbemClassObject*) override {
+        return WBEM_S_NO_ERROR;
+    }
+
+private:
+    LONG refs;
+    std::mutex ownerMutex;
+    ThermalEvents* owner;
+};
+
+#endif
+
+ThermalEvents::ThermalEvents(const std::string& hwmon, const std::string& thermal, int fallback)
+#ifdef _WIN32
+    : apartment(nullptr), services(), stubs(), sink(nullptr),
+#else
+    : hwmonRoot(hwmon), thermalRoot(thermal), fallbackMs(fallback), tripSocket(-1), stopPipe{ -1, -1 },
+#endif
+      warningTemp(0), dangerTemp(0), lastLevel((int)TempLevel::Normal), events(0), wakes(0), loops(0) {
+#ifdef _WIN32
+    (void)hwmon;
+    (void)thermal;
+    (void)fallback;
+#endif
+}
+
+ThermalEvents::~ThermalEvents() {
+    Stop();
+}
+
+void ThermalEvents::SetThresholds(int warning, int danger) {
+    warningTemp = warning;
+    dangerTemp = danger;
+}
+
+#ifdef _WIN32
+bool ThermalEvents::Start(WakeFunction wakeFunction) {
+    wake = wakeFunction;
+
+    // Callbacks go through an unsecured apartment so WMI can call back
+    // without the process setting up COM security
+    HRESULT hres = CoCreateInstance(CLSID_UnsecuredApartment, NULL, CLSCTX_LOCAL_SERVER,
+        IID_IUnsecuredApartment, (void**)&apartment);
+    if (FAILED(hres)) return false;
+
+    sink = new Sink(this);
+
+    bool subscribed = false;
+    for (size_t i = 0; i < 2; i++) {
+        subscribed = Subscribe(i) || subscribed;
+    }
+    if (!subscribed) Stop();
+    return subscribed;
+}
+
+bool ThermalEvents::Subscribe(size_t index) {
+    const ThermalClass& thermal = kClasses[index];
+
+    IWbemLocator* pLoc = nullptr;
+    HRESULT hres = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER,
+        IID_IWbemLocator, (LPVOID*)&pLoc);
+    if (FAILED(hres)) return false;
+
+    IWbemServices* pSvc = nullptr;
+    hres = pLoc->ConnectServer(_bstr_t(thermal.nameSpace), NULL, NULL, 0, NULL, 0, 0, &pSvc);
+    pLoc->Release();
+    if (FAILED(hres)) return false;
+
+    CoSetProxyBlanket(pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL,
+        RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
+
+    IUnknown* stubUnknown = nullptr;
+    IWbemObjectSink* stub = nullptr;
+    if (FAILED(apartment->CreateObjectStub(sink, &stubUnknown))) {
+        pSvc->Release();
+        return false;
+    }
+    stubUnknown->QueryInterface(IID_IWbemObjectSink, (void**)&stub);
+    stubUnknown->Release();
+
+    std::wstring query = L"SELECT * FROM __InstanceModificationEvent WITHIN " +
+        std::to_wstring(kWithinSeconds) + L" WHERE TargetInstance ISA '" + thermal.className + L"'";
+    hres = pSvc->ExecNotificationQueryAsync(_bstr_t(L"WQL"), _bstr_t(query.c_str()),
+        WBEM_FLAG_SEND_STATUS, NULL, stub);
+    if (FAILED(hres)) {
+        stub->Release();
+        pSvc->Release();
+        return false;
+    }
+
+    services[index] = pSvc;
+    stubs[index] = stub;
+    return true;
+}
+
+void ThermalEvents::Stop() {
+    for (size_t i = 0; i < 2; i++) {
+        if (services[i]) {
+            services[i]->CancelAsyncCall(stubs[i]);
+            stubs[i]->Release();
+            services[i]->Release();
+            services[i] = nullptr;
+            stubs[i] = nullptr;
+        }
+    }
+    if (sink) {
+        sink->Detach();
+        sink->Release();
+        sink = nullptr;
+    }
+    if (apartment) {
+        apartment->Release();
+        apartment = nullptr;
+    }
+}
+
+#else
+bool ThermalEvents::Start(WakeFunction wakeFunction) {
+    wake = wakeFunction;
+
+    for (const auto& input : FindHwmonInputs(hwmonRoot, thermalRoot)) {
+        if (!input.cpu) continue;
+        int fd = open(input.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        inputs.push_back(fd);
+        zones.push_back(std::wstring(input.path.begin(), input.path.end()));
+        if (input.zone >= 0) tripZones.push_back(input.zone);
+    }
+
+    char buffer[32];
+    for (const auto& path : FindHwmonAlarms(hwmonRoot)) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        // sysfs only notifies a file that has been read since it was opened
+        ssize_t size = pread(fd, buffer, sizeof(buffer), 0);
+        (void)size;
+        alarms.push_back(fd);
+    }
+    // Thermal zones report trip point crossings over netlink rather than
+    // through their files
+#ifdef __linux__
+    if (!tripZones.empty()) tripSocket = OpenTripSocket();
+#endif
+
+    if (inputs.empty() || pipe(stopPipe) != 0) {
+        Stop();
+        return false;
+    }
+    thread = std::thread(&ThermalEvents::WatchLoop, this);
+    return true;
+}
+
+void ThermalEvents::Stop() {
+    if (thread.joinable()) {
+        char stop = 0;
+        ssize_t written = write(stopPipe[1], &stop, 1);
+        (void)written;
+        thread.join();
+    }
+    for (int fd : inputs) close(fd);
+    for (int fd : alarms) close(fd);
+    if (tripSocket >= 0) close(tripSocket);
+    inputs.clear();
+    zones.clear();
+    alarms.clear();
+    tripZones.clear();
+    tripSocket = -1;
+    for (int& fd : stopPipe) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+}
+
+void ThermalEvents::ReadInputs() {
+    char buffer[32];
+    for (size_t i = 0; i < inputs.size(); i++) {
+        ssize_t size = pread(inputs[i], buffer, sizeof(buffer) - 1, 0);
+        if (size <= 0) continue;
+        buffer[size] = '\0';
+        OnReading(zones[i], atoi(buffer) / 1000.0f);   // millidegrees
+    }
+}
+
+// Only a trip crossing in one of the CPU zones is worth a read; the event
+// group also carries zone and cooling device changes
+bool ThermalEvents::IsTrip(const char* message, int size) const {
+#ifdef __linux__
+    auto header = (const nlmsghdr*)message;
+    if (size <= 0 || !NLMSG_OK(header, size) || header->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) return false;
+
+    auto genl = (const genlmsghdr*)NLMSG_DATA(header);
+    if (genl->cmd != THERMAL_GENL_EVENT_TZ_TRIP_UP && genl->cmd != THERMAL_GENL_EVENT_TZ_TRIP_DOWN) return false;
+
+    bool ours = false;
+    ForEachAttribute((const char*)genl + GENL_HDRLEN, (int)(header->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN)),
+        [&](int type, const char* data, int length) {
+        int id = -1;
+        if (type != THERMAL_GENL_ATTR_TZ_ID || length < 4) return;
+        memcpy(&id, data, 4);
+        ours = ours || std::find(tripZones.begin(), tripZones.end(), id) != tripZones.end();
+    });
+    return ours;
+#else
+    (void)message;
+    (void)size;
+    return false;
+#endif
+}
+
+void ThermalEvents::WatchLoop() {
+    std::vector<pollfd> fds;
+    fds.push_back({ stopPipe[0], POLLIN, 0 });
+    if (tripSocket >= 0) {
+        fds.push_back({ tripSocket, POLLIN, 0 });
+    }
+    for (int fd : alarms) {
+        fds.push_back({ fd, POLLPRI | POLLERR, 0 });
+    }
+    size_t firstAlarm = tripSocket >= 0 ? 2 : 1;
+
+    // The zones are read once now and then only when something fires or the
+    // fallback check is due, so a steady temperature costs one wakeup a minute
+    ReadInputs();
+    alignas(8) char message[4096];
+    for (;;) {
+        int ready = poll(fds.data(), fds.size(), fallbackMs);
+        if (ready < 0) {
+            if (errno != EINTR) break;
+            continue;
+        }
+        if (fds[0].revents) break;
+        loops++;
+
+        bool due = ready == 0;
+        if (tripSocket >= 0 && fds[1].revents) {
+            ssize_t size;
+            while ((size = recv(tripSocket, message, sizeof(message), MSG_DONTWAIT)) > 0) {
+                due = IsTrip(message, (int)size) || due;
+            }
+            // An overrun socket has dropped events that may have been trips
+            if (size < 0 && errno == ENOBUFS) due = true;
+        }
+        for (size_t i = firstAlarm; i < fds.size(); i++) {
+            if (fds[i].revents) {
+                char buffer[32];
+                ssize_t size = pread(fds[i].fd, buffer, sizeof(buffer), 0);
+                (void)size;
+                due = true;
+            }
+        }
+        if (due) ReadInputs();
+    }
+}
+#endif
+
+void ThermalEvents::OnReading(const std::wstring& zone, float temp) {
+    // The first event shows that events arrive at all
+    bool first = events++ == 0;
+    bool changed = false;
+    if (temp >= 20.0f && temp <= 100.0f) {
+        int level = (int)AlertEvaluator::CheckThreshold(temp, warningTemp, dangerTemp);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        zoneLevels[zone] = level;
+
+        int hottest = (int)TempLevel::Normal;
+        for (const auto& entry : zoneLevels) {
+            if (entry.second > hottest) hottest = entry.second;
+        }
+        changed = hottest != lastLevel;
+        lastLevel = hottest;
+    }
+
+    // Apart from that, only a level edge is worth waking the UI for
+    if (first || changed) {
+        wakes++;
+        if (wake) wake();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#define WM_THERMALEVENT (WM_USER + 2)
+
+struct IWbemServices;
+struct IWbemObjectSink;
+struct IUnsecuredApartment;
+#endif
+
+// Watches the CPU thermal zones off the UI thread. On Windows it subscribes
+// to __InstanceModificationEvent on the WMI thermal classes the CPU reading
+// comes from. Elsewhere a thread sleeps in poll() on the CPU hwmon *_alarm
+// files and, on Linux, the thermal netlink trip point events, and reads the
+// CPU temperatures only when one of them fires or the slow fallback check
+// is due. The wake function is called on the first reading and when the
+// hottest zone's threshold level changes, so the UI thread stays idle while
+// nothing interesting happens.
+class ThermalEvents {
+public:
+    // Called on a WMI or watcher thread
+    typedef std::function<void()> WakeFunction;
+
+    // The hwmon and thermal class directories and the time between checks
+    // when nothing fires; they only apply to the sysfs watcher
+    explicit ThermalEvents(const std::string& hwmonRoot = "/sys/class/hwmon",
+        const std::string& thermalRoot = "/sys/class/thermal", int fallbackMs = kFallbackSeconds * 1000);
+    ~ThermalEvents();
+
+    // False when no zone can be watched
+    bool Start(WakeFunction wake);
+    void Stop();
+
+    void SetThresholds(int warningTemp, int dangerTemp);
+
+    unsigned long long GetEventCount() const { return events.load(); }
+    unsigned long long GetWakeCount() const { return wakes.load(); }
+    // Times the sysfs watcher came out of poll() for anything but Stop
+    unsigned long long GetLoopCount() const { return loops.load(); }
+
+    // How often WMI checks the zones, since it has no event provider for
+    // the classes; no faster than the timer that events replace
+    static constexpr int kWithinSeconds = 2;
+    // How often the sysfs watcher reads the zones without an alarm or trip,
+    // for sensors that have neither
+    static constexpr int kFallbackSeconds = 60;
+
+private:
+#ifdef _WIN32
+    class Sink;
+    friend class Sink;
+
+    IUnsecuredApartment* apartment;
+    IWbemServices* services[2];
+    IWbemObjectSink* stubs[2];
+    Sink* sink;
+
+    bool Subscribe(size_t index);
+#else
+    std::string hwmonRoot;
+    std::string thermalRoot;
+    int fallbackMs;
+    std::vector<int> inputs;           // CPU hwmon temp*_input and thermal zone temp
+    std::vector<std::wstring> zones;   // their paths
+    std::vector<int> alarms;           // the hwmon devices' *_alarm files
+    std::vector<int> tripZones;        // thermal zone numbers
+    int tripSocket;                    // thermal netlink events, -1 without
+    int stopPipe[2];
+    std::thread thread;
+
+    void ReadInputs();
+    bool IsTrip(const char* message, int size) const;
+    void WatchLoop();
+#endif
+
+    WakeFunction wake;
+    std::atomic<int> warningTemp;
+    std::atomic<int> dangerTemp;
+
+    std::mutex mutex;
+    std::map<std::wstring, int> zoneLevels;
+    int lastLevel;
+    std::atomic<unsigned long long> events;
+    std::atomic<unsigned long long> wakes;
+    std::atomic<unsigned long long> loops;
+
+    void OnReading(const std::wstring& zone, float temp);
+};
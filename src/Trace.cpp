@@ -0,0 +1,126 @@
+#include "Trace.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+std::atomic<bool> Trace::enabled(false);
+
+namespace {
+    struct Event {
+        const char* name;
+        int64_t time;    // microseconds, steady clock
+        char phase;      // 'B' or 'E'
+    };
+
+    struct Ring {
+        uint32_t tid;
+        std::atomic<uint64_t> head;
+        Event events[Trace::kEventsPerThread];
+    };
+
+    // Rings are never freed: a thread may exit while its events are written
+    std::mutex ringsMutex;
+    std::vector<Ring*> rings;
+    uint32_t nextTid = 1;
+
+    thread_local Ring* localRing = nullptr;
+
+    Ring* GetRing() {
+        if (!localRing) {
+            Ring* ring = new Ring();
+            ring->head.store(0, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            ring->tid = nextTid++;
+            rings.push_back(ring);
+            localRing = ring;
+        }
+        return localRing;
+    }
+
+    int64_t NowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Record(const char* name, char phase) {
+        Ring* ring = GetRing();
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        Event& event = ring->events[head % Trace::kEventsPerThread];
+        event.name = name;
+        event.time = NowMicros();
+        event.phase = phase;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    // Events of one ring that were not overwritten while being copied. The
+    // writer fills slot head % kEventsPerThread before publishing head + 1,
+    // so the oldest slot may be half written and is dropped as well.
+    void CopyRing(const Ring& ring, std::vector<Event>& out) {
+        out.clear();
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        uint64_t first = head > Trace::kEventsPerThread ? head - Trace::kEventsPerThread : 0;
+        for (uint64_t i = first; i < head; i++) {
+            out.push_back(ring.events[i % Trace::kEventsPerThread]);
+        }
+
+        uint64_t after = ring.head.load(std::memory_order_acquire);
+        uint64_t valid = after >= Trace::kEventsPerThread ? after - Trace::kEventsPerThread + 1 : 0;
+        if (valid > first) {
+            out.erase(out.begin(), out.begin() + (size_t)std::min<uint64_t>(valid - first, out.size()));
+        }
+    }
+}
+
+void Trace::SetEnabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void Trace::Begin(const char* name) {
+    Record(name, 'B');
+}
+
+void Trace::End(const char* name) {
+    Record(name, 'E');
+}
+
+bool Trace::WriteJson(const std::wstring& path) {
+    std::vector<Ring*> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        snapshot = rings;
+    }
+
+    std::ofstream out(fs::path(path), std::ios::trunc);
+    if (!out) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    std::vector<Event> events;
+
+    for (const Ring* ring : snapshot) {
+        CopyRing(*ring, events);
+
+        // An end whose begin was already overwritten would unbalance the thread
+        int depth = 0;
+        for (const Event& event : events) {
+            if (event.phase == 'E') {
+                if (depth == 0) continue;
+                depth--;
+            } else {
+                depth++;
+            }
+
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << event.time << ",\"pid\":1,\"tid\":" << ring->tid << "}";
+        }
+    }
+    out << "\n]}\n";
+    return (bool)out;
+}
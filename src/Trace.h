@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Timeline of begin/end events per pipeline stage, written as Chrome
+// trace-event JSON (chrome://tracing, ui.perfetto.dev). Each thread records
+// into its own fixed ring, so recording takes no locks and old events are
+// overwritten. With tracing off, a scope costs one relaxed load and branch.
+namespace Trace {
+    extern std::atomic<bool> enabled;
+
+    inline bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool on);
+
+    // Names must be string literals; only the pointer is stored
+    void Begin(const char* name);
+    void End(const char* name);
+
+    // Writes every event still in the rings; false when the file can't be written
+    bool WriteJson(const std::wstring& path);
+
+    const size_t kEventsPerThread = 16384;
+
+    class Scope {
+    public:
+        explicit Scope(const char* stage) : name(IsEnabled() ? stage : nullptr) {
+            if (name) Begin(name);
+        }
+        ~Scope() {
+            if (name) End(name);
+        }
+
+    private:
+        const char* name;
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
@@ -1,70 +1,155 @@
-#include "TrayIcon.h"
-#include "resource.h"
-
-TrayIcon::TrayIcon(HWND hwnd, TempMonitor* mon)
-    : hwnd(hwnd), monitor(mon), hIcon(nullptr) {
-    ZeroMemory(&nid, sizeof(nid));
-}
-
-TrayIcon::~TrayIcon() {
-    Remove();
-}
-
-bool TrayIcon::Create(HINSTANCE hInstance) {
-    hIcon = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_APPICON));
-    if (!hIcon) {
-        hIcon = LoadIcon(NULL, IDI_APPLICATION);
-    }
-
-    nid.cbSize = sizeof(NOTIFYICONDATAW);
-    nid.hWnd = hwnd;
-    nid.uID = 1;
-    nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
-    nid.uCallbackMessage = WM_TRAYICON;
-    nid.hIcon = hIcon;
-    wcscpy_s(nid.szTip, L"Temperature Monitor");
-
-    return Shell_NotifyIconW(NIM_ADD, &nid);
-}
-
-void TrayIcon::Remove() {
-    if (nid.hWnd) {
-        Shell_NotifyIconW(NIM_DELETE, &nid);
-        nid.hWnd = NULL;
-    }
-    if (hIcon) {
-        DestroyIcon(hIcon);
-        hIcon = nullptr;
-    }
-}
-
-void TrayIcon::UpdateTooltip(const std::wstring& text) {
-    if (text.length() < 128) {
-        wcscpy_s(nid.szTip, text.c_str());
-        Shell_NotifyIconW(NIM_MODIFY, &nid);
-    }
-}
-
-void TrayIcon::ShowContextMenu() {
-    POINT pt;
-    GetCursorPos(&pt);
-
-    HMENU hMenu = CreatePopupMenu();
-    AppendMenuW(hMenu, MF_STRING, ID_TRAY_SETTINGS, L"Settings");
-    AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
-    AppendMenuW(hMenu, MF_STRING, ID_TRAY_EXIT, L"Exit");
-
-    SetForegroundWindow(hwnd);
-    TrackPopupMenu(hMenu, TPM_BOTTOMALIGN | TPM_LEFTALIGN, pt.x, pt.y, 0, hwnd, NULL);
-    DestroyMenu(hMenu);
-}
-
-LRESULT TrayIcon::HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam) {
-    if (uMsg == WM_TRAYICON) {
-        if (lParam == WM_RBUTTONUP) {
-            ShowContextMenu();
-            return 0;
-        }
-    }
-    return 0;
-}
+#include "TrayIcon.h"
+#include "IconRasterizer.h"
+#include "resource.h"
+#include "Trace.h"
+#include <vector>
+
+TrayIcon::TrayIcon(HWND hwnd, TempMonitor* mon)
+    : hwnd(hwnd), monitor(mon), hIcon(nullptr), currentIcon(nullptr) {
+    ZeroMemory(&nid, sizeof(nid));
+}
+
+TrayIcon::~TrayIcon() {
+    Remove();
+}
+
+bool TrayIcon::Create(HINSTANCE hInstance) {
+    hIcon = LoadIcon(hInstance, MAKEINTRESOURCE(IDI_APPICON));
+    if (!hIcon) {
+        hIcon = LoadIcon(NULL, IDI_APPLICATION);
+    }
+
+    nid.cbSize = sizeof(NOTIFYICONDATAW);
+    nid.hWnd = hwnd;
+    nid.uID = 1;
+    nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+    nid.uCallbackMessage = WM_TRAYICON;
+    nid.hIcon = hIcon;
+    currentIcon = hIcon;
+    wcscpy_s(nid.szTip, L"Temperature Monitor");
+
+    return Shell_NotifyIconW(NIM_ADD, &nid);
+}
+
+void TrayIcon::Remove() {
+    if (nid.hWnd) {
+        Shell_NotifyIconW(NIM_DELETE, &nid);
+        nid.hWnd = NULL;
+    }
+    if (hIcon) {
+        DestroyIcon(hIcon);
+        hIcon = nullptr;
+    }
+    for (auto& entry : iconCache) {
+        DestroyIcon(entry.second);
+    }
+    iconCache.clear();
+    currentIcon = nullptr;
+}
+
+void TrayIcon::UpdateTooltip(const std::wstring& text) {
+    if (text.length() < 128 && text != nid.szTip) {
+        wcscpy_s(nid.szTip, text.c_str());
+        Shell_NotifyIconW(NIM_MODIFY, &nid);
+    }
+}
+
+void TrayIcon::Update(const std::wstring& tooltip, int value, TempLevel level) {
+    TRACE_SCOPE("tray update");
+    HICON icon = GetValueIcon(value, level);
+    if (!icon) icon = hIcon;
+
+    std::wstring tip = tooltip.substr(0, 127);
+    bool changed = false;
+
+    if (icon != currentIcon) {
+        nid.hIcon = icon;
+        currentIcon = icon;
+        changed = true;
+    }
+    if (tip != nid.szTip) {
+        wcscpy_s(nid.szTip, tip.c_str());
+        changed = true;
+    }
+
+    if (changed) {
+        Shell_NotifyIconW(NIM_MODIFY, &nid);
+    }
+}
+
+HICON TrayIcon::GetValueIcon(int value, TempLevel level) {
+    if (value < 0 || value > 999) value = -1;
+    int key = (value + 1) * 4 + (int)level;
+
+    auto it = iconCache.find(key);
+    if (it != iconCache.end()) {
+        return it->second;
+    }
+
+    int size = GetSystemMetrics(SM_CXSMICON);
+    std::vector<uint32_t> pixels(size * size);
+    IconRasterizer::Render(value, level, size, pixels.data());
+
+    BITMAPV5HEADER bi = {};
+    bi.bV5Size = sizeof(bi);
+    bi.bV5Width = size;
+    bi.bV5Height = -size;  // top-down, matching the rasterizer
+    bi.bV5Planes = 1;
+    bi.bV5BitCount = 32;
+    bi.bV5Compression = BI_BITFIELDS;
+    bi.bV5RedMask = 0x00FF0000;
+    bi.bV5GreenMask = 0x0000FF00;
+    bi.bV5BlueMask = 0x000000FF;
+    bi.bV5AlphaMask = 0xFF000000;
+
+    void* bits = nullptr;
+    HDC hdc = GetDC(NULL);
+    HBITMAP color = CreateDIBSection(hdc, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &bits, NULL, 0);
+    ReleaseDC(NULL, hdc);
+    if (!color) return nullptr;
+    memcpy(bits, pixels.data(), pixels.size() * sizeof(uint32_t));
+
+    // The alpha channel does the masking; the monochrome mask is unused
+    HBITMAP mask = CreateBitmap(size, size, 1, 1, NULL);
+
+    ICONINFO ii = {};
+    ii.fIcon = TRUE;
+    ii.hbmColor = color;
+    ii.hbmMask = mask;
+    HICON icon = CreateIconIndirect(&ii);
+
+    DeleteObject(color);
+    DeleteObject(mask);
+
+    if (icon) {
+        iconCache[key] = icon;
+    }
+    return icon;
+}
+
+void TrayIcon::ShowContextMenu() {
+    POINT pt;
+    GetCursorPos(&pt);
+
+    HMENU hMenu = CreatePopupMenu();
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_SETTINGS, L"Settings");
+    if (Trace::IsEnabled()) {
+        AppendMenuW(hMenu, MF_STRING, ID_TRAY_SAVE_TRACE, L"Save Trace");
+    }
+    AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_EXIT, L"Exit");
+
+    SetForegroundWindow(hwnd);
+    TrackPopupMenu(hMenu, TPM_BOTTOMALIGN | TPM_LEFTALIGN, pt.x, pt.y, 0, hwnd, NULL);
+    DestroyMenu(hMenu);
+}
+
+LRESULT TrayIcon::HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    if (uMsg == WM_TRAYICON) {
+        if (lParam == WM_RBUTTONUP) {
+            ShowContextMenu();
+            return 0;
+        }
+    }
+    return 0;
+}
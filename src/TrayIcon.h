@@ -1,27 +1,36 @@
-#pragma once
-#include <windows.h>
-#include <shellapi.h>
-#include "TempMonitor.h"
-
-#define WM_TRAYICON (WM_USER + 1)
-#define ID_TRAY_SETTINGS 1001
-#define ID_TRAY_EXIT 1002
-
-class TrayIcon {
-public:
-    TrayIcon(HWND hwnd, TempMonitor* monitor);
-    ~TrayIcon();
-
-    bool Create(HINSTANCE hInstance);
-    void Remove();
-    void UpdateTooltip(const std::wstring& text);
-    LRESULT HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam);
-
-private:
-    HWND hwnd;
-    TempMonitor* monitor;
-    NOTIFYICONDATAW nid;
-    HICON hIcon;
-
-    void ShowContextMenu();
-};
+#pragma once
+#include <windows.h>
+#include <shellapi.h>
+#include <map>
+#include "TempMonitor.h"
+
+#define WM_TRAYICON (WM_USER + 1)
+#define ID_TRAY_SETTINGS 1001
+#define ID_TRAY_EXIT 1002
+#define ID_TRAY_SAVE_TRACE 1003
+
+class TrayIcon {
+public:
+    TrayIcon(HWND hwnd, TempMonitor* monitor);
+    ~TrayIcon();
+
+    bool Create(HINSTANCE hInstance);
+    void Remove();
+    void UpdateTooltip(const std::wstring& text);
+
+    // Shows the temperature in the icon itself. Icons are rendered once per
+    // (value, level) pair; Shell_NotifyIcon is only called on a change.
+    void Update(const std::wstring& tooltip, int value, TempLevel level);
+    LRESULT HandleMessage(UINT uMsg, WPARAM wParam, LPARAM lParam);
+
+private:
+    HWND hwnd;
+    TempMonitor* monitor;
+    NOTIFYICONDATAW nid;
+    HICON hIcon;
+    HICON currentIcon;
+    std::map<int, HICON> iconCache;
+
+    HICON GetValueIcon(int value, TempLevel level);
+    void ShowContextMenu();
+};
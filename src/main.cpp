@@ -1,185 +1,498 @@
-#include "Config.h"
-#include "TempMonitor.h"
-#include "FloatingWindow.h"
-#include "TrayIcon.h"
-#include "SettingsDialog.h"
-#include "resource.h"
-#include <gdiplus.h>
-#include <string>
-
-#pragma comment(lib, "gdiplus.lib")
-
-using namespace Gdiplus;
-
-// Global variables
-HINSTANCE g_hInstance = nullptr;
-Config* g_config = nullptr;
-TempMonitor* g_monitor = nullptr;
-FloatingWindow* g_floatingWindow = nullptr;
-TrayIcon* g_trayIcon = nullptr;
-HWND g_hwndMain = nullptr;
-bool g_windowShown = false;
-float g_lastMaxTemp = 0.0f;
-
-const int TIMER_UPDATE = 1;
-const int UPDATE_INTERVAL = 2000; // 2 seconds
-
-LRESULT CALLBACK MainWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-void OnTimer();
-void OnSettings();
-void OnExit();
-
-int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow) {
-    // Ensure single instance
-    HANDLE hMutex = CreateMutexW(NULL, TRUE, L"TempMonitorSingleInstanceMutex");
-    if (GetLastError() == ERROR_ALREADY_EXISTS) {
-        CloseHandle(hMutex);
-        return 0;
-    }
-
-    g_hInstance = hInstance;
-
-    // Initialize GDI+
-    GdiplusStartupInput gdiplusStartupInput;
-    ULONG_PTR gdiplusToken;
-    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
-
-    // Create main window (hidden)
-    const wchar_t CLASS_NAME[] = L"TempMonitorMainWindow";
-
-    WNDCLASSW wc = {};
-    wc.lpfnWndProc = MainWindowProc;
-    wc.hInstance = hInstance;
-    wc.lpszClassName = CLASS_NAME;
-
-    RegisterClassW(&wc);
-
-    g_hwndMain = CreateWindowExW(
-        0, CLASS_NAME, L"Temperature Monitor",
-        WS_OVERLAPPEDWINDOW,
-        CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
-        NULL, NULL, hInstance, NULL
-    );
-
-    if (!g_hwndMain) {
-        GdiplusShutdown(gdiplusToken);
-        CloseHandle(hMutex);
-        return 0;
-    }
-
-    // Initialize components
-    g_config = new Config();
-    g_config->Load();
-
-    g_monitor = new TempMonitor();
-    g_monitor->Initialize();
-
-    g_floatingWindow = new FloatingWindow(g_config, g_monitor);
-    g_floatingWindow->Create(hInstance);
-
-    g_trayIcon = new TrayIcon(g_hwndMain, g_monitor);
-    g_trayIcon->Create(hInstance);
-
-    // Start update timer
-    SetTimer(g_hwndMain, TIMER_UPDATE, UPDATE_INTERVAL, NULL);
-
-    // Message loop
-    MSG msg = {};
-    while (GetMessage(&msg, NULL, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
-    }
-
-    // Cleanup
-    KillTimer(g_hwndMain, TIMER_UPDATE);
-    
-    delete g_trayIcon;
-    delete g_floatingWindow;
-    delete g_monitor;
-    delete g_config;
-
-    GdiplusShutdown(gdiplusToken);
-    CloseHandle(hMutex);
-
-    return 0;
-}
-
-LRESULT CALLBACK MainWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
-    switch (uMsg) {
-    case WM_TIMER:
-        if (wParam == TIMER_UPDATE) {
-            OnTimer();
-        }
-        return 0;
-
-    case WM_COMMAND:
-        if (LOWORD(wParam) == ID_TRAY_SETTINGS) {
-            OnSettings();
-        } else if (LOWORD(wParam) == ID_TRAY_EXIT) {
-            OnExit();
-        }
-        return 0;
-
-    case WM_TRAYICON:
-        return g_trayIcon->HandleMessage(uMsg, wParam, lParam);
-
-    case WM_DESTROY:
-        PostQuitMessage(0);
-        return 0;
-    }
-
-    return DefWindowProc(hwnd, uMsg, wParam, lParam);
-}
-
-void OnTimer() {
-    TempData data = g_monitor->GetCurrentTemp();
-    
-    if (!data.valid) return;
-
-    int warningTemp = g_config->GetWarningTemp();
-    int dangerTemp = g_config->GetDangerTemp();
-
-    // Update tray tooltip
-    std::wstring tooltipText = g_monitor->GetTempString();
-    g_trayIcon->UpdateTooltip(tooltipText);
-
-    // Check thresholds
-    float maxTemp = (data.cpuTemp > data.gpuTemp) ? data.cpuTemp : data.gpuTemp;
-    
-    TempLevel cpuLevel = g_monitor->CheckThreshold(data.cpuTemp, warningTemp, dangerTemp);
-    TempLevel gpuLevel = g_monitor->CheckThreshold(data.gpuTemp, warningTemp, dangerTemp);
-    TempLevel maxLevel = (cpuLevel > gpuLevel) ? cpuLevel : gpuLevel;
-
-    data.level = maxLevel;
-
-    // Show/hide floating window based on threshold
-    if (maxTemp >= warningTemp) {
-        if (!g_windowShown) {
-            g_floatingWindow->Show();
-            g_windowShown = true;
-            g_lastMaxTemp = maxTemp;
-        }
-        g_floatingWindow->UpdateTemp(data, warningTemp, dangerTemp);
-        if (maxTemp > g_lastMaxTemp) {
-            g_lastMaxTemp = maxTemp;
-        }
-    } else if (g_windowShown && maxTemp < (warningTemp - 5.0f)) {
-        g_floatingWindow->Hide();
-        g_windowShown = false;
-        g_lastMaxTemp = 0.0f;
-    } else if (g_windowShown) {
-        g_floatingWindow->UpdateTemp(data, warningTemp, dangerTemp);
-    }
-}
-
-void OnSettings() {
-    SettingsDialog dialog(g_config);
-    dialog.Show(g_hwndMain, g_hInstance);
-}
-
-void OnExit() {
-    if (g_floatingWindow && g_floatingWindow->IsVisible()) {
-        g_floatingWindow->SavePosition();
-    }
-    DestroyWindow(g_hwndMain);
-}
+#include "Config.h"
+#include "TempMonitor.h"
+#include "FloatingWindow.h"
+#include "TrayIcon.h"
+#include "SettingsDialog.h"
+#include "History.h"
+#include "AlertEvaluator.h"
+#include "BaselineModel.h"
+#include "ActionDispatcher.h"
+#include "ProcessSampler.h"
+#include "SampleBus.h"
+#include "FlightRecorder.h"
+#include "LiveStream.h"
+#include "ThermalEvents.h"
+#include "Trace.h"
+#include "Cli.h"
+#include "resource.h"
+#include <gdiplus.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#pragma comment(lib, "gdiplus.lib")
+
+using namespace Gdiplus;
+
+const int TIMER_UPDATE = 1;
+const int UPDATE_INTERVAL = 2000; // 2 seconds
+const int EVENT_FALLBACK_INTERVAL = 30000; // polling while thermal events drive updates
+const int TRACE_OVERRUN_INTERVAL = 60000; // at most one automatic trace dump per minute
+const int BASELINE_SAVE_INTERVAL = 3600 * 1000; // a crash loses at most an hour of learning
+const size_t BUS_CAPACITY = 1024; // snapshots; each is about 1 KB
+
+// Global variables
+HINSTANCE g_hInstance = nullptr;
+Config* g_config = nullptr;
+TempMonitor* g_monitor = nullptr;
+FloatingWindow* g_floatingWindow = nullptr;
+TrayIcon* g_trayIcon = nullptr;
+History* g_history = nullptr;
+AlertEvaluator* g_evaluator = nullptr;
+BaselineModel* g_baseline = nullptr;
+ActionDispatcher* g_actions = nullptr;
+ProcessSampler* g_processes = nullptr;
+SampleBus* g_bus = nullptr;
+SinkWorker* g_historySink = nullptr;
+SinkWorker* g_actionSink = nullptr;
+LiveStream* g_stream = nullptr;
+ThermalEvents* g_events = nullptr;
+FlightRecorder* g_flight = nullptr;
+AlertEvaluator* g_flightEvaluator = nullptr;
+int g_flightTicks = 0;
+int g_flightTicksPerUpdate = 1;
+int g_tickInterval = UPDATE_INTERVAL;
+ULONGLONG g_lastTraceDump = 0;
+ULONGLONG g_lastBaselineSave = 0;
+std::atomic<int> g_warningTemp(0);
+std::atomic<int> g_dangerTemp(0);
+std::wstring g_consumers;
+std::wstring g_degraded;
+bool g_degradedSensors[kMaxSensors] = {};
+SensorSnapshot g_snapshot;
+std::vector<SensorSnapshot> g_between;
+HWND g_hwndMain = nullptr;
+
+LRESULT CALLBACK MainWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+void OnTimer();
+void OnSettings();
+void OnSaveTrace();
+void OnExit();
+void StartSinks();
+void StopSinks();
+
+int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow) {
+    // Command line subcommands run without the tray UI
+    int exitCode = 0;
+    if (RunCommandLine(pCmdLine, exitCode)) {
+        return exitCode;
+    }
+
+    // Ensure single instance
+    HANDLE hMutex = CreateMutexW(NULL, TRUE, L"TempMonitorSingleInstanceMutex");
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(hMutex);
+        return 0;
+    }
+
+    g_hInstance = hInstance;
+
+    // Initialize GDI+
+    GdiplusStartupInput gdiplusStartupInput;
+    ULONG_PTR gdiplusToken;
+    GdiplusStartup(&gdiplusToken, &gdiplusStartupInput, NULL);
+
+    // Create main window (hidden)
+    const wchar_t CLASS_NAME[] = L"TempMonitorMainWindow";
+
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = MainWindowProc;
+    wc.hInstance = hInstance;
+    wc.lpszClassName = CLASS_NAME;
+
+    RegisterClassW(&wc);
+
+    g_hwndMain = CreateWindowExW(
+        0, CLASS_NAME, L"Temperature Monitor",
+        WS_OVERLAPPEDWINDOW,
+        CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
+        NULL, NULL, hInstance, NULL
+    );
+
+    if (!g_hwndMain) {
+        GdiplusShutdown(gdiplusToken);
+        CloseHandle(hMutex);
+        return 0;
+    }
+
+    // Initialize components
+    g_config = new Config();
+    g_config->Load();
+    Trace::SetEnabled(g_config->GetTrace());
+
+    g_monitor = new TempMonitor();
+    g_monitor->Initialize(g_config->GetCapabilityPath());
+
+    g_processes = new ProcessSampler(g_monitor);
+    g_processes->Initialize();
+
+    g_evaluator = new AlertEvaluator();
+    g_baseline = new BaselineModel(g_monitor->GetRegistry());
+    g_baseline->Load(g_config->GetBaselinePath());
+    g_lastBaselineSave = GetTickCount64();
+    g_actions = new ActionDispatcher();
+    g_actions->Start(g_config->GetConfigPath());
+    g_history = new History(g_config->GetHistoryDir(), g_monitor->GetRegistry().GetKeys());
+    StartSinks();
+
+    g_floatingWindow = new FloatingWindow(g_config, g_monitor);
+    g_floatingWindow->Create(hInstance);
+
+    g_trayIcon = new TrayIcon(g_hwndMain, g_monitor);
+    g_trayIcon->Create(hInstance);
+
+    // The flight recorder samples at its own, higher rate; everything
+    // else still runs every UPDATE_INTERVAL
+    int tickInterval = UPDATE_INTERVAL;
+    if (g_config->GetFlightRecorder()) {
+        tickInterval = g_config->GetFlightInterval();
+        g_flightTicksPerUpdate = (UPDATE_INTERVAL + tickInterval - 1) / tickInterval;
+        g_flightTicks = g_flightTicksPerUpdate - 1;
+        g_monitor->SetReadDeadline(tickInterval / 2);
+        g_flight = new FlightRecorder(g_config->GetFlightDir(), g_monitor->GetRegistry().GetKeys(),
+            tickInterval, g_config->GetFlightPreTrigger() * 1000LL, g_config->GetFlightPostTrigger() * 1000LL);
+        g_flightEvaluator = new AlertEvaluator();
+    } else if (g_config->GetEventDriven()) {
+        // Thermal events wake the UI on level changes; once they are known
+        // to work, UpdateTickInterval slows the timer down
+        g_events = new ThermalEvents();
+        g_events->SetThresholds(g_config->GetWarningTemp(), g_config->GetDangerTemp());
+        if (!g_events->Start([] { PostMessage(g_hwndMain, WM_THERMALEVENT, 0, 0); })) {
+            delete g_events;
+            g_events = nullptr;
+        }
+    }
+
+    // Start update timer
+    g_tickInterval = tickInterval;
+    SetTimer(g_hwndMain, TIMER_UPDATE, tickInterval, NULL);
+
+    // Message loop
+    MSG msg = {};
+    while (GetMessage(&msg, NULL, 0, 0)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+
+    // Cleanup
+    KillTimer(g_hwndMain, TIMER_UPDATE);
+    StopSinks();
+
+    delete g_events;
+    delete g_flight;
+    delete g_flightEvaluator;
+    delete g_history;
+    delete g_actions;
+    delete g_evaluator;
+    delete g_baseline;
+    delete g_processes;
+    delete g_trayIcon;
+    delete g_floatingWindow;
+    // A read hung in a driver still uses the monitor; leave it to process exit
+    if (g_monitor->Shutdown()) delete g_monitor;
+    delete g_config;
+
+    GdiplusShutdown(gdiplusToken);
+    CloseHandle(hMutex);
+
+    return 0;
+}
+
+LRESULT CALLBACK MainWindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    switch (uMsg) {
+    case WM_TIMER:
+        if (wParam == TIMER_UPDATE) {
+            OnTimer();
+        }
+        return 0;
+
+    case WM_COMMAND:
+        if (LOWORD(wParam) == ID_TRAY_SETTINGS) {
+            OnSettings();
+        } else if (LOWORD(wParam) == ID_TRAY_SAVE_TRACE) {
+            OnSaveTrace();
+        } else if (LOWORD(wParam) == ID_TRAY_EXIT) {
+            OnExit();
+        }
+        return 0;
+
+    case WM_THERMALEVENT:
+        OnTimer();
+        return 0;
+
+    case WM_TRAYICON:
+        return g_trayIcon->HandleMessage(uMsg, wParam, lParam);
+
+    case WM_DESTROY:
+        PostQuitMessage(0);
+        return 0;
+    }
+
+    return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
+static std::string ToUtf8(const std::wstring& text) {
+    int size = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), NULL, 0, NULL, NULL);
+    std::string result(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), &result[0], size, NULL, NULL);
+    return result;
+}
+
+// Slow consumers get their own thread and read the bus at their own pace,
+// so disk or action latency never delays the next acquisition
+void StartSinks() {
+    // Deep enough for over half an hour of ticks, or several minutes of
+    // buffered GPU partials, before a stalled writer loses anything
+    g_bus = new SampleBus(BUS_CAPACITY);
+
+    // Dashboards only need the latest values. The stream's sink is added
+    // here, before any worker starts polling the bus.
+    int port = g_config->GetStreamPort();
+    if (port > 0) {
+        g_stream = new LiveStream(*g_bus, g_monitor->GetRegistry());
+    }
+
+    // A stalled disk never holds up sampling: the writer catches up from
+    // the oldest snapshot still in the ring
+    g_historySink = new SinkWorker(*g_bus, SinkPolicy::DropOldest, [](const SensorSnapshot& snapshot) {
+        float values[kMaxSensors];
+        for (uint32_t i = 0; i < snapshot.count; i++) {
+            values[i] = snapshot.valid[i] ? snapshot.values[i] : NAN;
+        }
+        TRACE_SCOPE("history append");
+        g_history->Append(snapshot.time, values);
+    });
+
+    // Crossings are detected between consecutive samples, so skipping
+    // only the oldest keeps edges as intact as possible
+    g_actionSink = new SinkWorker(*g_bus, SinkPolicy::DropOldest, [](const SensorSnapshot& snapshot) {
+        if (snapshot.partial) return;
+        TRACE_SCOPE("actions");
+        g_actions->OnSample(snapshot, g_monitor->GetRegistry(), g_warningTemp, g_dangerTemp);
+    });
+
+    if (g_stream && !g_stream->Start((unsigned short)port)) {
+        delete g_stream;
+        g_stream = nullptr;
+    }
+}
+
+void StopSinks() {
+    if (g_historySink) g_historySink->Stop();
+    if (g_actionSink) g_actionSink->Stop();
+    if (g_stream) g_stream->Stop();
+
+    delete g_stream;
+    delete g_historySink;
+    delete g_actionSink;
+    delete g_bus;
+    g_historySink = nullptr;
+    g_actionSink = nullptr;
+    g_stream = nullptr;
+    g_bus = nullptr;
+}
+
+// Runs every high-rate tick: records the sample and starts a capture when
+// the hottest sensor crosses a threshold upwards
+static bool RecordFlight(const SensorRegistry& registry) {
+    g_flight->Record(g_snapshot);
+
+    if (HottestSensor(g_snapshot, registry) >= 0) {
+        AlertDecision decision = g_flightEvaluator->Evaluate(g_snapshot, registry,
+            g_config->GetWarningTemp(), g_config->GetDangerTemp());
+        if (decision.level > decision.previousLevel) {
+            std::string reason = (decision.level == TempLevel::Danger) ? "danger " : "warning ";
+            g_flight->Trigger(g_snapshot.time, reason + registry.Get(decision.hottestSensor).key);
+        }
+    }
+
+    if (++g_flightTicks < g_flightTicksPerUpdate) return false;
+    g_flightTicks = 0;
+    return true;
+}
+
+// Logs sensors whose cooling the baseline model started or stopped
+// flagging and rebuilds the tooltip line naming them
+static void UpdateDegraded(const SensorRegistry& registry) {
+    g_degraded.clear();
+    for (uint32_t i = 0; i < registry.Count(); i++) {
+        const SensorInfo& info = registry.Get(i);
+        bool degraded = g_baseline->IsDegraded(i);
+        if (degraded) {
+            wchar_t excess[32];
+            swprintf_s(excess, L" +%.0f\u00B0C", g_baseline->GetExcess(i));
+            g_degraded += (g_degraded.empty() ? L"Cooling degraded: " : L", ") +
+                std::wstring(info.label, info.label + strlen(info.label)) + excess;
+        }
+
+        if (degraded != g_degradedSensors[i]) {
+            g_degradedSensors[i] = degraded;
+            char line[64];
+            snprintf(line, sizeof(line), "%s\t%s\t%+.1f", degraded ? "degraded" : "recovered",
+                info.key, g_baseline->GetExcess(i));
+            g_history->AppendEvent(History::Now(), line);
+        }
+    }
+}
+
+// With thermal events the timer only keeps the display, history and GPU
+// readings from going stale. It slows down once an event has arrived from
+// a CPU source the capability cache knows to work, and never while the
+// window shows live values.
+static void UpdateTickInterval() {
+    if (!g_events) return;
+
+    bool relaxed = g_events->GetEventCount() > 0 && g_monitor->HasCachedCPU() &&
+        !g_floatingWindow->IsVisible();
+    int interval = relaxed ? EVENT_FALLBACK_INTERVAL : UPDATE_INTERVAL;
+    if (interval != g_tickInterval) {
+        g_tickInterval = interval;
+        SetTimer(g_hwndMain, TIMER_UPDATE, interval, NULL);
+    }
+}
+
+static void Tick() {
+    TRACE_SCOPE("tick");
+    {
+        TRACE_SCOPE("sample");
+        // The flight recorder decimates ticks, so it has no use for readings between them
+        g_monitor->Sample(g_snapshot, g_flight ? nullptr : &g_between);
+    }
+    g_snapshot.time = History::Now();
+    const SensorRegistry& registry = g_monitor->GetRegistry();
+
+    if (g_flight && !RecordFlight(registry)) return;
+
+    // Per-process CPU time has to be diffed every tick to be ready on a rise
+    g_processes->Sample();
+
+    int warningTemp = g_config->GetWarningTemp();
+    int dangerTemp = g_config->GetDangerTemp();
+    g_warningTemp = warningTemp;
+    g_dangerTemp = dangerTemp;
+    if (g_events) {
+        g_events->SetThresholds(warningTemp, dangerTemp);
+    }
+
+    // One acquisition per tick, fanned out to every sink
+    {
+        TRACE_SCOPE("publish");
+        // Buffered GPU samples go out first, in time order, so history
+        // keeps them at their own timestamps. Those from a read that
+        // missed an earlier tick's deadline are older than that tick;
+        // history sorts them into place.
+        for (const auto& partial : g_between) {
+            if (partial.time < g_snapshot.time) {
+                g_bus->Publish(partial);
+            }
+        }
+        g_bus->Publish(g_snapshot);
+    }
+
+    // Flags sensors running hotter than their load explains
+    {
+        TRACE_SCOPE("baseline");
+        if (g_baseline->Update(g_snapshot)) {
+            UpdateDegraded(registry);
+        }
+        ULONGLONG now = GetTickCount64();
+        if (now - g_lastBaselineSave >= BASELINE_SAVE_INTERVAL) {
+            g_baseline->Save(g_config->GetBaselinePath());
+            g_lastBaselineSave = now;
+        }
+    }
+
+    // The UI lives on this thread and always uses the latest snapshot
+    if (HottestSensor(g_snapshot, registry) < 0) return;
+
+    // Check thresholds and show/hide floating window
+    AlertDecision decision = g_evaluator->Evaluate(g_snapshot, registry, warningTemp, dangerTemp);
+
+    // Blame the top consumers whenever the level rises
+    if (decision.level > decision.previousLevel) {
+        std::vector<ProcessUsage> top;
+        g_processes->GetTopConsumers(3, top);
+        g_consumers = ProcessSampler::FormatConsumers(top);
+
+        const wchar_t* levelName = (decision.level == TempLevel::Danger) ? L"danger" : L"warning";
+        g_history->AppendEvent(History::Now(), ToUtf8(std::wstring(levelName) + L"\t" + g_consumers));
+    } else if (decision.level == TempLevel::Normal) {
+        g_consumers.clear();
+    }
+    g_floatingWindow->SetConsumers(g_consumers);
+
+    // Update tray tooltip
+    std::wstring tooltipText = g_monitor->GetTempString(g_snapshot);
+    if (!g_consumers.empty()) {
+        tooltipText += L"\n" + g_consumers;
+    }
+    if (!g_degraded.empty()) {
+        tooltipText += L"\n" + g_degraded;
+    }
+    int hottest = decision.hottestSensor;
+    int trayValue = (hottest >= 0) ? (int)(g_snapshot.values[hottest] + 0.5f) : -1;
+    g_trayIcon->Update(tooltipText, trayValue, decision.level);
+
+    if (decision.action == AlertAction::Show) {
+        g_floatingWindow->Show();
+    } else if (decision.action == AlertAction::Hide) {
+        g_floatingWindow->Hide();
+    }
+    if (decision.updateWindow) {
+        g_floatingWindow->UpdateTemp(g_snapshot, warningTemp, dangerTemp);
+    }
+    UpdateTickInterval();
+}
+
+void OnTimer() {
+    if (!Trace::IsEnabled()) {
+        Tick();
+        return;
+    }
+
+    // A tick that takes longer than its interval dumps the timeline leading
+    // up to it, at most once a minute
+    ULONGLONG started = GetTickCount64();
+    Tick();
+    ULONGLONG now = GetTickCount64();
+    if (now - started > (ULONGLONG)g_tickInterval &&
+        (g_lastTraceDump == 0 || now - g_lastTraceDump >= TRACE_OVERRUN_INTERVAL)) {
+        g_lastTraceDump = now;
+        OnSaveTrace();
+    }
+}
+
+void OnSettings() {
+    SettingsDialog dialog(g_config);
+    dialog.Show(g_hwndMain, g_hInstance);
+}
+
+void OnSaveTrace() {
+    std::wstring dir = g_config->GetTraceDir();
+    CreateDirectoryW(dir.c_str(), NULL);
+
+    SYSTEMTIME st;
+    GetLocalTime(&st);
+    wchar_t name[64];
+    swprintf_s(name, L"\\trace_%04d%02d%02d_%02d%02d%02d.json",
+        st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond);
+    Trace::WriteJson(dir + name);
+}
+
+void OnExit() {
+    if (g_floatingWindow && g_floatingWindow->IsVisible()) {
+        g_floatingWindow->SavePosition();
+    }
+    if (g_baseline) {
+        g_baseline->Save(g_config->GetBaselinePath());
+    }
+    // The history writer drains its backlog before the final flush
+    StopSinks();
+    if (g_history) {
+        g_history->Flush();
+    }
+    DestroyWindow(g_hwndMain);
+}
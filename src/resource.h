@@ -1,10 +1,10 @@
-#pragma once
-
-#define IDI_APPICON 101
-#define IDD_SETTINGS 102
-
-#define IDC_EDIT_WARNING 1001
-#define IDC_EDIT_DANGER 1002
-#define IDC_CHECK_AUTOSTART 1003
-#define IDC_STATIC_WARNING 1004
-#define IDC_STATIC_DANGER 1005
+#pragma once
+
+#define IDI_APPICON 101
+#define IDD_SETTINGS 102
+
+#define IDC_EDIT_WARNING 1001
+#define IDC_EDIT_DANGER 1002
+#define IDC_CHECK_AUTOSTART 1003
+#define IDC_STATIC_WARNING 1004
+#define IDC_STATIC_DANGER 1005
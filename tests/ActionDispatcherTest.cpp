@@ -0,0 +1,270 @@
+// Alert actions against slow dummy scripts and a local stand-in HTTP listener
+#include "ActionDispatcher.h"
+#include "TestCheck.h"
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <netinet/in.h>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    const int kWarning = 80;
+    const int kDanger = 90;
+
+    struct Harness {
+        SensorRegistry registry;
+        SensorSnapshot snapshot;
+        ActionDispatcher actions;
+
+        Harness() {
+            registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        }
+
+        void Feed(float temp) {
+            snapshot.Clear((uint32_t)registry.Count());
+            snapshot.Set(0, temp, SteadyNow());
+            actions.OnSample(snapshot, registry, kWarning, kDanger);
+        }
+    };
+
+    template <typename Predicate>
+    bool WaitFor(Predicate done, int timeoutMs) {
+        double end = TestSeconds() + timeoutMs / 1000.0;
+        while (!done()) {
+            if (TestSeconds() > end) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+    ActionRule Rule(ActionType type, const std::wstring& target, uint32_t timeout = 2000, uint32_t interval = 0) {
+        ActionRule rule;
+        rule.level = TempLevel::Warning;
+        rule.sensor = "cpu";
+        rule.type = type;
+        rule.target = target;
+        rule.timeout = timeout;
+        rule.minInterval = interval;
+        return rule;
+    }
+
+    std::wstring WriteScript(const TestDirectory& dir, const std::string& name, const std::string& body) {
+        std::filesystem::path path = dir.path / name;
+        std::ofstream(path) << "#!/bin/sh\n" << body << "\n";
+        chmod(path.c_str(), 0755);
+        return path.wstring();
+    }
+
+    std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream in(path);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    // Gone, or a zombie waiting for a reaper that a container may not have
+    bool ProcessEnded(int pid) {
+        if (kill(pid, 0) != 0) return true;
+        std::string stat = ReadFile("/proc/" + std::to_string(pid) + "/stat");
+        size_t paren = stat.rfind(')');
+        return paren != std::string::npos && paren + 2 < stat.size() && stat[paren + 2] == 'Z';
+    }
+
+    void TestParseRule() {
+        ActionRule rule;
+        CHECK(ActionDispatcher::ParseRule(L"danger,gpu,webhook,http://127.0.0.1:9000/hook", rule));
+        CHECK(rule.level == TempLevel::Danger && rule.sensor == "gpu" && rule.type == ActionType::Webhook);
+        CHECK(rule.target == L"http://127.0.0.1:9000/hook");
+        CHECK(rule.timeout == ActionDispatcher::kDefaultTimeout);
+        CHECK(!ActionDispatcher::ParseRule(L"warning,cpu,mail,x", rule));
+        CHECK(!ActionDispatcher::ParseRule(L"warning,cpu,log,", rule));
+    }
+
+    void TestScriptArguments() {
+        TestDirectory dir("actions_args");
+        std::wstring script = WriteScript(dir, "record.sh", "echo \"$1 $2 $3\" >> \"" +
+            (dir.path / "args.txt").string() + "\"");
+
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Script, script) });
+        h.Feed(70.0f);
+        h.Feed(85.5f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 1; }, 5000));
+        CHECK(h.actions.GetFailedCount() == 0);
+        CHECK(ReadFile(dir.path / "args.txt") == "cpu warning 85.5\n");
+    }
+
+    // A timed-out script is killed together with everything it started
+    void TestSlowScript() {
+        TestDirectory dir("actions_slow");
+        std::filesystem::path pidFile = dir.path / "child.pid";
+        std::wstring script = WriteScript(dir, "slow.sh",
+            "sleep 30 &\necho $! > \"" + pidFile.string() + "\"\nwait");
+
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Script, script, 300) });
+        double start = TestSeconds();
+        h.Feed(85.0f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 1; }, 5000));
+        double elapsed = TestSeconds() - start;
+        CHECK(elapsed >= 0.3 && elapsed < 1.5);
+        CHECK(h.actions.GetFailedCount() == 1);
+
+        int child = atoi(ReadFile(pidFile).c_str());
+        CHECK(child > 0);
+        CHECK(WaitFor([&] { return ProcessEnded(child); }, 2000));
+    }
+
+    // Stop cancels a running action instead of waiting out its timeout
+    void TestStopCancels() {
+        TestDirectory dir("actions_stop");
+        std::filesystem::path marker = dir.path / "started";
+        std::wstring script = WriteScript(dir, "hang.sh", "touch \"" + marker.string() + "\"\nsleep 30");
+
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Script, script, 10000) });
+        h.Feed(85.0f);
+        CHECK(WaitFor([&] { return std::filesystem::exists(marker); }, 5000));
+
+        double start = TestSeconds();
+        h.actions.Stop();
+        CHECK(TestSeconds() - start < 0.5);
+    }
+
+    void TestDeduplicationAndRateLimit() {
+        TestDirectory dir("actions_limits");
+        std::wstring slow = WriteScript(dir, "slow.sh", "sleep 0.3");
+        std::wstring log = (dir.path / "actions.log").wstring();
+
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Script, slow), Rule(ActionType::Log, log, 2000, 60000) });
+
+        // The second crossing arrives while the script still runs, and
+        // within the log rule's interval
+        h.Feed(85.0f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 1; }, 5000));
+        h.Feed(70.0f);
+        h.Feed(85.0f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 2; }, 5000));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(h.actions.GetCompletedCount() == 2);
+        CHECK(h.actions.GetRateLimitedCount() == 1);
+        CHECK(ReadFile(dir.path / "actions.log").find(" cpu warning 85.0\r\n") != std::string::npos);
+    }
+
+    void TestQueueBound() {
+        TestDirectory dir("actions_queue");
+        std::vector<ActionRule> rules;
+        for (int i = 0; i < 40; i++) {
+            rules.push_back(Rule(ActionType::Log, (dir.path / ("log" + std::to_string(i))).wstring()));
+        }
+
+        Harness h;
+        h.actions.Start(rules);
+        h.Feed(85.0f);
+        CHECK(h.actions.GetDroppedCount() == 40 - ActionDispatcher::kQueueCapacity);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == ActionDispatcher::kQueueCapacity; }, 5000));
+    }
+
+    // Accepts one connection at a time; answers 200 unless told to hang
+    class Listener {
+    public:
+        explicit Listener(bool respond) : respond(respond), stop(false) {
+            fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address = {};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            bind(fd, (sockaddr*)&address, sizeof(address));
+            socklen_t size = sizeof(address);
+            getsockname(fd, (sockaddr*)&address, &size);
+            port = ntohs(address.sin_port);
+            listen(fd, 4);
+            thread = std::thread([this] { Run(); });
+        }
+
+        ~Listener() {
+            stop = true;
+            shutdown(fd, SHUT_RDWR);
+            close(fd);
+            thread.join();
+        }
+
+        std::wstring Url() const { return L"http://127.0.0.1:" + std::to_wstring(port) + L"/hook"; }
+
+        std::string request;
+        int requests = 0;
+
+    private:
+        int fd;
+        int port;
+        bool respond;
+        std::atomic<bool> stop;
+        std::thread thread;
+
+        void Run() {
+            for (;;) {
+                int client = accept(fd, nullptr, nullptr);
+                if (client < 0) return;
+
+                std::string received;
+                char buffer[1024];
+                ssize_t n;
+                while (received.find('}') == std::string::npos && (n = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+                    received.append(buffer, (size_t)n);
+                }
+                request = received;
+                requests++;
+                if (respond) {
+                    const char* reply = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+                    send(client, reply, strlen(reply), MSG_NOSIGNAL);
+                } else {
+                    while (!stop) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                close(client);
+            }
+        }
+    };
+
+    void TestWebhook() {
+        Listener listener(true);
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Webhook, listener.Url()) });
+        h.Feed(91.0f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 1; }, 5000));
+        CHECK(h.actions.GetFailedCount() == 0);
+        CHECK(listener.request.compare(0, 21, "POST /hook HTTP/1.1\r\n") == 0);
+        CHECK(listener.request.find("{\"sensor\":\"cpu\",\"level\":\"danger\",\"temp\":91.0}") != std::string::npos);
+    }
+
+    // The whole request, not each phase, is bounded by the timeout
+    void TestHungWebhook() {
+        Listener listener(false);
+        Harness h;
+        h.actions.Start({ Rule(ActionType::Webhook, listener.Url(), 400) });
+        double start = TestSeconds();
+        h.Feed(85.0f);
+        CHECK(WaitFor([&] { return h.actions.GetCompletedCount() == 1; }, 5000));
+        double elapsed = TestSeconds() - start;
+        CHECK(elapsed >= 0.4 && elapsed < 1.0);
+        CHECK(h.actions.GetFailedCount() == 1);
+        CHECK(listener.requests == 1);
+    }
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    TestParseRule();
+    TestScriptArguments();
+    TestSlowScript();
+    TestStopCancels();
+    TestDeduplicationAndRateLimit();
+    TestQueueBound();
+    TestWebhook();
+    TestHungWebhook();
+    return TestResult();
+}
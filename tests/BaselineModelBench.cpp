@@ -0,0 +1,58 @@
+// Cost of one BaselineModel update as the sensor count grows, with every
+// load and fan input in use. Usage: BaselineModelBench [sensors] [updates]
+#include "BaselineModel.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+int main(int argc, char** argv) {
+    size_t maxSensors = argc > 1 ? strtoull(argv[1], nullptr, 10) : kMaxSensors - BaselineModel::kMaxInputs;
+    size_t updates = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    maxSensors = std::min(maxSensors, kMaxSensors - BaselineModel::kMaxInputs);
+
+    double previous = 0.0;
+    for (size_t sensors = 1; sensors <= maxSensors; sensors *= 2) {
+        SensorRegistry registry;
+        registry.Register(SensorKind::Load, SensorUnit::Percent, "load", "CPU Load");
+        registry.Register(SensorKind::Load, SensorUnit::Percent, "gpuload", "GPU Load");
+        registry.Register(SensorKind::Fan, SensorUnit::Percent, "fan", "Fan");
+        registry.Register(SensorKind::Fan, SensorUnit::Percent, "gpufan", "GPU Fan");
+        for (size_t i = 0; i < sensors; i++) {
+            std::string key = "t" + std::to_string(i);
+            registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, key, key);
+        }
+
+        BaselineModel model(registry);
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> percent(0.0f, 100.0f);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+
+        SensorSnapshot snapshot;
+        double start = TestSeconds();
+        for (size_t n = 0; n < updates; n++) {
+            snapshot.Clear((uint32_t)registry.Count());
+            snapshot.time = (int64_t)n * 2000;
+            float load = percent(random);
+            for (size_t i = 0; i < BaselineModel::kMaxInputs; i++) {
+                snapshot.Set(i, load, snapshot.time);
+            }
+            for (size_t i = 0; i < sensors; i++) {
+                snapshot.Set(BaselineModel::kMaxInputs + i, 40.0f + 0.3f * load + noise(random), snapshot.time);
+            }
+            model.Update(snapshot);
+        }
+        double elapsed = TestSeconds() - start;
+
+        double perUpdate = elapsed * 1e6 / updates;
+        printf("%2zu sensors: %.2f us/update, %.0f ns/sensor\n", sensors, perUpdate,
+            elapsed * 1e9 / (updates * sensors));
+        CHECK(!model.IsDegraded(BaselineModel::kMaxInputs));
+
+        // Fixed state per sensor: doubling the sensors at most doubles the cost
+        if (previous > 0.0) CHECK(perUpdate < previous * 3.0);
+        previous = perUpdate;
+    }
+    return TestResult();
+}
@@ -0,0 +1,195 @@
+// Degradation detection on replayed load cycles: a step in temperature for
+// the same load is flagged after kSustain at any sampling interval, a
+// healthy trace never is, and a shift that lasts is relearned
+#include "BaselineModel.h"
+#include "ReplayProvider.h"
+#include "Simulator.h"
+#include "TestCheck.h"
+#include <fstream>
+#include <iterator>
+
+namespace {
+    const int64_t kMinute = 60 * 1000;
+    const int64_t kHour = 60 * kMinute;
+
+    // A machine alternating between idle and busy every ten minutes, with a
+    // load sensor to explain the temperature
+    SyntheticTrace LoadCycles(int64_t interval, int64_t duration) {
+        SyntheticTrace trace = {};
+        trace.shape = SyntheticTrace::Shape::Square;
+        trace.baseTemp = 45.0f;
+        trace.peakTemp = 75.0f;
+        trace.period = 20 * kMinute;
+        trace.timeConstant = kMinute;
+        trace.noise = 0.3f;
+        trace.interval = interval;
+        trace.duration = duration;
+        trace.seed = 11;
+        trace.sensorCount = 1;
+        trace.withLoad = true;
+        return trace;
+    }
+
+    std::vector<SimEvent> BaselineEvents(const SyntheticTrace& trace) {
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        Simulator simulator(200, 300);   // thresholds out of reach
+        SimResult result = simulator.Run(provider);
+
+        std::vector<SimEvent> events;
+        for (const SimEvent& event : result.events) {
+            if (event.type == SimEventType::Degraded || event.type == SimEventType::Recovered) {
+                events.push_back(event);
+            }
+        }
+        return events;
+    }
+
+    void TestDetection() {
+        const int64_t intervals[] = { 1000, 2000, 5000 };
+        int64_t fastest = INT64_MAX;
+        int64_t slowest = 0;
+        for (int64_t interval : intervals) {
+            SyntheticTrace trace = LoadCycles(interval, 9 * kHour);
+            trace.degradeAt = 6 * kHour;
+            trace.degradeBy = 8.0f;
+
+            std::vector<SimEvent> events = BaselineEvents(trace);
+            CHECK(!events.empty());
+            if (events.empty()) continue;
+
+            CHECK(events[0].type == SimEventType::Degraded && events[0].sensor == 0);
+            int64_t delay = events[0].timestamp - trace.degradeAt;
+            CHECK(delay >= BaselineModel::kSustain);
+            CHECK(delay <= BaselineModel::kSustain + 15 * kMinute);
+            CHECK(events[0].excess > BaselineModel::kMinExcess);
+            CHECK(events[0].maxTemp > trace.baseTemp);
+            fastest = std::min(fastest, delay);
+            slowest = std::max(slowest, delay);
+        }
+
+        // Forgetting and smoothing follow snapshot time, not the update count
+        CHECK(slowest - fastest <= 3 * kMinute);
+    }
+
+    // Excess over the fit at the end of a trace, read straight from the model
+    float FinalExcess(const SyntheticTrace& trace) {
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        BaselineModel model(provider.GetRegistry());
+        SensorSnapshot snapshot;
+        while (provider.Next(snapshot)) {
+            model.Update(snapshot);
+        }
+        return model.GetExcess(0);
+    }
+
+    // A shift too small to flag is learned at the same pace in hours,
+    // whether the model sees one snapshot a second or one every five
+    void TestForgettingFollowsTime() {
+        float excess[2];
+        const int64_t intervals[] = { 1000, 5000 };
+        for (int i = 0; i < 2; i++) {
+            SyntheticTrace trace = LoadCycles(intervals[i], 12 * kHour);
+            trace.degradeAt = 6 * kHour;
+            trace.degradeBy = 2.0f;
+            excess[i] = FinalExcess(trace);
+        }
+        CHECK(excess[0] > 0.3f && excess[0] < 2.0f);
+        CHECK_NEAR(excess[0], excess[1], 0.25);
+    }
+
+    void TestHealthy() {
+        const int64_t intervals[] = { 1000, 5000 };
+        for (int64_t interval : intervals) {
+            std::vector<SimEvent> events = BaselineEvents(LoadCycles(interval, 12 * kHour));
+            CHECK(events.empty());
+        }
+    }
+
+    // Once flagged for kRelearnAfter, the new temperature becomes the normal
+    // one, at the pace of the fit's ~11 h memory
+    void TestRelearn() {
+        SyntheticTrace trace = LoadCycles(5000, 2 * kHour + BaselineModel::kRelearnAfter + 16 * kHour);
+        trace.degradeAt = 2 * kHour;
+        trace.degradeBy = 8.0f;
+
+        std::vector<SimEvent> events = BaselineEvents(trace);
+        CHECK(events.size() == 2);
+        if (events.size() != 2) return;
+        CHECK(events[0].type == SimEventType::Degraded);
+        CHECK(events[1].type == SimEventType::Recovered);
+        CHECK(events[1].timestamp >= events[0].timestamp + BaselineModel::kRelearnAfter);
+        CHECK(events[1].timestamp <= events[0].timestamp + BaselineModel::kRelearnAfter + 12 * kHour);
+    }
+
+    std::string ReadFile(const std::filesystem::path& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    void TestSaveLoad() {
+        TestDirectory dir("baseline");
+        std::filesystem::path path = dir.path / "baseline.bin";
+
+        ReplayProvider provider;
+        provider.SetSynthetic(LoadCycles(2000, 2 * kHour));
+        BaselineModel model(provider.GetRegistry());
+        CHECK(model.IsActive());
+        SensorSnapshot snapshot;
+        SensorSnapshot last;
+        while (provider.Next(snapshot)) {
+            model.Update(snapshot);
+            last = snapshot;
+        }
+
+        // Saving again over the file replaces it and leaves nothing behind
+        CHECK(model.Save(path.wstring()));
+        CHECK(model.Save(path.wstring()));
+        CHECK(std::distance(std::filesystem::directory_iterator(dir.path), std::filesystem::directory_iterator()) == 1);
+
+        BaselineModel loaded(provider.GetRegistry());
+        CHECK(loaded.Load(path.wstring()));
+        std::filesystem::path copy = dir.path / "copy.bin";
+        CHECK(loaded.Save(copy.wstring()));
+        CHECK(ReadFile(path) == ReadFile(copy));
+
+        // Both predict the same for the same snapshot
+        last.time += 2000;
+        model.Update(last);
+        loaded.Update(last);
+        CHECK_NEAR(loaded.GetExpected(0), model.GetExpected(0), 0.5);
+
+        // Another sensor layout ignores the file
+        SensorRegistry other;
+        other.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        other.Register(SensorKind::Load, SensorUnit::Percent, "gpuload", "GPU Load");
+        BaselineModel mismatched(other);
+        CHECK(!mismatched.Load(path.wstring()));
+        CHECK(!loaded.Load((dir.path / "missing.bin").wstring()));
+    }
+
+    void TestWithoutInputs() {
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        BaselineModel model(registry);
+        CHECK(!model.IsActive());
+
+        SensorSnapshot snapshot;
+        snapshot.Clear(1);
+        snapshot.Set(0, 90.0f, 0);
+        snapshot.time = 0;
+        CHECK(!model.Update(snapshot));
+        CHECK(!model.IsDegraded(0));
+    }
+}
+
+int main() {
+    TestDetection();
+    TestForgettingFollowsTime();
+    TestHealthy();
+    TestRelearn();
+    TestSaveLoad();
+    TestWithoutInputs();
+    return TestResult();
+}
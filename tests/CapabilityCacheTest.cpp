@@ -0,0 +1,187 @@
+// Source selection with fake CPU providers: what a cached capability probe
+// saves over trying every backend each tick, and how often a dead source
+// is probed again
+#include "CapabilityCache.h"
+#include "TestCheck.h"
+#include <algorithm>
+
+namespace {
+    const int64_t kTick = 2000;
+    const int64_t kEpoch = 1700000000000LL;
+
+    // Two backends in preference order, like ACPI zones then the
+    // temperature probe class; each call is counted
+    struct FakeProviders {
+        bool works[3] = { false, false, true };
+        int zones = 2;
+        int calls[3] = {};
+
+        SourceSelector::ReadFunction Function() {
+            return [this](int source, std::vector<float>& values) {
+                calls[source]++;
+                values.clear();
+                if (!works[source]) return false;
+                values.assign(zones, 50.0f + source);
+                return true;
+            };
+        }
+        int Total() const { return calls[1] + calls[2]; }
+    };
+
+    void TestSchedule() {
+        ProbeSchedule schedule;
+        int64_t now = 0;
+        CHECK(!schedule.ShouldProbe(now));   // one failed read is not worth a probe
+        CHECK(!schedule.ShouldProbe(now + ProbeSchedule::kMinDelay - 1));
+        CHECK(schedule.ShouldProbe(now + ProbeSchedule::kMinDelay));
+
+        int64_t expected = ProbeSchedule::kMinDelay;
+        for (int i = 0; i < 8; i++) {
+            schedule.Failed(now);
+            expected = std::min(expected * 2, ProbeSchedule::kMaxDelay);
+            CHECK(!schedule.ShouldProbe(now + expected - 1));
+            CHECK(schedule.ShouldProbe(now + expected));
+        }
+        schedule.Succeeded();
+        CHECK(!schedule.ShouldProbe(now));
+    }
+
+    void TestCachedStartup() {
+        TestDirectory dir("capabilities");
+        std::wstring path = (dir.path / "capabilities.ini").wstring();
+        const int ticks = 1800;   // an hour at the default interval
+        std::vector<float> values;
+
+        // Trying every backend in order each tick, as before the cache
+        FakeProviders naive;
+        auto read = naive.Function();
+        for (int t = 0; t < ticks; t++) {
+            for (int source = 1; source <= 2 && !read(source, values); source++) {
+            }
+        }
+
+        // First start probes both once and remembers the second
+        FakeProviders first;
+        SourceSelector selector(2, first.Function());
+        selector.Discover(path, "machine-a", kEpoch, 0);
+        CHECK(selector.GetSource() == 2 && selector.GetZoneCount() == 2);
+        CHECK(first.calls[1] == 1 && first.calls[2] == 1);
+        CHECK(!selector.IsCachedWorking());
+        for (int t = 0; t < ticks; t++) {
+            CHECK(selector.Read(values, kEpoch + t * kTick, t * kTick));
+        }
+        CHECK(first.calls[1] == 1);
+
+        // Later starts on the same hardware never touch the dead backend
+        FakeProviders second;
+        SourceSelector cached(2, second.Function());
+        cached.Discover(path, "machine-a", kEpoch + 3600000, 0);
+        CHECK(second.Total() == 0);
+        CHECK(cached.GetSource() == 2 && cached.GetZoneCount() == 2 && cached.IsCachedWorking());
+        for (int t = 0; t < ticks; t++) cached.Read(values, kEpoch + t * kTick, t * kTick);
+        CHECK(second.calls[1] == 0 && second.calls[2] == ticks);
+
+        printf("%d ticks: %d backend calls trying each in turn, %d after the first probe, %d from the cache\n",
+            ticks, naive.Total(), first.Total(), second.Total());
+        CHECK(naive.Total() == 2 * ticks);
+
+        // Other hardware does not use the cache
+        FakeProviders other;
+        SourceSelector moved(2, other.Function());
+        moved.Discover(path, "machine-b", kEpoch, 0);
+        CHECK(other.calls[1] == 1 && other.calls[2] == 1);
+    }
+
+    void TestRuntimeFailure() {
+        TestDirectory dir("capabilities_runtime");
+        std::wstring path = (dir.path / "capabilities.ini").wstring();
+        std::vector<float> values;
+
+        FakeProviders providers;
+        SourceSelector selector(2, providers.Function());
+        selector.Discover(path, "machine-a", kEpoch, 0);
+
+        // The source dies for an hour: one probe 30 s after the first
+        // failure, then backing off to one every 10 minutes
+        providers.works[2] = false;
+        int before = providers.Total();
+        const int ticks = 1800;
+        for (int t = 1; t <= ticks; t++) {
+            CHECK(!selector.Read(values, kEpoch + t * kTick, t * kTick));
+        }
+        int probes = providers.calls[1] - 1;
+        printf("dead source for %d ticks: %d probes, %d backend calls\n", ticks, probes, providers.Total() - before);
+        CHECK(probes >= 5 && probes <= 10);
+        CHECK(!selector.IsCachedWorking());
+
+        // A failed runtime probe never replaces the cached working source
+        Capabilities saved;
+        CHECK(CapabilityCache(path).Load("machine-a", saved));
+        CHECK(saved.cpuSource == 2 && saved.cpuZones == 2);
+
+        // It comes back with more zones; the next probe finds and saves it
+        providers.works[2] = true;
+        providers.zones = 4;
+        bool recovered = false;
+        for (int t = ticks + 1; t <= ticks + 400 && !recovered; t++) {
+            recovered = selector.Read(values, kEpoch + t * kTick, t * kTick);
+        }
+        CHECK(recovered && values.size() == 4);
+        CHECK(CapabilityCache(path).Load("machine-a", saved));
+        CHECK(saved.cpuSource == 2 && saved.cpuZones == 4);
+    }
+
+    void TestNoSource() {
+        TestDirectory dir("capabilities_none");
+        std::wstring path = (dir.path / "capabilities.ini").wstring();
+
+        // A full startup probe that finds nothing is cached, with its time
+        FakeProviders none;
+        none.works[2] = false;
+        SourceSelector first(2, none.Function());
+        first.Discover(path, "machine-a", kEpoch, 0);
+        CHECK(first.GetSource() == 0);
+        Capabilities saved;
+        CHECK(CapabilityCache(path).Load("machine-a", saved));
+        CHECK(saved.cpuSource == 0 && saved.probedAt == kEpoch);
+
+        // Within its lifetime the next start skips the probe...
+        FakeProviders again;
+        again.works[2] = false;
+        SourceSelector second(2, again.Function());
+        second.Discover(path, "machine-a", kEpoch + SourceSelector::kNegativeLifetime, 0);
+        CHECK(again.Total() == 0 && second.GetSource() == 0);
+
+        // ...and still probes on the backoff schedule while running
+        std::vector<float> values;
+        CHECK(!second.Read(values, kEpoch, ProbeSchedule::kMinDelay - 1));
+        CHECK(again.Total() == 0);
+        CHECK(!second.Read(values, kEpoch, ProbeSchedule::kMinDelay));
+        CHECK(again.Total() == 2);
+
+        // After it, the negative result is probed again in full
+        FakeProviders later;
+        SourceSelector third(2, later.Function());
+        third.Discover(path, "machine-a", kEpoch + SourceSelector::kNegativeLifetime + 1, 0);
+        CHECK(later.calls[1] == 1 && later.calls[2] == 1 && third.GetSource() == 2);
+    }
+
+    void TestFingerprint() {
+        std::string fingerprint = CapabilityCache::HardwareFingerprint();
+        CHECK(fingerprint.size() == 16);
+        CHECK(fingerprint == CapabilityCache::HardwareFingerprint());
+
+        Capabilities capabilities;
+        CHECK(!CapabilityCache(L"").Load(fingerprint, capabilities));
+        CHECK(!CapabilityCache(L"no_such_directory/capabilities.ini").Load(fingerprint, capabilities));
+    }
+}
+
+int main() {
+    TestSchedule();
+    TestCachedStartup();
+    TestRuntimeFailure();
+    TestNoSource();
+    TestFingerprint();
+    return TestResult();
+}
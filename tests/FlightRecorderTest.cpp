@@ -0,0 +1,174 @@
+// Captures replayed through the flight recorder contain exactly the
+// samples in [trigger - preTrigger, trigger + postTrigger)
+#include "FlightRecorder.h"
+#include "ReplayProvider.h"
+#include "TestCheck.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+    const int64_t kInterval = 100;
+    const int64_t kPre = 2000;
+    const int64_t kPost = 1000;
+    const int64_t kStart = 1700000000000LL;
+
+    struct Capture {
+        FlightFormat::Header header;
+        std::vector<std::string> channels;
+        std::vector<int64_t> times;
+        std::vector<float> values;   // row-major
+        std::vector<uint8_t> valid;
+    };
+
+    bool ReadCapture(const std::filesystem::path& path, Capture& capture) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.read((char*)&capture.header, sizeof(capture.header))) return false;
+        if (capture.header.magic != FlightFormat::kMagic) return false;
+
+        const uint16_t channelCount = capture.header.channelCount;
+        for (uint16_t c = 0; c < channelCount; c++) {
+            char name[FlightFormat::kChannelNameSize];
+            in.read(name, sizeof(name));
+            capture.channels.emplace_back(name, strnlen(name, sizeof(name)));
+        }
+        for (uint32_t s = 0; s < capture.header.sampleCount; s++) {
+            int64_t time;
+            std::vector<float> values(channelCount);
+            std::vector<uint8_t> valid(channelCount);
+            in.read((char*)&time, sizeof(time));
+            in.read((char*)values.data(), channelCount * sizeof(float));
+            in.read((char*)valid.data(), channelCount);
+            capture.times.push_back(time);
+            capture.values.insert(capture.values.end(), values.begin(), values.end());
+            capture.valid.insert(capture.valid.end(), valid.begin(), valid.end());
+        }
+        // Nothing may follow the last row
+        return (bool)in && in.peek() == std::ifstream::traits_type::eof();
+    }
+
+    SyntheticTrace Trace(int64_t duration) {
+        SyntheticTrace trace = {};
+        trace.shape = SyntheticTrace::Shape::Ramp;
+        trace.baseTemp = 40.0f;
+        trace.peakTemp = 95.0f;
+        trace.period = duration;
+        trace.noise = 0.5f;
+        trace.dropoutRate = 0.05f;
+        trace.interval = kInterval;
+        trace.duration = duration;
+        trace.seed = 11;
+        return trace;
+    }
+
+    // Replays the trace into a recorder, triggering when the clock reaches
+    // each trigger time, and keeps every sample for comparison. In real time
+    // the writer has a whole capture's duration to finish before the ring
+    // reaches pinned slots; replay waits for it once each capture closes.
+    std::vector<SensorSnapshot> Replay(FlightRecorder& recorder, int64_t duration,
+        const std::vector<int64_t>& triggers, std::vector<bool>* accepted = nullptr) {
+        ReplayProvider provider;
+        provider.SetSynthetic(Trace(duration), kStart);
+        std::vector<SensorSnapshot> samples;
+        SensorSnapshot snapshot;
+        while (provider.Next(snapshot)) {
+            recorder.Record(snapshot);
+            samples.push_back(snapshot);
+            for (int64_t trigger : triggers) {
+                if (snapshot.time == trigger) {
+                    bool ok = recorder.Trigger(trigger, "warning cpu");
+                    if (accepted) accepted->push_back(ok);
+                }
+                if (snapshot.time == trigger + kPost) {
+                    recorder.WaitForDumps();
+                }
+            }
+        }
+        recorder.WaitForDumps();
+        return samples;
+    }
+
+    void CheckCapture(const TestDirectory& dir, const std::vector<SensorSnapshot>& samples,
+        int64_t trigger, size_t channelCount) {
+        Capture capture;
+        CHECK(ReadCapture(dir.path / FlightRecorder::FileName(trigger), capture));
+        CHECK(capture.header.triggerTime == trigger);
+        CHECK(capture.header.preTrigger == kPre && capture.header.postTrigger == kPost);
+        CHECK(capture.header.interval == kInterval);
+        CHECK(std::string(capture.header.reason) == "warning cpu");
+        CHECK(capture.channels.size() == channelCount);
+
+        std::vector<const SensorSnapshot*> expected;
+        for (const auto& s : samples) {
+            if (s.time >= trigger - kPre && s.time < trigger + kPost) expected.push_back(&s);
+        }
+        CHECK(capture.times.size() == expected.size());
+        for (size_t i = 0; i < expected.size() && i < capture.times.size(); i++) {
+            CHECK(capture.times[i] == expected[i]->time);
+            for (size_t c = 0; c < channelCount; c++) {
+                CHECK(capture.valid[i * channelCount + c] == expected[i]->valid[c]);
+                if (expected[i]->valid[c]) {
+                    CHECK(capture.values[i * channelCount + c] == expected[i]->values[c]);
+                }
+            }
+        }
+    }
+
+    void TestWindow() {
+        TestDirectory dir("flight_window");
+        std::vector<std::string> channels = { "cpu", "gpu" };
+        FlightRecorder recorder(dir.Wide(), channels, kInterval, kPre, kPost);
+
+        // Triggers on sample times, so samples fall exactly on both edges:
+        // trigger - kPre is in, trigger + kPost is out
+        const int64_t trigger = kStart + 10000;
+        std::vector<SensorSnapshot> samples = Replay(recorder, 20000, { trigger });
+        CheckCapture(dir, samples, trigger, channels.size());
+
+        Capture capture;
+        ReadCapture(dir.path / FlightRecorder::FileName(trigger), capture);
+        CHECK(capture.times.size() == (size_t)((kPre + kPost) / kInterval));
+        CHECK(!capture.times.empty() && capture.times.front() == trigger - kPre);
+        CHECK(!capture.times.empty() && capture.times.back() == trigger + kPost - kInterval);
+        CHECK(recorder.GetDroppedSamples() == 0);
+    }
+
+    void TestEarlyAndRepeated() {
+        TestDirectory dir("flight_early");
+        std::vector<std::string> channels = { "cpu", "gpu" };
+        FlightRecorder recorder(dir.Wide(), channels, kInterval, kPre, kPost);
+
+        // The first trigger comes before kPre of history exists; the second
+        // lands during its post-trigger window and is ignored; the third
+        // comes once the ring has wrapped several times
+        const int64_t early = kStart + 500;
+        const int64_t during = kStart + 1000;
+        const int64_t late = kStart + 60000;
+        std::vector<bool> accepted;
+        std::vector<SensorSnapshot> samples = Replay(recorder, 70000, { early, during, late }, &accepted);
+
+        CHECK((accepted == std::vector<bool>{ true, false, true }));
+        CheckCapture(dir, samples, early, channels.size());
+        CheckCapture(dir, samples, late, channels.size());
+        CHECK(!std::filesystem::exists(dir.path / FlightRecorder::FileName(during)));
+        CHECK(recorder.GetCapacity() * kInterval >= (size_t)(kPre + kPost));
+    }
+
+    void TestUnfinished() {
+        // A capture whose post-trigger window never completes is not written
+        TestDirectory dir("flight_unfinished");
+        const int64_t trigger = kStart + 4500;
+        {
+            FlightRecorder recorder(dir.Wide(), { "cpu", "gpu" }, kInterval, kPre, kPost);
+            Replay(recorder, 5000, { trigger });
+            CHECK(recorder.IsCapturing());
+        }
+        CHECK(!std::filesystem::exists(dir.path / FlightRecorder::FileName(trigger)));
+    }
+}
+
+int main() {
+    TestWindow();
+    TestEarlyAndRepeated();
+    TestUnfinished();
+    return TestResult();
+}
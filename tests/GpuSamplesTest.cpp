@@ -0,0 +1,236 @@
+// Buffered GPU samples against a stub nvmlDeviceGetSamples: probing, the
+// size-then-fill protocol, value types and units, only new samples taken,
+// and every one reaching a partial snapshot, also from a read that came in
+// after the tick's deadline
+#include "GpuSamples.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+    // What the stub driver holds. Like the real one it returns the samples
+    // newer than lastSeen, but also the one at lastSeen itself.
+    struct StubDriver {
+        std::vector<nvmlSample_t> samples;
+        int valueType = 1;
+        int error = 0;
+        int lastSamplingType = -1;
+        std::atomic<int> delay{0};   // ms before a filled call returns
+        int calls = 0;
+    };
+    StubDriver g_driver;
+    int g_device;
+
+    int StubGetSamples(void* device, int samplingType, unsigned long long lastSeen, int* valueType,
+                       unsigned int* count, nvmlSample_t* samples) {
+        g_driver.calls++;
+        g_driver.lastSamplingType = samplingType;
+        if (device != &g_device) return 2;   // NVML_ERROR_INVALID_ARGUMENT
+        if (g_driver.error != 0) return g_driver.error;
+
+        std::vector<nvmlSample_t> newer;
+        for (const auto& sample : g_driver.samples) {
+            if (sample.timeStamp >= lastSeen) newer.push_back(sample);
+        }
+        *valueType = g_driver.valueType;
+        if (!samples) {
+            *count = (unsigned int)newer.size();
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(g_driver.delay));
+        if (*count < newer.size()) return 7;   // NVML_ERROR_INSUFFICIENT_SIZE
+        *count = (unsigned int)newer.size();
+        for (size_t i = 0; i < newer.size(); i++) samples[i] = newer[i];
+        return 0;
+    }
+
+    nvmlSample_t UintSample(unsigned long long timeStamp, unsigned int value) {
+        nvmlSample_t sample = {};
+        sample.timeStamp = timeStamp;
+        sample.sampleValue.uiVal = value;
+        return sample;
+    }
+
+    void Reset() {
+        g_driver.samples.clear();
+        g_driver.valueType = 1;
+        g_driver.error = 0;
+        g_driver.delay = 0;
+        g_driver.calls = 0;
+    }
+
+    void TestProbe() {
+        Reset();
+        CHECK(GpuSamples::Probe(StubGetSamples, &g_device, 0));
+        CHECK(g_driver.lastSamplingType == 1);
+        CHECK(GpuSamples::Probe(StubGetSamples, &g_device, 2));
+        CHECK(g_driver.lastSamplingType == 5);
+
+        // Nothing sampled yet is still a buffer
+        g_driver.error = 6;   // NVML_ERROR_NOT_FOUND
+        CHECK(GpuSamples::Probe(StubGetSamples, &g_device, 1));
+        g_driver.error = 3;   // NVML_ERROR_NOT_SUPPORTED
+        CHECK(!GpuSamples::Probe(StubGetSamples, &g_device, 1));
+
+        CHECK(!GpuSamples::Probe(nullptr, &g_device, 0));
+        CHECK(!GpuSamples::Probe(StubGetSamples, nullptr, 0));
+        CHECK(!GpuSamples::Probe(StubGetSamples, &g_device, GpuSamples::kTypes));
+    }
+
+    // Power in mW over two reads: each sample is taken once, in watts, at
+    // its own time moved to the steady clock
+    void TestRead() {
+        Reset();
+        const unsigned long long base = 1700000000000000ULL;   // us
+        for (unsigned int i = 0; i < 5; i++) {
+            g_driver.samples.push_back(UintSample(base + i * 100000, 100000 + i * 1000));
+        }
+
+        unsigned long long lastSeen = base;
+        std::vector<unsigned char> buffer;
+        std::vector<SensorReading> readings;
+        const int64_t wallToSteady = -1699999000000LL;
+        GpuSamples::Read(StubGetSamples, &g_device, 1, 3, lastSeen, buffer, wallToSteady, readings);
+
+        CHECK(g_driver.lastSamplingType == 0);
+        CHECK(buffer.size() >= 5 * sizeof(nvmlSample_t));
+        CHECK(readings.size() == 4);   // the one at lastSeen was taken before
+        for (size_t i = 0; i < readings.size(); i++) {
+            CHECK(readings[i].sensor == 3);
+            CHECK_NEAR(readings[i].value, 101.0 + i, 1e-4);
+            CHECK(readings[i].timestamp == 1000000 + (int64_t)(i + 1) * 100);
+        }
+        CHECK(lastSeen == base + 400000);
+
+        // Only the sample at lastSeen again, then nothing at all: no fill
+        readings.clear();
+        g_driver.calls = 0;
+        GpuSamples::Read(StubGetSamples, &g_device, 1, 3, lastSeen, buffer, wallToSteady, readings);
+        CHECK(readings.empty() && g_driver.calls == 2);
+        g_driver.samples.clear();
+        g_driver.calls = 0;
+        GpuSamples::Read(StubGetSamples, &g_device, 1, 3, lastSeen, buffer, wallToSteady, readings);
+        CHECK(readings.empty() && g_driver.calls == 1);
+
+        // A failing driver leaves lastSeen alone
+        g_driver.samples.push_back(UintSample(base + 500000, 1));
+        g_driver.error = 999;
+        GpuSamples::Read(StubGetSamples, &g_device, 1, 3, lastSeen, buffer, wallToSteady, readings);
+        CHECK(readings.empty() && lastSeen == base + 400000);
+    }
+
+    void TestValueTypes() {
+        const unsigned long long base = 1000000;
+        struct Case { int valueType; nvmlValue_t value; double expected; } cases[4] = {};
+        cases[0].valueType = 0; cases[0].value.dVal = 42.5; cases[0].expected = 42.5;
+        cases[1].valueType = 1; cases[1].value.uiVal = 1500; cases[1].expected = 1500;
+        cases[2].valueType = 3; cases[2].value.ullVal = 1800; cases[2].expected = 1800;
+        cases[3].valueType = 4; cases[3].value.sllVal = 2100; cases[3].expected = 2100;
+
+        for (const Case& c : cases) {
+            Reset();
+            g_driver.valueType = c.valueType;
+            nvmlSample_t sample = {};
+            sample.timeStamp = base + 1000;
+            sample.sampleValue = c.value;
+            g_driver.samples.push_back(sample);
+
+            unsigned long long lastSeen = base;
+            std::vector<unsigned char> buffer;
+            std::vector<SensorReading> readings;
+            GpuSamples::Read(StubGetSamples, &g_device, 2, 0, lastSeen, buffer, 0, readings);
+            CHECK(readings.size() == 1);
+            if (!readings.empty()) CHECK_NEAR(readings[0].value, c.expected, 1e-3);
+        }
+    }
+
+    // Readings older than the snapshot's become partial snapshots, one per
+    // kBucket, in time order; the snapshot's own reading does not
+    void TestSplit() {
+        SensorSnapshot snapshot;
+        snapshot.Clear(3);
+        snapshot.Set(0, 60.0f, 10000);
+        snapshot.Set(1, 200.0f, 10000);
+
+        std::vector<SensorReading> readings = {
+            { 0, 60.0f, 10000 },
+            { 0, 57.0f, 9850 },
+            { 0, 55.0f, 9700 },
+            { 1, 180.0f, 9720 },
+            { 0, 56.0f, 9750 },
+            { 2, 1.0f, 9800 },    // a sensor the snapshot has no value for
+        };
+        std::vector<SensorSnapshot> between;
+        const int64_t steadyToWall = 1700000000000LL;
+        GpuSamples::Split(snapshot, readings, steadyToWall, between);
+
+        CHECK(between.size() == 2);
+        if (between.size() != 2) return;
+        for (const auto& partial : between) {
+            CHECK(partial.partial && partial.count == 3 && !partial.valid[2]);
+        }
+        CHECK(between[0].valid[0] && between[0].valid[1]);
+        CHECK(between[0].values[0] == 56.0f && between[0].values[1] == 180.0f);
+        CHECK(between[0].time == 9750 + steadyToWall);
+        CHECK(between[1].valid[0] && !between[1].valid[1]);
+        CHECK(between[1].values[0] == 57.0f && between[1].time == 9850 + steadyToWall);
+
+        // Nothing buffered, nothing between
+        readings = { { 0, 60.0f, 10000 } };
+        GpuSamples::Split(snapshot, readings, steadyToWall, between);
+        CHECK(between.empty());
+    }
+
+    // The driver call runs past the tick's deadline; its samples come with
+    // the next tick and none of them is lost
+    void TestLateRead() {
+        Reset();
+        const int64_t wallBase = 1700000000000LL;   // ms
+        const int64_t wallToSteady = SteadyNow() - 2000 - wallBase;
+        const int count = 10;
+        for (int i = 0; i < count; i++) {
+            g_driver.samples.push_back(UintSample((unsigned long long)(wallBase + i * 150) * 1000, 10 + i));
+        }
+
+        unsigned long long lastSeen = (unsigned long long)(wallBase - 1) * 1000;
+        std::vector<unsigned char> buffer;
+        ReadPool pool;
+        pool.AddSource([&](std::vector<SensorReading>& readings) {
+            GpuSamples::Read(StubGetSamples, &g_device, 0, 0, lastSeen, buffer, wallToSteady, readings);
+        });
+        pool.Start();
+
+        g_driver.delay = 150;
+        SensorSnapshot snapshot;
+        std::vector<SensorReading> fresh;
+        std::vector<SensorSnapshot> between;
+        snapshot.Clear(1);
+        pool.Collect(snapshot, 30, &fresh);
+        GpuSamples::Split(snapshot, fresh, 0, between);
+        CHECK(!snapshot.valid[0] && between.empty());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        g_driver.delay = 0;
+        fresh.clear();
+        snapshot.Clear(1);
+        pool.Collect(snapshot, 500, &fresh);
+        GpuSamples::Split(snapshot, fresh, 0, between);
+
+        // The newest is the tick's value, every other one is between
+        CHECK(snapshot.valid[0] && snapshot.values[0] == (float)(10 + count - 1));
+        CHECK(between.size() == (size_t)count - 1);
+        for (size_t i = 0; i < between.size(); i++) {
+            CHECK(between[i].values[0] == (float)(10 + i));
+        }
+        CHECK(pool.Stop());
+    }
+}
+
+int main() {
+    TestProbe();
+    TestRead();
+    TestValueTypes();
+    TestSplit();
+    TestLateRead();
+    return TestResult();
+}
@@ -0,0 +1,247 @@
+// History segments, the crash journal and the queries reading them back
+#include "History.h"
+#include "TelemetryQuery.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+    const int64_t kStart = 1700000000000LL;
+    const int64_t kStep = 2000;
+
+    size_t CountRows(const std::wstring& dir, const std::vector<std::string>& channels, float* lastValue = nullptr) {
+        HistoryReader reader;
+        if (!reader.Open(dir, channels, 0, INT64_MAX)) return 0;
+
+        size_t rows = 0;
+        int64_t timestamp;
+        std::vector<float> values(channels.size());
+        while (reader.Next(timestamp, values.data())) {
+            rows++;
+            if (lastValue) *lastValue = values[0];
+        }
+        return rows;
+    }
+
+    size_t CountFiles(const fs::path& dir, const std::string& extension) {
+        size_t count = 0;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.path().extension() == extension) count++;
+        }
+        return count;
+    }
+
+    void TestCleanExit() {
+        TestDirectory dir("history_clean");
+        {
+            History history(dir.Wide(), { "cpu", "gpu" });
+            for (int i = 0; i < 100; i++) {
+                float values[2] = { 40.0f + i % 10, 50.0f };
+                history.Append(kStart + i * kStep, values);
+            }
+        }
+
+        CHECK(CountFiles(dir.path, ".tmh") == 1);
+        CHECK(CountFiles(dir.path, ".tmp") == 0);
+        CHECK(!fs::exists(dir.path / HistoryFormat::kJournalFileName));
+        CHECK(CountRows(dir.Wide(), { "cpu", "gpu" }) == 100);
+
+        QuerySpec spec = {};
+        spec.channel = "cpu";
+        spec.aggregate = Aggregate::Max;
+        spec.startTime = kStart;
+        spec.endTime = kStart + 100 * kStep;
+        std::vector<QueryRow> rows = TelemetryQuery(dir.Wide(), 2).Run(spec);
+        CHECK(rows.size() == 1 && rows[0].value == 49.0 && rows[0].samples == 100);
+    }
+
+    void TestCrashRecovery() {
+        TestDirectory dir("history_crash");
+
+        // Never destroyed, as if the process died: only what the journal
+        // flushed survives
+        History* crashed = new History(dir.Wide(), { "cpu" });
+        const int rows = 50;
+        for (int i = 0; i < rows; i++) {
+            float value = (float)i;
+            crashed->Append(kStart + i * kStep, &value);
+        }
+        CHECK(CountFiles(dir.path, ".tmh") == 0);
+
+        // The journal keeps its own channels, whatever the new run uses
+        {
+            History recovered(dir.Wide(), { "cpu", "load" });
+            CHECK(CountFiles(dir.path, ".tmh") == 1);
+        }
+
+        float last = NAN;
+        size_t recoveredRows = CountRows(dir.Wide(), { "cpu" }, &last);
+        const size_t flushedRows = rows - (size_t)(HistoryFormat::kFlushInterval / kStep) + 1;
+        CHECK(recoveredRows >= flushedRows && recoveredRows <= (size_t)rows);
+        CHECK(last == (float)(recoveredRows - 1));
+        CHECK(!fs::exists(dir.path / HistoryFormat::kJournalFileName));
+    }
+
+    // Buffered GPU rows every 100 ms still make hourly segments
+    void TestSegmentDuration() {
+        TestDirectory dir("history_duration");
+        const int64_t step = 100;
+        const int64_t rows = (2 * 3600 + 600) * 1000 / step;
+        {
+            History history(dir.Wide(), { "load" });
+            for (int64_t i = 0; i < rows; i++) {
+                float value = (float)(i % 100);
+                history.Append(kStart + i * step, &value);
+            }
+        }
+        CHECK(CountFiles(dir.path, ".tmh") == 3);
+        CHECK(CountRows(dir.Wide(), { "load" }) == (size_t)rows);
+
+        for (const auto& entry : fs::directory_iterator(dir.path)) {
+            int64_t start, end;
+            if (!HistoryFormat::ParseSegmentFileName(entry.path().filename().wstring(), start, end)) continue;
+            CHECK(end - start < HistoryFormat::kSegmentDuration);
+        }
+    }
+
+    // Rows from a read that came in late are written in time order
+    void TestLateRows() {
+        TestDirectory dir("history_late");
+        {
+            History history(dir.Wide(), { "cpu", "load" });
+            for (int i = 0; i < 10; i++) {
+                float values[2] = { (float)i, NAN };
+                history.Append(kStart + i * kStep, values);
+            }
+            float late[2] = { NAN, 99.0f };
+            history.Append(kStart + 5 * kStep - 500, late);
+        }
+
+        HistoryReader reader;
+        CHECK(reader.Open(dir.Wide(), { "cpu", "load" }, 0, INT64_MAX));
+        int64_t timestamp;
+        int64_t previous = 0;
+        float values[2];
+        size_t rows = 0;
+        while (reader.Next(timestamp, values)) {
+            CHECK(timestamp >= previous);
+            if (timestamp == kStart + 5 * kStep - 500) CHECK(values[1] == 99.0f && std::isnan(values[0]));
+            previous = timestamp;
+            rows++;
+        }
+        CHECK(rows == 11);
+    }
+
+    // A 2 s temperature among 100 ms load rows holds for its full 2 s,
+    // including where the next reading is in the following block
+    void TestTimeAboveSkipsOtherChannels() {
+        TestDirectory dir("history_above");
+        const int64_t step = 100;
+        const int rows = 600;
+        {
+            History history(dir.Wide(), { "temp", "load" });
+            for (int i = 0; i < rows; i++) {
+                float values[2] = { i % 20 == 0 ? 80.0f : NAN, 50.0f };
+                history.Append(kStart + i * step, values);
+            }
+        }
+        CHECK(rows > 2 * (int)HistoryFormat::kBlockSamples);
+
+        QuerySpec spec = {};
+        spec.channel = "temp";
+        spec.aggregate = Aggregate::TimeAbove;
+        spec.threshold = 70.0f;
+        spec.startTime = kStart;
+        spec.endTime = kStart + rows * step;
+        std::vector<QueryRow> result = TelemetryQuery(dir.Wide(), 1).Run(spec);
+        CHECK(result.size() == 1 && result[0].samples == rows / 20);
+        if (!result.empty()) CHECK_NEAR(result[0].value, rows * step / 1000.0, 1e-9);
+    }
+
+    // A journal whose segment cannot be written survives until it can be
+    void TestFailedRecovery() {
+        TestDirectory dir("history_failed_recovery");
+        History* crashed = new History(dir.Wide(), { "cpu" });
+        for (int i = 0; i < 20; i++) {
+            float value = (float)i;
+            crashed->Append(kStart + i * kStep, &value);
+        }
+
+        // Recover a copy elsewhere to learn the rows and the segment name
+        TestDirectory probe("history_failed_probe");
+        fs::copy_file(dir.path / HistoryFormat::kJournalFileName, probe.path / HistoryFormat::kJournalFileName);
+        { History recovered(probe.Wide(), { "cpu" }); }
+        fs::path segment;
+        for (const auto& entry : fs::directory_iterator(probe.path)) {
+            if (entry.path().extension() == ".tmh") segment = entry.path().filename();
+        }
+        CHECK(!segment.empty());
+        size_t journalRows = CountRows(probe.Wide(), { "cpu" });
+        CHECK(journalRows > 0);
+
+        // A directory in the way of the temporary file makes the write fail
+        fs::path blocker = dir.path / segment;
+        blocker += ".tmp";
+        fs::create_directories(blocker);
+        {
+            History failing(dir.Wide(), { "cpu" });
+            float value = 99.0f;
+            failing.Append(kStart + 100 * kStep, &value);
+        }
+        CHECK(fs::exists(dir.path / HistoryFormat::kJournalFileName));
+
+        // Once the way is clear the next run recovers the same rows
+        fs::remove(blocker);
+        { History recovered(dir.Wide(), { "cpu" }); }
+        CHECK(!fs::exists(dir.path / HistoryFormat::kJournalFileName));
+        CHECK(CountRows(dir.Wide(), { "cpu" }) == journalRows + 1);
+    }
+
+    // Two segments over the same range are both kept
+    void TestNameCollision() {
+        TestDirectory dir("history_collision");
+        for (int run = 0; run < 3; run++) {
+            History history(dir.Wide(), { "cpu" });
+            for (int i = 0; i < 10; i++) {
+                float value = (float)(run * 10 + i);
+                history.Append(kStart + i * kStep, &value);
+            }
+        }
+        CHECK(CountFiles(dir.path, ".tmh") == 3);
+        CHECK(CountRows(dir.Wide(), { "cpu" }) == 30);
+
+        QuerySpec spec = {};
+        spec.channel = "cpu";
+        spec.aggregate = Aggregate::Max;
+        spec.startTime = kStart;
+        spec.endTime = kStart + 10 * kStep;
+        std::vector<QueryRow> rows = TelemetryQuery(dir.Wide(), 2).Run(spec);
+        CHECK(rows.size() == 1 && rows[0].value == 29.0 && rows[0].samples == 30);
+    }
+
+    void TestSegmentNames() {
+        int64_t start, end;
+        CHECK(HistoryFormat::ParseSegmentFileName(HistoryFormat::SegmentFileName(10, 20), start, end));
+        CHECK(start == 10 && end == 20);
+        CHECK(!HistoryFormat::ParseSegmentFileName(HistoryFormat::SegmentFileName(10, 20) + L".tmp", start, end));
+        CHECK(!HistoryFormat::ParseSegmentFileName(HistoryFormat::kJournalFileName, start, end));
+        CHECK(HistoryFormat::ParseSegmentFileName(HistoryFormat::SegmentFileName(10, 20, 2), start, end));
+        CHECK(start == 10 && end == 20);
+        CHECK(!HistoryFormat::ParseSegmentFileName(L"seg_10_20x.tmh", start, end));
+        CHECK(!HistoryFormat::ParseSegmentFileName(L"seg_10_20_.tmh", start, end));
+    }
+}
+
+int main() {
+    TestCleanExit();
+    TestCrashRecovery();
+    TestFailedRecovery();
+    TestNameCollision();
+    TestSegmentDuration();
+    TestLateRows();
+    TestTimeAboveSkipsOtherChannels();
+    TestSegmentNames();
+    return TestResult();
+}
@@ -0,0 +1,94 @@
+// hwmon and thermal zone discovery against a fake sysfs tree, and the
+// reader soak samples through
+#include "HwmonSensors.h"
+#include "TestCheck.h"
+#include <fstream>
+
+namespace {
+    void WriteFile(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream out(path, std::ios::trunc);
+        out << text << "\n";
+    }
+
+    // A CPU package and core, a disk, a CPU thermal zone and a wifi card
+    void MakeTree(const std::filesystem::path& root) {
+        std::filesystem::path hwmon = root / "hwmon";
+        std::filesystem::create_directories(hwmon / "hwmon0");
+        WriteFile(hwmon / "hwmon0" / "name", "coretemp");
+        WriteFile(hwmon / "hwmon0" / "temp1_input", "45000");
+        WriteFile(hwmon / "hwmon0" / "temp1_label", "Package id 0");
+        WriteFile(hwmon / "hwmon0" / "temp1_crit_alarm", "0");
+        WriteFile(hwmon / "hwmon0" / "temp2_input", "43500");
+        WriteFile(hwmon / "hwmon0" / "temp2_label", "Core 0");
+
+        std::filesystem::create_directories(hwmon / "hwmon1");
+        WriteFile(hwmon / "hwmon1" / "name", "nvme");
+        WriteFile(hwmon / "hwmon1" / "temp1_input", "38000");
+        WriteFile(hwmon / "hwmon1" / "temp1_alarm", "0");
+
+        std::filesystem::path thermal = root / "thermal";
+        std::filesystem::create_directories(thermal / "thermal_zone2");
+        WriteFile(thermal / "thermal_zone2" / "type", "x86_pkg_temp");
+        WriteFile(thermal / "thermal_zone2" / "temp", "46000");
+        std::filesystem::create_directories(thermal / "thermal_zone5");
+        WriteFile(thermal / "thermal_zone5" / "type", "iwlwifi_1");
+        WriteFile(thermal / "thermal_zone5" / "temp", "41000");
+        std::filesystem::create_directories(thermal / "cooling_device0");
+    }
+
+    void TestFind() {
+        TestDirectory dir("hwmon_find");
+        MakeTree(dir.path);
+
+        auto inputs = FindHwmonInputs((dir.path / "hwmon").string(), (dir.path / "thermal").string());
+        CHECK(inputs.size() == 5);
+        if (inputs.size() != 5) return;
+        CHECK(inputs[0].device == "coretemp" && inputs[0].label == "Package id 0" && inputs[0].cpu);
+        CHECK(inputs[1].label == "Core 0" && inputs[1].zone == -1);
+        CHECK(inputs[2].device == "nvme" && inputs[2].label.empty() && !inputs[2].cpu);
+        CHECK(inputs[3].device == "x86_pkg_temp" && inputs[3].cpu && inputs[3].zone == 2);
+        CHECK(inputs[4].zone == 5 && !inputs[4].cpu);
+
+        // Only the CPU device's alarms
+        auto alarms = FindHwmonAlarms((dir.path / "hwmon").string());
+        CHECK(alarms.size() == 1);
+        CHECK(FindHwmonInputs((dir.path / "missing").string(), (dir.path / "missing").string()).empty());
+    }
+
+    void TestReader() {
+        TestDirectory dir("hwmon_reader");
+        MakeTree(dir.path);
+
+        HwmonReader reader;
+        CHECK(reader.Initialize((dir.path / "hwmon").string(), (dir.path / "thermal").string()));
+        const SensorRegistry& registry = reader.GetRegistry();
+        CHECK(registry.Count() == 5);
+        if (registry.Count() != 5) return;
+        CHECK(registry.Get(0).kind == SensorKind::CpuPackage && std::string(registry.Get(0).key) == "cpu");
+        CHECK(registry.Get(1).kind == SensorKind::CpuCore && std::string(registry.Get(1).key) == "core");
+        CHECK(registry.Get(2).kind == SensorKind::Storage && std::string(registry.Get(2).key) == "disk");
+        CHECK(registry.Get(3).kind == SensorKind::CpuPackage && std::string(registry.Get(3).key) == "cpu1");
+        CHECK(registry.Get(4).kind == SensorKind::Other);
+        CHECK(std::string(registry.Get(0).label) == "coretemp Package id 0");
+
+        SensorSnapshot snapshot;
+        reader.Sample(snapshot);
+        CHECK(snapshot.count == 5);
+        CHECK(snapshot.valid[1] && snapshot.values[1] == 43.5f);
+        CHECK(snapshot.valid[3] && snapshot.values[3] == 46.0f);
+
+        // The files stay open and are read afresh each time
+        WriteFile(dir.path / "hwmon" / "hwmon1" / "temp1_input", "52000");
+        reader.Sample(snapshot);
+        CHECK(snapshot.valid[2] && snapshot.values[2] == 52.0f);
+
+        HwmonReader empty;
+        CHECK(!empty.Initialize((dir.path / "missing").string(), (dir.path / "missing").string()));
+    }
+}
+
+int main() {
+    TestFind();
+    TestReader();
+    return TestResult();
+}
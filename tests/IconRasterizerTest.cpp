@@ -0,0 +1,124 @@
+// Tray icon pixels against hand-drawn expectations
+#include "IconRasterizer.h"
+#include "TestCheck.h"
+#include <vector>
+
+namespace {
+    // '#' text, '.' background, ' ' transparent corner
+    bool Matches(const std::vector<uint32_t>& pixels, TempLevel level, const char* const* rows, int size) {
+        bool same = true;
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                uint32_t expected = rows[y][x] == '#' ? IconRasterizer::kTextColor :
+                    rows[y][x] == '.' ? IconRasterizer::BackgroundColor(level) : 0;
+                if (pixels[y * size + x] != expected) {
+                    fprintf(stderr, "pixel (%d, %d) is %08X, expected '%c'\n", x, y,
+                        pixels[y * size + x], rows[y][x]);
+                    same = false;
+                }
+            }
+        }
+        return same;
+    }
+
+    std::vector<uint32_t> Render(int value, TempLevel level, int size) {
+        // One guard pixel on each side catches writes outside the icon
+        std::vector<uint32_t> buffer(size * size + 2, 0x12345678);
+        IconRasterizer::Render(value, level, size, buffer.data() + 1);
+        CHECK(buffer.front() == 0x12345678 && buffer.back() == 0x12345678);
+        return std::vector<uint32_t>(buffer.begin() + 1, buffer.end() - 1);
+    }
+
+    void TestTwoDigits() {
+        const char* const expected[16] = {
+            " .............. ",
+            "................",
+            "................",
+            ".######..######.",
+            ".######..######.",
+            ".....##......##.",
+            ".....##......##.",
+            ".....##..######.",
+            ".....##..######.",
+            ".....##..##.....",
+            ".....##..##.....",
+            ".....##..######.",
+            ".....##..######.",
+            "................",
+            "................",
+            " .............. ",
+        };
+        CHECK(Matches(Render(72, TempLevel::Warning, 16), TempLevel::Warning, expected, 16));
+    }
+
+    void TestOutOfRange() {
+        const char* const expected[16] = {
+            " .............. ",
+            "................",
+            "................",
+            "................",
+            "................",
+            "................",
+            "................",
+            ".######..######.",
+            ".######..######.",
+            "................",
+            "................",
+            "................",
+            "................",
+            "................",
+            "................",
+            " .............. ",
+        };
+        CHECK(Matches(Render(-1, TempLevel::Normal, 16), TempLevel::Normal, expected, 16));
+        CHECK(Render(1000, TempLevel::Normal, 16) == Render(-5, TempLevel::Normal, 16));
+    }
+
+    void TestScaling() {
+        // A single digit is limited by height: scale 3, 15 px tall from the top row
+        const char* const expected[16] = {
+            " ..#########... ",
+            "...#########....",
+            "...#########....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...###...###....",
+            "...#########....",
+            "...#########....",
+            "...#########....",
+            " .............. ",
+        };
+        CHECK(Matches(Render(0, TempLevel::Danger, 16), TempLevel::Danger, expected, 16));
+
+        // Every size from the 100% to the 200% DPI icon stays in bounds
+        for (int size = 16; size <= 32; size++) {
+            for (int value : { 7, 42, 100, 999 }) {
+                Render(value, TempLevel::Warning, size);
+            }
+        }
+    }
+
+    void TestPalette() {
+        CHECK(IconRasterizer::BackgroundColor(TempLevel::Normal) == 0xFFFFC0CB);
+        CHECK(IconRasterizer::BackgroundColor(TempLevel::Warning) == 0xFFFFC864);
+        CHECK(IconRasterizer::BackgroundColor(TempLevel::Danger) == 0xFFFF6496);
+
+        // Same value and level always gives the same icon
+        CHECK(Render(85, TempLevel::Danger, 24) == Render(85, TempLevel::Danger, 24));
+        CHECK(Render(85, TempLevel::Danger, 24) != Render(85, TempLevel::Warning, 24));
+    }
+}
+
+int main() {
+    TestTwoDigits();
+    TestOutOfRange();
+    TestScaling();
+    TestPalette();
+    return TestResult();
+}
@@ -0,0 +1,171 @@
+// Many dashboard clients on loopback at 10 Hz: every client must see the
+// stream header, a steady flow of frames and the final tick, with the
+// delivery delay reported. Usage: LiveStreamBench [clients] [seconds]
+#include "LiveStream.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    struct Subscriber {
+        int fd;
+        std::string buffer;
+        bool header;
+        int frames;
+        int64_t lastTime;
+    };
+
+    int64_t WallNow() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Takes complete events off the front of the buffer
+    void Parse(Subscriber& s, std::vector<int64_t>& delays) {
+        size_t end;
+        while ((end = s.buffer.find("\n\n")) != std::string::npos) {
+            std::string event = s.buffer.substr(0, end);
+            s.buffer.erase(0, end + 2);
+            if (event.find("event: sensors") != std::string::npos) {
+                s.header = true;
+                continue;
+            }
+            size_t t = event.find("\"t\":");
+            if (t == std::string::npos) continue;
+            int64_t time = strtoll(event.c_str() + t + 4, nullptr, 10);
+            if (time <= s.lastTime) continue;
+            s.lastTime = time;
+            s.frames++;
+            delays.push_back(WallNow() - time);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int clientCount = argc > 1 ? atoi(argv[1]) : 1000;
+    double seconds = argc > 2 ? atof(argv[2]) : 5.0;
+    const int rate = 10;
+
+    // Both ends of every connection live in this process
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)(2 * clientCount + 64)) {
+        limit.rlim_cur = std::min<rlim_t>(limit.rlim_max, 2 * clientCount + 64);
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    SensorRegistry registry;
+    for (int i = 0; i < 16; i++) {
+        registry.Register(SensorKind::CpuCore, SensorUnit::Celsius, registry.MakeKey("core"), "Core");
+    }
+    SampleBus bus;
+    LiveStream stream(bus, registry);
+    CHECK(stream.Start(0));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(stream.GetPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const char request[] = "GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::vector<Subscriber> subscribers;
+    for (int i = 0; i < clientCount; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0 ||
+            send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL) != (ssize_t)sizeof(request) - 1) {
+            if (fd >= 0) close(fd);
+            break;
+        }
+        subscribers.push_back({ fd, std::string(), false, 0, 0 });
+    }
+    CHECK((int)subscribers.size() == clientCount);
+
+    for (int wait = 0; wait < 200 && stream.GetClientCount() < subscribers.size(); wait++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(stream.GetClientCount() == subscribers.size());
+
+    // Every sensor changes every tick, so each frame is a full-size delta
+    const int ticks = (int)(seconds * rate);
+    int64_t lastPublished = 0;
+    std::thread producer([&]() {
+        SensorSnapshot snapshot;
+        auto next = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++) {
+            snapshot.Clear((uint32_t)registry.Count());
+            snapshot.time = WallNow();
+            for (size_t i = 0; i < registry.Count(); i++) {
+                snapshot.Set(i, 40.0f + (float)((tick + i) % 50), SteadyNow());
+            }
+            bus.Publish(snapshot);
+            lastPublished = snapshot.time;
+            next += std::chrono::milliseconds(1000 / rate);
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<pollfd> fds(subscribers.size());
+    std::vector<int64_t> delays;
+    char buffer[65536];
+    double start = TestSeconds();
+    bool producing = true;
+    while (TestSeconds() - start < seconds + 2.0) {
+        for (size_t i = 0; i < subscribers.size(); i++) {
+            fds[i].fd = subscribers[i].fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        poll(fds.data(), fds.size(), 50);
+        for (size_t i = 0; i < subscribers.size(); i++) {
+            if (!(fds[i].revents & POLLIN)) continue;
+            ssize_t received = recv(subscribers[i].fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (received > 0) {
+                subscribers[i].buffer.append(buffer, received);
+                Parse(subscribers[i], delays);
+            }
+        }
+
+        if (producing && TestSeconds() - start >= seconds) {
+            producer.join();
+            producing = false;
+        }
+        if (!producing) {
+            bool done = true;
+            for (const auto& s : subscribers) done = done && s.lastTime == lastPublished;
+            if (done) break;
+        }
+    }
+    if (producing) producer.join();
+
+    int minFrames = ticks;
+    int complete = 0;
+    for (const auto& s : subscribers) {
+        CHECK(s.header);
+        minFrames = std::min(minFrames, s.frames);
+        if (s.lastTime == lastPublished) complete++;
+    }
+    std::sort(delays.begin(), delays.end());
+    printf("%zu clients, %d ticks: fewest frames %d, %d saw the last tick, delay p50 %lld ms p99 %lld ms max %lld ms\n",
+        subscribers.size(), ticks, minFrames, complete,
+        delays.empty() ? -1LL : (long long)delays[delays.size() / 2],
+        delays.empty() ? -1LL : (long long)delays[delays.size() * 99 / 100],
+        delays.empty() ? -1LL : (long long)delays.back());
+
+    // Conflation may merge ticks for a client that falls behind, but every
+    // client stays connected and ends up current
+    CHECK(complete == (int)subscribers.size());
+    CHECK(minFrames >= ticks / 2);
+    CHECK(stream.GetDroppedClients() == 0);
+
+    for (const auto& s : subscribers) close(s.fd);
+    stream.Stop();
+    return TestResult();
+}
@@ -0,0 +1,51 @@
+// Each soak load starts, does work on every worker and stops promptly
+#include "LoadGenerator.h"
+#include "TestCheck.h"
+#include <thread>
+
+namespace {
+    void WaitForWork(const LoadGenerator& generator, uint64_t units) {
+        double start = TestSeconds();
+        while (generator.GetWorkUnits() < units && TestSeconds() - start < 5.0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void TestLoad(SoakLoad load) {
+        LoadGenerator generator;
+        generator.Start(load, 2);
+        CHECK(generator.GetThreadCount() == 2);
+        WaitForWork(generator, 4);
+        CHECK(generator.GetWorkUnits() >= 4);
+
+        double start = TestSeconds();
+        generator.Stop();
+        CHECK(TestSeconds() - start < 1.0);
+        CHECK(generator.GetThreadCount() == 0);
+
+        // Nothing runs once stopped
+        uint64_t units = generator.GetWorkUnits();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(generator.GetWorkUnits() == units);
+    }
+
+    // By default there is a worker for every processor, and a restart
+    // replaces the running load
+    void TestDefaultThreads() {
+        LoadGenerator generator;
+        generator.Start(SoakLoad::Scalar, 0);
+        CHECK(generator.GetThreadCount() >= 1);
+        generator.Start(SoakLoad::Memory, 1);
+        CHECK(generator.GetThreadCount() == 1);
+        WaitForWork(generator, 1);
+        CHECK(generator.GetWorkUnits() >= 1);
+    }
+}
+
+int main() {
+    TestLoad(SoakLoad::Scalar);
+    TestLoad(SoakLoad::Vector);
+    TestLoad(SoakLoad::Memory);
+    TestDefaultThreads();
+    return TestResult();
+}
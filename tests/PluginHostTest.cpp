@@ -0,0 +1,100 @@
+// Loading plugins through the platform loader, and reading them on a
+// ReadPool under the deadline each declares. Usage: PluginHostTest <sample plugin dir> <fake plugin dir>
+#include "PluginHost.h"
+#include "TestCheck.h"
+
+namespace {
+    void AddSources(PluginHost& host, ReadPool& pool) {
+        for (size_t i = 0; i < host.GetPluginCount(); i++) {
+            pool.AddSource([&host, i](std::vector<SensorReading>& readings) { host.ReadPlugin(i, readings); },
+                host.GetReadDeadline(i));
+        }
+        pool.Start();
+    }
+
+    void TestSamplePlugin(const std::wstring& directory) {
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+
+        PluginHost host;
+        CHECK(host.Load(directory, registry) == 1);
+        CHECK(registry.Count() == 3);
+        CHECK(registry.Find("inlet") == 1 && registry.Find("pdu") == 2);
+        CHECK(std::string(registry.Get(1).label) == "Rack Inlet");
+
+        ReadPool pool;
+        AddSources(host, pool);
+        SensorSnapshot snapshot;
+        snapshot.Clear((uint32_t)registry.Count());
+        pool.Collect(snapshot, 1000);
+        CHECK(!snapshot.valid[0]);
+        CHECK(snapshot.valid[1] && snapshot.valid[2]);
+        CHECK_NEAR(snapshot.values[1], 24.0, 3.0);
+        CHECK_NEAR(snapshot.values[2], 35.0, 5.0);
+
+        // A second load of the same directory gets fresh keys
+        PluginHost second;
+        CHECK(second.Load(directory, registry) == 1);
+        CHECK(registry.Find("inlet1") == 3);
+
+        CHECK(pool.Stop());
+        host.Unload();
+        CHECK(host.GetPluginCount() == 0);
+    }
+
+    void TestMisbehaving(const std::wstring& directory) {
+        SensorRegistry registry;
+        PluginHost host;
+
+        // The plugin whose open fails aborts if closed; only the hanging one loads
+        CHECK(host.Load(directory, registry) == 1);
+        CHECK(registry.Count() == 1);
+
+        // The plugin's own 50 ms deadline ends the wait, not the tick's
+        CHECK(host.GetReadDeadline(0) == 50);
+        ReadPool pool;
+        AddSources(host, pool);
+        SensorSnapshot snapshot;
+        snapshot.Clear((uint32_t)registry.Count());
+        double start = TestSeconds();
+        pool.Collect(snapshot, 1000);
+        double first = TestSeconds() - start;
+        CHECK(!snapshot.valid[0]);
+        CHECK(first >= 0.04 && first < 0.5);
+        CHECK(pool.GetLateCount(0) == 1);
+
+        // While the read is outstanding the next tick does not wait at all
+        start = TestSeconds();
+        snapshot.Clear((uint32_t)registry.Count());
+        pool.Collect(snapshot, 50);
+        CHECK(TestSeconds() - start < 0.02);
+        CHECK(!snapshot.valid[0]);
+
+        // The pool leaves the hung worker behind, and the host leaves the
+        // plugin it is in loaded, each after its own timeout
+        start = TestSeconds();
+        CHECK(!pool.Stop());
+        host.Unload();
+        double unload = TestSeconds() - start;
+        CHECK(unload < (ReadPool::kShutdownTimeout + PluginHost::kShutdownTimeout) / 1000.0 + 0.5);
+        CHECK(host.GetPluginCount() == 0);
+    }
+
+    void TestMissingDirectory() {
+        SensorRegistry registry;
+        PluginHost host;
+        CHECK(host.Load(L"no_such_plugin_directory", registry) == 0);
+        host.Unload();
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: PluginHostTest <sample plugin dir> <fake plugin dir>\n");
+        return 2;
+    }
+    TestSamplePlugin(std::filesystem::path(argv[1]).wstring());
+    TestMisbehaving(std::filesystem::path(argv[2]).wstring());
+    TestMissingDirectory();
+    return TestResult();
+}
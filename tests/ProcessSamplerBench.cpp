@@ -0,0 +1,104 @@
+// Cost of one ProcessSampler tick with many live processes, and a check
+// that a busy process is ranked first. Usage: ProcessSamplerBench [processes]
+#include "ProcessSampler.h"
+#include "TestCheck.h"
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Stat lines from a fake proc root, including a comm with spaces and ')'
+static void TestParse() {
+    TestDirectory dir("process_sampler");
+    auto writeStat = [&](int pid, const std::string& comm, int utime, int stime, int start) {
+        std::filesystem::create_directories(dir.path / std::to_string(pid));
+        std::ofstream out(dir.path / std::to_string(pid) / "stat");
+        out << pid << " (" << comm << ") S 1 1 1 0 -1 4194304 10 0 0 0 " << utime << " " << stime
+            << " 0 0 20 0 1 0 " << start << " 1000 100 18446744073709551615\n";
+    };
+    writeStat(10, "idle", 0, 0, 5);
+    writeStat(20, "web (x) y", 100, 50, 7);
+    writeStat(30, "reused", 10, 0, 9);
+    std::filesystem::create_directories(dir.path / "self");
+
+    ProcessSampler sampler(nullptr, dir.path.string());
+    CHECK(sampler.Initialize());
+    CHECK(sampler.Sample());
+    CHECK(sampler.GetProcessCount() == 3);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    writeStat(20, "web (x) y", 120, 60, 7);   // 30 ticks later
+    writeStat(30, "reused", 500, 0, 11);      // new process under an old pid
+    CHECK(sampler.Sample());
+
+    std::vector<ProcessUsage> top;
+    sampler.GetTopConsumers(5, top);
+    CHECK(top.size() == 1);
+    if (!top.empty()) {
+        CHECK(top[0].pid == 20);
+        CHECK(std::wstring(top[0].name) == L"web (x) y");
+        CHECK(top[0].cpuPercent > 0.0f);
+    }
+    CHECK(ProcessSampler::FormatConsumers(top).find(L"web (x) y ") == 0);
+}
+
+int main(int argc, char** argv) {
+    int processCount = argc > 1 ? atoi(argv[1]) : 1000;
+
+    TestParse();
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < processCount; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            pause();
+            _exit(0);
+        }
+        if (pid < 0) break;
+        children.push_back(pid);
+    }
+    pid_t busy = fork();
+    if (busy == 0) {
+        for (volatile unsigned long spin = 0;; spin++) {
+        }
+    }
+    printf("%zu idle processes + 1 busy\n", children.size());
+    CHECK((int)children.size() == processCount);
+
+    ProcessSampler sampler;
+    CHECK(sampler.Initialize());
+    CHECK(sampler.Sample());
+
+    const int ticks = 10;
+    double total = 0.0;
+    double worst = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        CHECK(sampler.Sample());
+        total += sampler.GetLastSampleMicros();
+        worst = std::max(worst, sampler.GetLastSampleMicros());
+    }
+    printf("%zu processes: %.0f us per tick (worst %.0f us)\n", sampler.GetProcessCount(),
+        total / ticks, worst);
+    CHECK(sampler.GetProcessCount() > children.size());
+
+    // The spinning child ranks first. Its share is at most one whole
+    // processor, and other tests may be competing for that processor.
+    std::vector<ProcessUsage> top;
+    sampler.GetTopConsumers(3, top);
+    CHECK(!top.empty());
+    if (!top.empty()) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        printf("top: %ls\n", ProcessSampler::FormatConsumers(top).c_str());
+        CHECK(top[0].pid == (uint32_t)busy);
+        CHECK(top[0].cpuPercent * cpus > 20.0f && top[0].cpuPercent * cpus < 135.0f);
+    }
+
+    children.push_back(busy);
+    for (pid_t pid : children) kill(pid, SIGKILL);
+    for (pid_t pid : children) waitpid(pid, nullptr, 0);
+    return TestResult();
+}
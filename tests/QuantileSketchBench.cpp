@@ -0,0 +1,67 @@
+// Cost of adding to, merging and querying sketches, against sorting the
+// raw values. Usage: QuantileSketchBench [values] [sketches]
+#include "QuantileSketch.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char** argv) {
+    size_t valueCount = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t sketchCount = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000;
+
+    std::mt19937 random(1);
+    std::normal_distribution<double> temps(60.0, 12.0);
+    std::vector<double> values(valueCount);
+    for (auto& v : values) v = std::max(1.0, temps(random));
+
+    double start = TestSeconds();
+    QuantileSketch sketch;
+    for (double v : values) sketch.Add(v);
+    double add = TestSeconds() - start;
+
+    start = TestSeconds();
+    double p99 = 0.0;
+    const int queries = 1000;
+    for (int i = 0; i < queries; i++) p99 += sketch.Quantile(0.99);
+    p99 /= queries;
+    double query = TestSeconds() - start;
+
+    std::vector<double> copy = values;
+    start = TestSeconds();
+    size_t rank = (size_t)(0.99 * (copy.size() - 1));
+    std::nth_element(copy.begin(), copy.begin() + rank, copy.end());
+    double exact = copy[rank];
+    double select = TestSeconds() - start;
+
+    printf("%zu values: add %.1f ns/value, p99 %.2f us/query, nth_element %.1f ms\n", valueCount,
+        add * 1e9 / valueCount, query * 1e6 / queries, select * 1e3);
+    printf("p99 %.3f vs exact %.3f, %zu bytes vs %zu raw\n", p99, exact, sketch.Serialize().size(),
+        valueCount * sizeof(double));
+    CHECK(std::fabs(p99 - exact) / exact <= QuantileSketch::kDefaultAccuracy * (1.0 + 1e-9));
+
+    // Per-segment sketches rolled up into one, as a fleet query would
+    std::vector<QuantileSketch> parts(sketchCount);
+    for (size_t i = 0; i < values.size(); i++) parts[i % sketchCount].Add(values[i]);
+    start = TestSeconds();
+    QuantileSketch merged;
+    for (const auto& part : parts) merged.Merge(part);
+    double merge = TestSeconds() - start;
+
+    start = TestSeconds();
+    QuantileSketch loaded;
+    size_t bytes = 0;
+    for (const auto& part : parts) {
+        std::string data = part.Serialize();
+        bytes += data.size();
+        loaded.Deserialize(data);
+    }
+    double roundTrip = TestSeconds() - start;
+
+    printf("%zu sketches: merge %.2f us each, serialize + load %.2f us each (%zu bytes)\n", sketchCount,
+        merge * 1e6 / sketchCount, roundTrip * 1e6 / sketchCount, bytes / sketchCount);
+    CHECK(merged.GetCount() == sketch.GetCount());
+    CHECK(merged.Quantile(0.99) == sketch.Quantile(0.99));
+    return TestResult();
+}
@@ -0,0 +1,170 @@
+// Quantiles stay within the relative error bound against exact order
+// statistics, for merged, folded and serialized sketches
+#include "QuantileSketch.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+    const double kQuantiles[] = { 0.0, 0.01, 0.1, 0.5, 0.9, 0.95, 0.99, 0.999, 1.0 };
+
+    // Same rank rule as QuantileSketch::Quantile
+    double Exact(const std::vector<double>& sorted, double q) {
+        return sorted[(size_t)(q * (double)(sorted.size() - 1))];
+    }
+
+    // Worst relative error over kQuantiles; values at or below
+    // kMinIndexable are only required to come back as the minimum
+    double WorstError(const QuantileSketch& sketch, std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        double worst = 0.0;
+        for (double q : kQuantiles) {
+            double exact = Exact(values, q);
+            double estimate = sketch.Quantile(q);
+            if (exact <= QuantileSketch::kMinIndexable) {
+                CHECK(estimate == values.front());
+                continue;
+            }
+            worst = std::max(worst, std::fabs(estimate - exact) / exact);
+        }
+        return worst;
+    }
+
+    std::vector<double> Generate(int shape, size_t n, std::mt19937& random) {
+        std::uniform_real_distribution<double> uniform(20.0, 100.0);
+        std::lognormal_distribution<double> lognormal(3.5, 0.6);
+        std::exponential_distribution<double> exponential(0.05);
+        std::normal_distribution<double> idle(42.0, 1.5), load(88.0, 3.0);
+        std::vector<double> values(n);
+        for (auto& v : values) {
+            switch (shape) {
+            case 0: v = uniform(random); break;
+            case 1: v = lognormal(random); break;
+            case 2: v = exponential(random); break;
+            default: v = (random() % 10 == 0) ? load(random) : idle(random); break;   // mostly idle, some load
+            }
+        }
+        return values;
+    }
+
+    void TestAccuracy() {
+        std::mt19937 random(3);
+        for (double accuracy : { 0.01, 0.005, 0.05 }) {
+            for (int shape = 0; shape < 4; shape++) {
+                std::vector<double> values = Generate(shape, 50000, random);
+                QuantileSketch sketch(accuracy);
+                for (double v : values) sketch.Add(v);
+
+                CHECK(sketch.GetCount() == values.size());
+                CHECK(sketch.GetMin() == *std::min_element(values.begin(), values.end()));
+                CHECK(sketch.GetMax() == *std::max_element(values.begin(), values.end()));
+                double worst = WorstError(sketch, values);
+                CHECK(worst <= accuracy * (1.0 + 1e-9));
+                printf("accuracy %.3f shape %d: worst error %.4f\n", accuracy, shape, worst);
+            }
+        }
+    }
+
+    void TestMerge() {
+        std::mt19937 random(5);
+        std::vector<double> all;
+        QuantileSketch whole;
+        QuantileSketch merged;
+        for (int part = 0; part < 8; part++) {
+            std::vector<double> values = Generate(part % 4, 5000, random);
+            QuantileSketch sketch;
+            for (double v : values) {
+                sketch.Add(v);
+                whole.Add(v);
+            }
+            CHECK(merged.Merge(sketch));
+            all.insert(all.end(), values.begin(), values.end());
+        }
+
+        // Merging adds bins, so it answers exactly like one sketch of everything
+        CHECK(merged.GetCount() == whole.GetCount());
+        for (double q : kQuantiles) {
+            CHECK(merged.Quantile(q) == whole.Quantile(q));
+        }
+        CHECK(WorstError(merged, all) <= QuantileSketch::kDefaultAccuracy * (1.0 + 1e-9));
+
+        QuantileSketch coarse(0.05);
+        CHECK(!merged.Merge(coarse));
+        QuantileSketch empty;
+        CHECK(merged.Merge(empty) && merged.GetCount() == whole.GetCount());
+        CHECK(empty.Merge(merged) && empty.Quantile(0.99) == merged.Quantile(0.99));
+    }
+
+    void TestFolding() {
+        // Nine decades need far more than kMaxBins at 1%; the low end folds
+        // but the upper quantiles keep the bound
+        std::mt19937 random(9);
+        std::uniform_real_distribution<double> exponent(-2.0, 7.0);
+        std::vector<double> values(100000);
+        QuantileSketch sketch;
+        for (auto& v : values) {
+            v = std::pow(10.0, exponent(random));
+            sketch.Add(v);
+        }
+        std::sort(values.begin(), values.end());
+        for (double q : { 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+            double exact = Exact(values, q);
+            CHECK(std::fabs(sketch.Quantile(q) - exact) / exact <= QuantileSketch::kDefaultAccuracy * (1.0 + 1e-9));
+        }
+        // Folded values report their bin, which is never below the minimum
+        CHECK(sketch.Quantile(0.0) >= values.front() && sketch.GetMin() == values.front());
+        CHECK(sketch.Serialize().size() <= 64 + QuantileSketch::kMaxBins * sizeof(uint64_t));
+
+        // Same when the range grows downwards instead
+        QuantileSketch down;
+        for (size_t i = values.size(); i-- > 0;) down.Add(values[i]);
+        for (double q : { 0.5, 0.99, 1.0 }) {
+            double exact = Exact(values, q);
+            CHECK(std::fabs(down.Quantile(q) - exact) / exact <= QuantileSketch::kDefaultAccuracy * (1.0 + 1e-9));
+        }
+    }
+
+    void TestEdges() {
+        QuantileSketch sketch;
+        CHECK(std::isnan(sketch.Quantile(0.5)));
+
+        // Zero, negative and NaN readings
+        sketch.Add(0.0, 10);
+        sketch.Add(-5.0);
+        sketch.Add(NAN);
+        sketch.Add(50.0, 0);
+        CHECK(sketch.GetCount() == 11);
+        CHECK(sketch.Quantile(0.5) == -5.0);
+        sketch.Add(70.0, 89);
+        CHECK(sketch.GetCount() == 100);
+        CHECK_NEAR(sketch.Quantile(0.99), 70.0, 0.7);
+        CHECK(sketch.Quantile(0.05) == -5.0);
+        CHECK(sketch.Quantile(2.0) == 70.0 && sketch.Quantile(-1.0) == -5.0);
+        CHECK_NEAR(sketch.GetSum(), 70.0 * 89 - 5.0, 1e-9);
+
+        // Round trip, then reject anything damaged
+        QuantileSketch loaded;
+        std::string data = sketch.Serialize();
+        CHECK(loaded.Deserialize(data));
+        CHECK(loaded.Serialize() == data);
+        for (double q : kQuantiles) CHECK(loaded.Quantile(q) == sketch.Quantile(q));
+
+        CHECK(!loaded.Deserialize(data.substr(0, data.size() - 1)));
+        std::string bad = data;
+        bad[0] ^= 1;
+        CHECK(!loaded.Deserialize(bad));
+        CHECK(loaded.Serialize() == data);   // failed loads leave it untouched
+
+        sketch.Clear();
+        CHECK(sketch.GetCount() == 0 && std::isnan(sketch.Quantile(1.0)));
+    }
+}
+
+int main() {
+    TestAccuracy();
+    TestMerge();
+    TestFolding();
+    TestEdges();
+    return TestResult();
+}
@@ -0,0 +1,85 @@
+// Query throughput over a synthetic history against the number of scan
+// threads. Usage: QueryBench [segments] [channels]
+#include "History.h"
+#include "TelemetryQuery.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+int main(int argc, char** argv) {
+    int segments = argc > 1 ? atoi(argv[1]) : 200;
+    int channelCount = argc > 2 ? atoi(argv[2]) : 8;
+
+    TestDirectory dir("query_bench");
+    std::vector<std::string> channels;
+    for (int c = 0; c < channelCount; c++) {
+        channels.push_back("cpu" + std::to_string(c));
+    }
+
+    const int64_t start = 1700000000000LL;
+    const int64_t step = 2000;
+    const int64_t rowsPerSegment = HistoryFormat::kSegmentDuration / step;
+    int64_t time = start;
+    {
+        History history(dir.Wide(), channels);
+        std::mt19937 random(1);
+        std::normal_distribution<float> noise(0.0f, 2.0f);
+        std::vector<float> values(channelCount);
+        for (int s = 0; s < segments; s++) {
+            for (int64_t i = 0; i < rowsPerSegment; i++, time += step) {
+                for (int c = 0; c < channelCount; c++) {
+                    values[c] = 55.0f + 15.0f * (float)std::sin(time / 3.6e6) + noise(random);
+                }
+                history.Append(time, values.data());
+            }
+            history.Flush();
+        }
+    }
+    printf("%d segments, %lld rows, %d channels\n", segments,
+        (long long)(segments * rowsPerSegment), channelCount);
+
+    QuerySpec spec = {};
+    spec.channel = "cpu0";
+    spec.startTime = start;
+    spec.endTime = time;
+    spec.bucketSize = 24 * 3600 * 1000LL;
+    spec.percentile = 99;
+    spec.threshold = 65;
+
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    const Aggregate aggregates[] = { Aggregate::Percentile, Aggregate::TimeAbove, Aggregate::Mean };
+    const char* names[] = { "p99", "above", "mean" };
+    for (size_t a = 0; a < 3; a++) {
+        spec.aggregate = aggregates[a];
+        double single = 0.0;
+        std::vector<QueryRow> reference;
+        for (unsigned threads : threadCounts) {
+            TelemetryQuery query(dir.Wide(), threads);
+            query.Run(spec);   // warm the file cache
+
+            double begin = TestSeconds();
+            std::vector<QueryRow> rows = query.Run(spec);
+            double seconds = TestSeconds() - begin;
+            if (threads == 1) {
+                single = seconds;
+                reference = rows;
+            }
+
+            // Every thread count must give the same answer
+            CHECK(rows.size() == reference.size());
+            for (size_t r = 0; r < rows.size() && r < reference.size(); r++) {
+                CHECK(rows[r].samples == reference[r].samples);
+                CHECK_NEAR(rows[r].value, reference[r].value, 1e-6);
+            }
+            printf("%-6s %2u threads  %8.2f ms  speedup %.2fx\n", names[a], threads,
+                seconds * 1000.0, single / seconds);
+        }
+    }
+    return TestResult();
+}
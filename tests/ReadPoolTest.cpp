@@ -0,0 +1,215 @@
+// Fake sources that inject latency and hangs: the per-tick deadline, late
+// results, per-sensor last good values and shutdown with a hung source
+#include "ReadPool.h"
+#include "TestCheck.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+    // Reports one reading per sensor, numbered by read, after a delay;
+    // while hung every read blocks until released
+    struct FakeSource {
+        std::vector<uint16_t> sensors;
+        std::atomic<int> latency{0};          // ms
+        std::atomic<int> reads{0};
+        std::atomic<bool> skipSecond{false};  // leave the second sensor out
+        std::atomic<int64_t> age{0};          // ms to backdate readings by
+        std::mutex mutex;
+        std::condition_variable released;
+        bool hung = false;
+
+        explicit FakeSource(std::vector<uint16_t> ids) : sensors(ids) {}
+
+        void Read(std::vector<SensorReading>& readings) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                released.wait(lock, [&] { return !hung; });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(latency));
+            int n = ++reads;
+            for (size_t i = 0; i < sensors.size(); i++) {
+                if (i == 1 && skipSecond) continue;
+                readings.push_back({ sensors[i], (float)n, SteadyNow() - age });
+            }
+        }
+
+        void Hang() {
+            std::lock_guard<std::mutex> lock(mutex);
+            hung = true;
+        }
+
+        void Release() {
+            std::lock_guard<std::mutex> lock(mutex);
+            hung = false;
+            released.notify_all();
+        }
+    };
+
+    void Add(ReadPool& pool, FakeSource& source) {
+        pool.AddSource([&source](std::vector<SensorReading>& readings) { source.Read(readings); });
+    }
+
+    double Collect(ReadPool& pool, SensorSnapshot& snapshot, int deadlineMs,
+                   std::vector<SensorReading>* fresh = nullptr) {
+        snapshot.Clear(4);
+        double start = TestSeconds();
+        pool.Collect(snapshot, deadlineMs, fresh);
+        return TestSeconds() - start;
+    }
+
+    void TestLateResultIsFresh() {
+        FakeSource fast({ 0 });
+        FakeSource slow({ 1 });
+        slow.latency = 150;
+
+        ReadPool pool;
+        Add(pool, fast);
+        Add(pool, slow);
+        pool.Start();
+
+        SensorSnapshot snapshot;
+        double elapsed = Collect(pool, snapshot, 50);
+        CHECK(elapsed >= 0.04 && elapsed < 0.12);
+        CHECK(snapshot.valid[0] && !snapshot.stale[0]);
+        CHECK(!snapshot.valid[1]);   // nothing good to fall back on yet
+        CHECK(pool.GetLateCount(0) == 0 && pool.GetLateCount(1) == 1);
+
+        // The slow read lands between ticks; the next tick reports it fresh,
+        // and hands it to fresh, even though the restarted read misses again
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::vector<SensorReading> fresh;
+        Collect(pool, snapshot, 50, &fresh);
+        CHECK(snapshot.valid[1] && !snapshot.stale[1]);
+        CHECK(snapshot.values[1] == 1.0f);
+        CHECK(pool.GetLateCount(1) == 1);
+        bool delivered = false;
+        for (const auto& reading : fresh) {
+            if (reading.sensor == 1 && reading.value == 1.0f) delivered = true;
+        }
+        CHECK(delivered);
+
+        // With no result in between, the same value is now stale
+        Collect(pool, snapshot, 50);
+        CHECK(snapshot.valid[1] && snapshot.stale[1]);
+        CHECK(snapshot.values[1] == 1.0f);
+        CHECK(pool.GetLateCount(1) == 2);
+        CHECK(pool.Stop());
+    }
+
+    // A source with a short deadline of its own does not hold up the tick;
+    // one with a longer deadline is still cut off by the tick's
+    void TestSourceDeadline() {
+        FakeSource fast({ 0 });
+        FakeSource slow({ 1 });
+        FakeSource patient({ 2 });
+        slow.latency = 200;
+        patient.latency = 200;
+
+        ReadPool pool;
+        Add(pool, fast);
+        pool.AddSource([&slow](std::vector<SensorReading>& readings) { slow.Read(readings); }, 30);
+        pool.Start();
+        SensorSnapshot snapshot;
+        double elapsed = Collect(pool, snapshot, 1000);
+        CHECK(elapsed >= 0.025 && elapsed < 0.15);
+        CHECK(snapshot.valid[0] && !snapshot.valid[1]);
+        CHECK(pool.GetLateCount(1) == 1);
+        CHECK(pool.Stop());
+
+        ReadPool capped;
+        capped.AddSource([&patient](std::vector<SensorReading>& readings) { patient.Read(readings); }, 5000);
+        capped.Start();
+        elapsed = Collect(capped, snapshot, 50);
+        CHECK(elapsed >= 0.04 && elapsed < 0.15);
+        CHECK(capped.GetLateCount(0) == 1);
+        CHECK(capped.Stop());
+    }
+
+    void TestLastGoodPerSensor() {
+        FakeSource source({ 0, 1 });
+        ReadPool pool;
+        Add(pool, source);
+        pool.Start();
+
+        SensorSnapshot snapshot;
+        Collect(pool, snapshot, 500);
+        CHECK(snapshot.valid[0] && snapshot.valid[1]);
+
+        // A completed read that leaves a sensor out keeps that sensor's value
+        source.skipSecond = true;
+        Collect(pool, snapshot, 500);
+        CHECK(snapshot.valid[0] && !snapshot.stale[0] && snapshot.values[0] == 2.0f);
+        CHECK(snapshot.valid[1] && snapshot.stale[1] && snapshot.values[1] == 1.0f);
+        CHECK(pool.GetLateCount(0) == 0);
+        CHECK(pool.Stop());
+    }
+
+    void TestHungSource() {
+        // Outlives the worker the pool leaves behind
+        static FakeSource hung({ 0 });
+        FakeSource healthy({ 1 });
+        hung.age = ReadPool::kMaxStaleAge - 100;
+
+        ReadPool pool;
+        Add(pool, hung);
+        Add(pool, healthy);
+        pool.Start();
+
+        SensorSnapshot snapshot;
+        Collect(pool, snapshot, 500);
+        CHECK(snapshot.valid[0] && !snapshot.stale[0]);
+
+        // The hung source costs one deadline, then nothing while it stays hung
+        hung.Hang();
+        double first = Collect(pool, snapshot, 50);
+        CHECK(first >= 0.04 && first < 0.12);
+        CHECK(snapshot.valid[0] && snapshot.stale[0]);
+        CHECK(snapshot.valid[1] && !snapshot.stale[1]);
+
+        for (int i = 0; i < 5; i++) {
+            double elapsed = Collect(pool, snapshot, 50);
+            CHECK(elapsed < 0.03);
+            CHECK(snapshot.valid[1] && !snapshot.stale[1]);
+        }
+
+        // Its last value expires after kMaxStaleAge
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        Collect(pool, snapshot, 50);
+        CHECK(!snapshot.valid[0]);
+        CHECK(snapshot.valid[1]);
+        CHECK(pool.GetLateCount(0) == 7);
+
+        double start = TestSeconds();
+        CHECK(!pool.Stop());
+        CHECK(TestSeconds() - start < ReadPool::kShutdownTimeout / 1000.0 + 0.5);
+        hung.Release();
+    }
+
+    void TestBufferedSource() {
+        ReadPool pool;
+        pool.AddSource([](std::vector<SensorReading>& readings) {
+            int64_t now = SteadyNow();
+            readings.push_back({ 0, 1.0f, now - 20 });
+            readings.push_back({ 0, 3.0f, now });
+            readings.push_back({ 0, 2.0f, now - 10 });
+        });
+        pool.Start();
+
+        SensorSnapshot snapshot;
+        std::vector<SensorReading> fresh;
+        Collect(pool, snapshot, 500, &fresh);
+        CHECK(snapshot.valid[0] && snapshot.values[0] == 3.0f);
+        CHECK(fresh.size() == 3);
+        CHECK(pool.Stop());
+    }
+}
+
+int main() {
+    TestLateResultIsFresh();
+    TestSourceDeadline();
+    TestLastGoodPerSensor();
+    TestHungSource();
+    TestBufferedSource();
+    return TestResult();
+}
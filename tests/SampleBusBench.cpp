@@ -0,0 +1,52 @@
+// Publish throughput and delivery latency against the number of sinks.
+// Usage: SampleBusBench [snapshots]
+#include "SampleBus.h"
+#include "TestCheck.h"
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main(int argc, char** argv) {
+    uint64_t total = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    const SinkPolicy policies[] = { SinkPolicy::DropOldest, SinkPolicy::Conflate, SinkPolicy::Block };
+    const char* names[] = { "drop-oldest", "conflate", "block" };
+    for (size_t p = 0; p < 3; p++) {
+        for (int sinkCount : { 0, 1, 2, 4 }) {
+            SampleBus bus(1024);
+            std::vector<uint64_t> received(sinkCount, 0);
+            std::vector<double> latency(sinkCount, 0.0);
+            std::vector<std::unique_ptr<SinkWorker>> sinks;
+            for (int s = 0; s < sinkCount; s++) {
+                sinks.emplace_back(new SinkWorker(bus, policies[p], [&, s](const SensorSnapshot& snapshot) {
+                    received[s]++;
+                    latency[s] += TestSeconds() - snapshot.time / 1e9;
+                }));
+            }
+
+            SensorSnapshot snapshot;
+            snapshot.Clear(kMaxSensors);
+            for (size_t i = 0; i < kMaxSensors; i++) snapshot.Set(i, 50.0f, 0);
+
+            double start = TestSeconds();
+            for (uint64_t n = 0; n < total; n++) {
+                snapshot.time = (int64_t)(TestSeconds() * 1e9);
+                bus.Publish(snapshot);
+            }
+            double seconds = TestSeconds() - start;
+            for (auto& sink : sinks) sink->Stop();
+
+            uint64_t delivered = 0;
+            double meanLatency = 0.0;
+            for (int s = 0; s < sinkCount; s++) {
+                delivered += received[s];
+                if (received[s]) meanLatency += latency[s] / received[s] / sinkCount;
+                CHECK(received[s] + bus.GetDropped(s) == total || policies[p] == SinkPolicy::Conflate);
+            }
+            printf("%-11s %d sinks  %6.2f M/s  delivered %5.1f%%  latency %7.1f us\n", names[p], sinkCount,
+                total / seconds / 1e6, sinkCount ? 100.0 * delivered / (total * sinkCount) : 0.0,
+                meanLatency * 1e6);
+        }
+    }
+    return TestResult();
+}
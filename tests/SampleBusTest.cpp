@@ -0,0 +1,201 @@
+// Sink policies under a producer that never waits, torn-read detection,
+// and sinks added while others are running
+#include "SampleBus.h"
+#include "TestCheck.h"
+#include <thread>
+#include <vector>
+
+namespace {
+    // Every value of snapshot n is derived from n, so a torn copy shows up
+    void Fill(SensorSnapshot& snapshot, uint64_t n) {
+        snapshot.Clear(kMaxSensors);
+        snapshot.time = (int64_t)n;
+        for (size_t i = 0; i < kMaxSensors; i++) {
+            snapshot.Set(i, (float)(n % 1000) + i, (int64_t)n);
+        }
+    }
+
+    bool Intact(const SensorSnapshot& snapshot) {
+        uint64_t n = (uint64_t)snapshot.time;
+        for (size_t i = 0; i < kMaxSensors; i++) {
+            if (snapshot.values[i] != (float)(n % 1000) + i || snapshot.timestamps[i] != (int64_t)n) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct Received {
+        uint64_t count = 0;
+        uint64_t torn = 0;
+        uint64_t reordered = 0;
+        int64_t last = -1;
+    };
+
+    void Record(Received& received, const SensorSnapshot& snapshot) {
+        if (!Intact(snapshot)) received.torn++;
+        if (snapshot.time <= received.last) received.reordered++;
+        received.last = snapshot.time;
+        received.count++;
+    }
+
+    void TestPolicies() {
+        const uint64_t total = 200000;
+        SampleBus bus(64);
+        Received fast, slow, latest;
+
+        SinkWorker fastSink(bus, SinkPolicy::DropOldest, [&](const SensorSnapshot& s) { Record(fast, s); });
+        SinkWorker slowSink(bus, SinkPolicy::DropOldest, [&](const SensorSnapshot& s) {
+            Record(slow, s);
+            if (s.time % 1000 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        });
+        SinkWorker conflate(bus, SinkPolicy::Conflate, [&](const SensorSnapshot& s) { Record(latest, s); });
+
+        SensorSnapshot snapshot;
+        for (uint64_t n = 0; n < total; n++) {
+            Fill(snapshot, n);
+            bus.Publish(snapshot);
+        }
+        fastSink.Stop();
+        slowSink.Stop();
+        conflate.Stop();
+
+        // Nothing torn or out of order, and every snapshot is either
+        // delivered or counted as dropped
+        for (Received* r : { &fast, &slow, &latest }) {
+            CHECK(r->torn == 0);
+            CHECK(r->reordered == 0);
+            CHECK(r->count > 0);
+            CHECK(r->last == (int64_t)total - 1);
+        }
+        CHECK(fast.count + bus.GetDropped(0) == total);
+        CHECK(slow.count + bus.GetDropped(1) == total);
+        CHECK(bus.GetPublished() == total);
+        printf("delivered: fast %llu, slow %llu, conflate %llu of %llu\n",
+            (unsigned long long)fast.count, (unsigned long long)slow.count,
+            (unsigned long long)latest.count, (unsigned long long)total);
+    }
+
+    void TestBlock() {
+        // A blocking sink that keeps up loses nothing
+        const uint64_t total = 20000;
+        SampleBus bus(16);
+        Received received;
+        SinkWorker sink(bus, SinkPolicy::Block, [&](const SensorSnapshot& s) { Record(received, s); });
+
+        SensorSnapshot snapshot;
+        for (uint64_t n = 0; n < total; n++) {
+            Fill(snapshot, n);
+            bus.Publish(snapshot);
+        }
+        sink.Stop();
+        CHECK(received.torn == 0 && received.reordered == 0);
+        CHECK(received.count + bus.GetDropped(0) == total);
+        CHECK(bus.GetBlockTimeouts() > 0 || bus.GetDropped(0) == 0);
+
+        // One that stops reading holds the producer for kBlockTimeout, then is lapped
+        SampleBus stalled(4);
+        int id = stalled.AddSink(SinkPolicy::Block);
+        for (uint64_t n = 0; n < 4; n++) {
+            Fill(snapshot, n);
+            stalled.Publish(snapshot);
+        }
+        double start = TestSeconds();
+        Fill(snapshot, 4);
+        stalled.Publish(snapshot);
+        double waited = TestSeconds() - start;
+        CHECK(waited >= SampleBus::kBlockTimeout / 1000.0 * 0.9);
+        CHECK(stalled.GetBlockTimeouts() == 1);
+        CHECK(stalled.Poll(id, snapshot) && snapshot.time == 1);
+        CHECK(stalled.GetDropped(id) == 1);
+    }
+
+    void TestLateSinks() {
+        // Adding sinks while others poll must not move the existing ones
+        const uint64_t total = 50000;
+        SampleBus bus(64);
+        Received first;
+        SinkWorker firstSink(bus, SinkPolicy::DropOldest, [&](const SensorSnapshot& s) { Record(first, s); });
+
+        std::vector<std::unique_ptr<Received>> late;
+        std::vector<std::unique_ptr<SinkWorker>> workers;
+        SensorSnapshot snapshot;
+        for (uint64_t n = 0; n < total; n++) {
+            if (n % 5000 == 4999 && workers.size() + 1 < SampleBus::kMaxSinks) {
+                late.emplace_back(new Received());
+                Received* r = late.back().get();
+                workers.emplace_back(new SinkWorker(bus, SinkPolicy::DropOldest,
+                    [r](const SensorSnapshot& s) { Record(*r, s); }));
+            }
+            Fill(snapshot, n);
+            bus.Publish(snapshot);
+        }
+        firstSink.Stop();
+        for (auto& worker : workers) worker->Stop();
+
+        CHECK(first.torn == 0 && first.count + bus.GetDropped(0) == total);
+        for (size_t i = 0; i < late.size(); i++) {
+            CHECK(late[i]->torn == 0 && late[i]->reordered == 0);
+            CHECK(late[i]->last == (int64_t)total - 1);
+        }
+
+        SampleBus full;
+        for (size_t i = 0; i < SampleBus::kMaxSinks; i++) {
+            CHECK(full.AddSink(SinkPolicy::Conflate) == (int)i);
+        }
+        CHECK(full.AddSink(SinkPolicy::Conflate) == -1);
+    }
+
+    // One worker more than the table holds: it stays idle, the others are
+    // unaffected, and asking about a missing sink is harmless
+    void TestTooManySinks() {
+        SampleBus bus(64);
+        std::vector<std::unique_ptr<Received>> received;
+        std::vector<std::unique_ptr<SinkWorker>> workers;
+        for (size_t i = 0; i <= SampleBus::kMaxSinks; i++) {
+            received.emplace_back(new Received());
+            Received* r = received.back().get();
+            workers.emplace_back(new SinkWorker(bus, SinkPolicy::Block,
+                [r](const SensorSnapshot& s) { Record(*r, s); }));
+        }
+        for (size_t i = 0; i < SampleBus::kMaxSinks; i++) CHECK(workers[i]->IsAttached());
+        CHECK(!workers.back()->IsAttached());
+
+        SensorSnapshot snapshot;
+        for (uint64_t n = 0; n < 100; n++) {
+            Fill(snapshot, n);
+            bus.Publish(snapshot);
+        }
+        for (auto& worker : workers) worker->Stop();
+
+        for (size_t i = 0; i < SampleBus::kMaxSinks; i++) CHECK(received[i]->count == 100);
+        CHECK(received.back()->count == 0);
+
+        CHECK(!bus.Poll(-1, snapshot) && !bus.Poll((int)SampleBus::kMaxSinks, snapshot));
+        CHECK(!bus.Wait(-1, snapshot, 1000));
+        CHECK(bus.GetDropped(-1) == 0);
+    }
+
+    void TestClose() {
+        SampleBus bus;
+        int id = bus.AddSink(SinkPolicy::DropOldest);
+        std::thread closer([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            bus.Close();
+        });
+        SensorSnapshot snapshot;
+        double start = TestSeconds();
+        CHECK(!bus.Wait(id, snapshot, 5000));
+        CHECK(TestSeconds() - start < 1.0);
+        closer.join();
+    }
+}
+
+int main() {
+    TestPolicies();
+    TestBlock();
+    TestLateSinks();
+    TestTooManySinks();
+    TestClose();
+    return TestResult();
+}
@@ -0,0 +1,104 @@
+// Sensor registry ids, snapshot copies and the tooltip summary
+#include "Sensor.h"
+#include "TestCheck.h"
+#include <cstring>
+#include <thread>
+
+namespace {
+    void TestRegistry() {
+        SensorRegistry registry;
+        CHECK(registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU Zone 1") == 0);
+        CHECK(registry.Register(SensorKind::Gpu, SensorUnit::Celsius, "gpu", "GPU 0") == 1);
+        // Registering a known key again returns its id without adding a sensor
+        CHECK(registry.Register(SensorKind::Gpu, SensorUnit::Celsius, "cpu", "Other") == 0);
+        CHECK(registry.Count() == 2);
+        CHECK(std::string(registry.Get(0).label) == "CPU Zone 1");
+
+        CHECK(registry.MakeKey("cpu") == "cpu1");
+        CHECK(registry.MakeKey("fan") == "fan");
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, registry.MakeKey("cpu"), "CPU Zone 2");
+        CHECK(registry.MakeKey("cpu") == "cpu2");
+        CHECK(registry.Find("cpu1") == 2);
+        CHECK(registry.Find("nvme") == -1);
+        CHECK((registry.GetKeys() == std::vector<std::string>{ "cpu", "gpu", "cpu1" }));
+
+        // Keys and labels are truncated to fit, never overflowing
+        int id = registry.Register(SensorKind::Other, SensorUnit::Celsius,
+            "a_key_that_is_far_too_long", std::string(100, 'x'));
+        CHECK(strlen(registry.Get(id).key) == sizeof(SensorInfo::key) - 1);
+        CHECK(strlen(registry.Get(id).label) == sizeof(SensorInfo::label) - 1);
+
+        while (registry.Count() < kMaxSensors) {
+            CHECK(registry.Register(SensorKind::Other, SensorUnit::Celsius, registry.MakeKey("t"), "T") >= 0);
+        }
+        CHECK(registry.Register(SensorKind::Other, SensorUnit::Celsius, "one_more", "T") == -1);
+        CHECK(registry.Count() == kMaxSensors);
+    }
+
+    void TestSnapshot() {
+        SensorSnapshot snapshot;
+        memset(&snapshot, 0xCD, sizeof(snapshot));
+        snapshot.Clear(3);
+        CHECK(snapshot.count == 3 && !snapshot.partial);
+        for (size_t i = 0; i < kMaxSensors; i++) {
+            CHECK(!snapshot.valid[i] && !snapshot.stale[i]);
+        }
+
+        snapshot.Set(1, 61.5f, 1234);
+        snapshot.Set(kMaxSensors, 99.0f, 1);   // out of range is ignored
+        CHECK(snapshot.valid[1] && snapshot.values[1] == 61.5f && snapshot.timestamps[1] == 1234);
+        CHECK(!snapshot.valid[0] && !snapshot.valid[2]);
+
+        // Clear drops validity but keeps the buffers, so a reused snapshot
+        // never reports last tick's values
+        snapshot.stale[1] = 1;
+        snapshot.partial = true;
+        snapshot.Clear(3);
+        CHECK(!snapshot.valid[1] && !snapshot.stale[1] && !snapshot.partial);
+
+        // A snapshot handed to another thread is a byte copy
+        snapshot.Set(2, 70.0f, 99);
+        snapshot.time = 1700000000000LL;
+        SensorSnapshot copy;
+        std::thread reader([&]() { memcpy(&copy, &snapshot, sizeof(snapshot)); });
+        reader.join();
+        CHECK(memcmp(&copy, &snapshot, sizeof(snapshot)) == 0);
+        CHECK(copy.values[2] == 70.0f && copy.time == snapshot.time);
+    }
+
+    void TestSummary() {
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU Zone 1");
+        registry.Register(SensorKind::CpuCore, SensorUnit::Celsius, "core0", "Core 0");
+        registry.Register(SensorKind::Gpu, SensorUnit::Celsius, "gpu", "GPU 0");
+        registry.Register(SensorKind::Fan, SensorUnit::Percent, "fan", "GPU Fan");
+        registry.Register(SensorKind::Load, SensorUnit::Percent, "load", "CPU Load");
+
+        SensorSnapshot snapshot;
+        snapshot.Clear((uint32_t)registry.Count());
+        snapshot.Set(0, 55.0f, 0);
+        snapshot.Set(1, 61.0f, 0);
+        snapshot.Set(3, 40.0f, 0);
+        snapshot.Set(4, 100.0f, 0);   // load is a percentage, never the hottest
+
+        CHECK(HottestSensor(snapshot, registry) == 1);
+        CHECK(SummarizeSnapshot(snapshot, registry, L" | ") ==
+            L"CPU: 61.0\u00B0C | GPU: --\u00B0C | Fan: 40%");
+
+        snapshot.Set(2, 72.0f, 0);
+        snapshot.stale[2] = 1;
+        CHECK(HottestSensor(snapshot, registry) == 2);
+        CHECK(SummarizeSnapshot(snapshot, registry, L"\n") ==
+            L"CPU: 61.0\u00B0C\nGPU: ~72.0\u00B0C\nFan: 40%");
+
+        snapshot.Clear((uint32_t)registry.Count());
+        CHECK(HottestSensor(snapshot, registry) == -1);
+    }
+}
+
+int main() {
+    TestRegistry();
+    TestSnapshot();
+    TestSummary();
+    return TestResult();
+}
@@ -0,0 +1,148 @@
+// Threshold/hysteresis decisions and deterministic replay through the Simulator
+#include "AlertEvaluator.h"
+#include "ReplayProvider.h"
+#include "Simulator.h"
+#include "TestCheck.h"
+
+namespace {
+    const int kWarning = 80;
+    const int kDanger = 90;
+
+    SyntheticTrace SpikeTrace() {
+        SyntheticTrace trace = {};
+        trace.shape = SyntheticTrace::Shape::Spike;
+        trace.baseTemp = 50.0f;
+        trace.peakTemp = 92.0f;
+        trace.period = 600000;
+        trace.spikeWidth = 20000;
+        trace.interval = 1000;
+        trace.duration = 3600000;
+        trace.seed = 7;
+        return trace;
+    }
+
+    void TestHysteresis() {
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        registry.Register(SensorKind::Fan, SensorUnit::Percent, "fan", "Fan");
+
+        AlertEvaluator evaluator;
+        SensorSnapshot snapshot;
+        auto evaluate = [&](float temp) {
+            snapshot.Clear((uint32_t)registry.Count());
+            snapshot.Set(0, temp, 0);
+            snapshot.Set(1, 100.0f, 0);   // fans never count as the hottest sensor
+            return evaluator.Evaluate(snapshot, registry, kWarning, kDanger);
+        };
+
+        AlertDecision d = evaluate(70.0f);
+        CHECK(d.level == TempLevel::Normal && d.action == AlertAction::None && !d.updateWindow);
+        d = evaluate(80.0f);
+        CHECK(d.level == TempLevel::Warning && d.previousLevel == TempLevel::Normal);
+        CHECK(d.action == AlertAction::Show && d.updateWindow);
+        d = evaluate(95.0f);
+        CHECK(d.level == TempLevel::Danger && d.action == AlertAction::None);
+        CHECK(evaluator.GetLastMaxTemp() == 95.0f);
+
+        // Back below warning the window stays until warning - kHideHysteresis
+        d = evaluate(76.0f);
+        CHECK(d.level == TempLevel::Normal && d.action == AlertAction::None && d.updateWindow);
+        d = evaluate(kWarning - AlertEvaluator::kHideHysteresis);
+        CHECK(d.action == AlertAction::None && evaluator.IsWindowShown());
+        d = evaluate(74.9f);
+        CHECK(d.action == AlertAction::Hide && !evaluator.IsWindowShown());
+        CHECK(evaluator.GetLastMaxTemp() == 0.0f);
+
+        // No valid temperature keeps the previous level
+        snapshot.Clear((uint32_t)registry.Count());
+        d = evaluator.Evaluate(snapshot, registry, kWarning, kDanger);
+        CHECK(d.hottestSensor < 0 && d.level == TempLevel::Normal);
+    }
+
+    void TestSpikeEvents() {
+        ReplayProvider provider;
+        provider.SetSynthetic(SpikeTrace());
+        SimResult result = Simulator(kWarning, kDanger).Run(provider);
+
+        CHECK(result.ticks == 3600);
+        CHECK(result.invalidTicks == 0);
+        CHECK(result.simulatedTime == 3599000);
+
+        // Every spike shows the window at its first sample and hides it at
+        // the first sample after it, with Danger in between
+        int shows = 0, hides = 0;
+        for (const SimEvent& e : result.events) {
+            if (e.type == SimEventType::Show) {
+                CHECK(e.timestamp == shows * SpikeTrace().period);
+                CHECK(e.level == TempLevel::Danger);
+                shows++;
+            } else if (e.type == SimEventType::Hide) {
+                CHECK(e.timestamp == hides * SpikeTrace().period + SpikeTrace().spikeWidth);
+                hides++;
+            }
+        }
+        CHECK(shows == 6 && hides == 6);
+    }
+
+    void TestDeterminism() {
+        SyntheticTrace trace = SpikeTrace();
+        trace.noise = 3.0f;
+        trace.dropoutRate = 0.05f;
+
+        ReplayProvider a, b, c;
+        a.SetSynthetic(trace);
+        b.SetSynthetic(trace);
+        trace.seed = 8;
+        c.SetSynthetic(trace);
+        SimResult ra = Simulator(kWarning, kDanger).Run(a);
+        SimResult rb = Simulator(kWarning, kDanger).Run(b);
+        SimResult rc = Simulator(kWarning, kDanger).Run(c);
+
+        CHECK(ra.events.size() == rb.events.size());
+        for (size_t i = 0; i < ra.events.size() && i < rb.events.size(); i++) {
+            CHECK(ra.events[i].timestamp == rb.events[i].timestamp);
+            CHECK(ra.events[i].type == rb.events[i].type);
+            CHECK(ra.events[i].maxTemp == rb.events[i].maxTemp);
+        }
+        CHECK(ra.invalidTicks == rb.invalidTicks);
+        CHECK(ra.invalidTicks > 0);
+        CHECK(ra.invalidTicks != rc.invalidTicks || ra.events.size() != rc.events.size());
+    }
+
+    void TestDropouts() {
+        SyntheticTrace trace = SpikeTrace();
+        trace.dropoutRate = 1.0f;
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        SimResult result = Simulator(kWarning, kDanger).Run(provider);
+        CHECK(result.invalidTicks == result.ticks);
+        CHECK(result.events.empty());
+    }
+
+    // A day at 100 ms must replay well over a thousand times faster than real time
+    void TestThroughput() {
+        SyntheticTrace trace = SpikeTrace();
+        trace.interval = 100;
+        trace.duration = 24 * 3600000LL;
+        trace.noise = 1.0f;
+        trace.sensorCount = 8;
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        SimResult result = Simulator(kWarning, kDanger).Run(provider);
+
+        double speedup = result.simulatedTime / 1000.0 / result.wallSeconds;
+        printf("%llu ticks of 8 sensors in %.3f s: %.0f ticks/s, %.0fx real time\n",
+            (unsigned long long)result.ticks, result.wallSeconds, result.ticks / result.wallSeconds, speedup);
+        CHECK(result.ticks == 864000);
+        CHECK(speedup > 1000.0);
+    }
+}
+
+int main() {
+    TestHysteresis();
+    TestSpikeEvents();
+    TestDeterminism();
+    TestDropouts();
+    TestThroughput();
+    return TestResult();
+}
@@ -0,0 +1,193 @@
+// SoakRecorder::Analyze on replayed first-order step responses: the idle,
+// steady and peak temperatures and the time constants recovered from
+// traces whose true values are known, with and without noise and dropouts
+#include "ReplayProvider.h"
+#include "Soak.h"
+#include "TestCheck.h"
+#include <cmath>
+
+namespace {
+    const int64_t kInterval = 250;
+
+    SoakPhases Phases(int64_t idle, int64_t load, int64_t cooldown) {
+        SoakPhases phases;
+        phases.idle = idle;
+        phases.load = load;
+        phases.cooldown = cooldown;
+        return phases;
+    }
+
+    // The same trace `soak replay` generates, over the given phases
+    SyntheticTrace SoakTrace(const SoakPhases& phases, float base, float peak, int64_t tau) {
+        SyntheticTrace trace = {};
+        trace.shape = SyntheticTrace::Shape::Soak;
+        trace.baseTemp = base;
+        trace.peakTemp = peak;
+        trace.timeConstant = tau;
+        trace.interval = kInterval;
+        trace.period = phases.idle;
+        trace.spikeWidth = phases.load;
+        trace.duration = phases.idle + phases.load + phases.cooldown;
+        trace.seed = 1;
+        trace.sensorCount = 1;
+        return trace;
+    }
+
+    std::vector<SoakResult> Replay(const SyntheticTrace& trace, const SoakPhases& phases) {
+        ReplayProvider provider;
+        provider.SetSynthetic(trace);
+        SoakRecorder recorder(provider.GetRegistry());
+        SensorSnapshot snapshot;
+        while (provider.Next(snapshot)) {
+            recorder.Add(snapshot, provider.GetTime());
+        }
+        return recorder.Analyze(phases);
+    }
+
+    void TestCleanStep() {
+        SoakPhases phases = Phases(60000, 600000, 300000);
+        std::vector<SoakResult> results = Replay(SoakTrace(phases, 40.0f, 85.0f, 60000), phases);
+        CHECK(results.size() == 1);
+        if (results.empty()) return;
+
+        const SoakResult& r = results[0];
+        CHECK(r.samples == (phases.idle + phases.load + phases.cooldown) / kInterval);
+        CHECK_NEAR(r.idleTemp, 40.0, 0.01);
+        CHECK_NEAR(r.steadyTemp, 85.0, 0.05);
+        CHECK_NEAR(r.peakTemp, 85.0, 0.01);
+        CHECK_NEAR(r.heatTau, 60.0, 1.0);
+        CHECK_NEAR(r.plateauTime, 60.0 * -std::log(0.05), 1.5);
+        CHECK_NEAR(r.coolTau, 60.0, 1.0);
+
+        // A least-squares line through the first 30 s of 45 * (1 - e^(-t/60))
+        CHECK(r.slope > 0.55f && r.slope < 0.75f);
+    }
+
+    // Time constants from seconds to minutes come back within a sample or two
+    void TestTimeConstants() {
+        const int64_t taus[] = { 5000, 20000, 60000, 120000 };
+        for (int64_t tau : taus) {
+            SoakPhases phases = Phases(30000, tau * 8, tau * 6);
+            std::vector<SoakResult> results = Replay(SoakTrace(phases, 35.0f, 70.0f, tau), phases);
+            if (results.empty()) {
+                CHECK(false);
+                continue;
+            }
+            double expected = tau / 1000.0;
+            CHECK_NEAR(results[0].heatTau, expected, expected * 0.02 + 0.5);
+            CHECK_NEAR(results[0].coolTau, expected, expected * 0.02 + 0.5);
+            CHECK_NEAR(results[0].plateauTime, expected * -std::log(0.05), expected * 0.03 + 0.5);
+        }
+    }
+
+    // Noise and missing samples, as from a real sensor, on every sensor
+    void TestNoisyStep() {
+        SoakPhases phases = Phases(60000, 600000, 300000);
+        SyntheticTrace trace = SoakTrace(phases, 40.0f, 85.0f, 60000);
+        trace.noise = 0.5f;
+        trace.dropoutRate = 0.05f;
+        trace.sensorCount = 3;
+        trace.withLoad = true;
+
+        std::vector<SoakResult> results = Replay(trace, phases);
+        CHECK(results.size() == 3);   // the load sensor is not a temperature
+        for (const SoakResult& r : results) {
+            CHECK(r.samples < (phases.idle + phases.load + phases.cooldown) / kInterval);
+            CHECK_NEAR(r.idleTemp, 40.0, 0.2);
+            CHECK_NEAR(r.steadyTemp, 85.0, 0.2);
+            CHECK(r.peakTemp >= 85.0f && r.peakTemp <= 85.6f);
+            CHECK_NEAR(r.heatTau, 60.0, 3.0);
+            CHECK_NEAR(r.coolTau, 60.0, 3.0);
+        }
+    }
+
+    // A load that ends long before the sensor settles: the steady mean is
+    // still rising, and cooling starts from wherever the load left off
+    void TestShortLoad() {
+        SoakPhases phases = Phases(30000, 60000, 600000);
+        std::vector<SoakResult> results = Replay(SoakTrace(phases, 40.0f, 85.0f, 120000), phases);
+        if (results.empty()) {
+            CHECK(false);
+            return;
+        }
+        const SoakResult& r = results[0];
+        float hot = 40.0f + 45.0f * (float)(1.0 - std::exp(-0.5));
+        CHECK_NEAR(r.peakTemp, hot, 0.1);
+        CHECK(r.steadyTemp < r.peakTemp);
+        CHECK_NEAR(r.coolTau, 120.0, 3.0);
+    }
+
+    void TestUndeterminable() {
+        // No rise: the temperatures are reported, the time constants are not
+        SoakPhases phases = Phases(30000, 120000, 60000);
+        std::vector<SoakResult> flat = Replay(SoakTrace(phases, 50.0f, 50.5f, 10000), phases);
+        if (!flat.empty()) {
+            CHECK_NEAR(flat[0].idleTemp, 50.0, 0.01);
+            CHECK(!std::isnan(flat[0].steadyTemp) && !std::isnan(flat[0].slope));
+            CHECK(std::isnan(flat[0].heatTau) && std::isnan(flat[0].plateauTime) && std::isnan(flat[0].coolTau));
+        }
+
+        // No idle phase means no baseline to measure the rise from
+        SoakPhases noIdle = Phases(0, 120000, 60000);
+        std::vector<SoakResult> rising = Replay(SoakTrace(noIdle, 40.0f, 80.0f, 10000), noIdle);
+        if (!rising.empty()) {
+            CHECK(std::isnan(rising[0].idleTemp));
+            CHECK(!std::isnan(rising[0].peakTemp));
+            CHECK(std::isnan(rising[0].heatTau) && std::isnan(rising[0].coolTau));
+        }
+
+        // A sensor that never reported
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        SoakRecorder recorder(registry);
+        std::vector<SoakResult> empty = recorder.Analyze(phases);
+        CHECK(empty.size() == 1 && empty[0].samples == 0 && std::isnan(empty[0].idleTemp));
+    }
+
+    void TestStaleSkipped() {
+        SensorRegistry registry;
+        registry.Register(SensorKind::ThermalZone, SensorUnit::Celsius, "cpu", "CPU");
+        SoakRecorder recorder(registry);
+
+        SensorSnapshot snapshot;
+        for (int64_t t = 0; t < 10000; t += kInterval) {
+            snapshot.Clear(1);
+            snapshot.Set(0, 40.0f, t);
+            snapshot.stale[0] = (t / kInterval) % 2;
+            recorder.Add(snapshot, t);
+        }
+        std::vector<SoakResult> results = recorder.Analyze(Phases(5000, 5000, 0));
+        CHECK(results.size() == 1 && results[0].samples == 20);
+    }
+
+    void TestJson() {
+        SoakPhases phases = Phases(30000, 120000, 60000);
+        SoakReport report = {};
+        report.load = "replay";
+        report.threads = 0;
+        report.interval = (int)kInterval;
+        report.phases = phases;
+        report.sensors = Replay(SoakTrace(phases, 50.0f, 50.5f, 10000), phases);
+        report.sensors[0].label = "Quote \" and \\ and \t";
+
+        std::string json = FormatSoakJson(report);
+        CHECK(json.find("\"load\": \"replay\"") != std::string::npos);
+        CHECK(json.find("\"heatTau\": null") != std::string::npos);
+        CHECK(json.find("\"idle\": 50.00") != std::string::npos);
+        CHECK(json.find("Quote \\\" and \\\\ and \\u0009") != std::string::npos);
+
+        report.sensors.clear();
+        CHECK(FormatSoakJson(report).find("\"sensors\": []") != std::string::npos);
+    }
+}
+
+int main() {
+    TestCleanStep();
+    TestTimeConstants();
+    TestNoisyStep();
+    TestShortLoad();
+    TestUndeterminable();
+    TestStaleSkipped();
+    TestJson();
+    return TestResult();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+// Minimal checks for the test executables: a failed check prints where it
+// failed and the test exits non-zero from TestResult()
+inline int& TestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            TestFailures()++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double checkActual = (double)(actual); \
+        double checkExpected = (double)(expected); \
+        if (!(std::fabs(checkActual - checkExpected) <= (double)(tolerance))) { \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %g vs %g\n", __FILE__, __LINE__, \
+                #actual, #expected, checkActual, checkExpected); \
+            TestFailures()++; \
+        } \
+    } while (0)
+
+inline int TestResult() {
+    if (TestFailures() == 0) {
+        printf("all checks passed\n");
+        return 0;
+    }
+    fprintf(stderr, "%d check(s) failed\n", TestFailures());
+    return 1;
+}
+
+// Seconds since an arbitrary start, for benchmarks
+inline double TestSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A fresh directory under the system temp directory, removed again with the object
+class TestDirectory {
+public:
+    explicit TestDirectory(const std::string& name) {
+        static std::atomic<int> counter(0);
+        path = std::filesystem::temp_directory_path() /
+            (name + "_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+             "_" + std::to_string(counter++));
+        std::filesystem::create_directories(path);
+    }
+
+    ~TestDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+
+    std::wstring Wide() const { return path.wstring(); }
+
+    std::filesystem::path path;
+};
@@ -0,0 +1,139 @@
+// The sysfs watcher against a fake tree: at a steady temperature it stays
+// in poll() and the UI is woken once, for the first reading; with a short
+// fallback every check reads the zones and only level edges wake the UI
+#include "ThermalEvents.h"
+#include "TestCheck.h"
+#include <fstream>
+#include <thread>
+
+namespace {
+    const int kFallbackMs = 50;
+
+    void WriteFile(const std::filesystem::path& path, const std::string& text) {
+        std::ofstream out(path, std::ios::trunc);
+        out << text << "\n";
+    }
+
+    // hwmon0 is a CPU package sensor with an alarm file; hwmon1 is a disk
+    // that runs hot but is not the CPU. thermal_zone0 is the CPU package,
+    // thermal_zone1 a wifi card.
+    void MakeTree(const std::filesystem::path& root) {
+        std::filesystem::path hwmon = root / "hwmon";
+        std::filesystem::create_directories(hwmon / "hwmon0");
+        WriteFile(hwmon / "hwmon0" / "name", "coretemp");
+        WriteFile(hwmon / "hwmon0" / "temp1_input", "45000");
+        WriteFile(hwmon / "hwmon0" / "temp2_input", "43000");
+        WriteFile(hwmon / "hwmon0" / "temp1_crit_alarm", "0");
+        WriteFile(hwmon / "hwmon0" / "temp1_label", "Package id 0");
+
+        std::filesystem::create_directories(hwmon / "hwmon1");
+        WriteFile(hwmon / "hwmon1" / "name", "nvme");
+        WriteFile(hwmon / "hwmon1" / "temp1_input", "95000");
+
+        std::filesystem::path thermal = root / "thermal";
+        std::filesystem::create_directories(thermal / "thermal_zone0");
+        WriteFile(thermal / "thermal_zone0" / "type", "x86_pkg_temp");
+        WriteFile(thermal / "thermal_zone0" / "temp", "46000");
+        WriteFile(thermal / "thermal_zone0" / "trip_point_0_temp", "100000");
+
+        std::filesystem::create_directories(thermal / "thermal_zone1");
+        WriteFile(thermal / "thermal_zone1" / "type", "iwlwifi_1");
+        WriteFile(thermal / "thermal_zone1" / "temp", "97000");
+    }
+
+    void WaitFor(const std::atomic<int>& counter, int value) {
+        double start = TestSeconds();
+        while (counter < value && TestSeconds() - start < 2.0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    // With the real fallback nothing fires on the fake tree, so after the
+    // first read of its three zones the watcher never comes out of poll()
+    void TestSteadyState() {
+        TestDirectory dir("thermal_events");
+        MakeTree(dir.path);
+
+        std::atomic<int> woken(0);
+        ThermalEvents events((dir.path / "hwmon").string(), (dir.path / "thermal").string());
+        events.SetThresholds(70, 85);
+        CHECK(events.Start([&] { woken++; }));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        CHECK(events.GetEventCount() == 3);
+        CHECK(events.GetLoopCount() == 0);
+        CHECK(woken == 1);
+        CHECK(events.GetWakeCount() == 1);
+
+        double start = TestSeconds();
+        events.Stop();
+        CHECK(TestSeconds() - start < 0.5);
+    }
+
+    void TestFallback() {
+        TestDirectory dir("thermal_events_fallback");
+        MakeTree(dir.path);
+
+        std::atomic<int> woken(0);
+        ThermalEvents events((dir.path / "hwmon").string(), (dir.path / "thermal").string(), kFallbackMs);
+        events.SetThresholds(70, 85);
+        CHECK(events.Start([&] { woken++; }));
+
+        // Twenty checks at a steady, normal temperature
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFallbackMs * 20));
+        unsigned long long loops = events.GetLoopCount();
+        CHECK(loops >= 10 && loops <= 20);
+        CHECK(events.GetEventCount() == (loops + 1) * 3);
+        CHECK(woken == 1);
+
+        // A level edge wakes once, then the new level is steady again
+        WriteFile(dir.path / "hwmon" / "hwmon0" / "temp2_input", "88000");
+        WaitFor(woken, 2);
+        CHECK(woken == 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFallbackMs * 10));
+        CHECK(woken == 2);
+
+        WriteFile(dir.path / "hwmon" / "hwmon0" / "temp2_input", "44000");
+        WaitFor(woken, 3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kFallbackMs * 10));
+        CHECK(woken == 3);
+
+        // The thermal zone counts like any other
+        WriteFile(dir.path / "thermal" / "thermal_zone0" / "temp", "75000");
+        WaitFor(woken, 4);
+        CHECK(woken == 4);
+
+        double start = TestSeconds();
+        events.Stop();
+        CHECK(TestSeconds() - start < 0.5);
+    }
+
+    void TestNoCpuSensors() {
+        TestDirectory dir("thermal_events_none");
+        std::filesystem::create_directories(dir.path / "hwmon" / "hwmon0");
+        WriteFile(dir.path / "hwmon" / "hwmon0" / "name", "nvme");
+        WriteFile(dir.path / "hwmon" / "hwmon0" / "temp1_input", "40000");
+        std::filesystem::create_directories(dir.path / "thermal" / "thermal_zone0");
+        WriteFile(dir.path / "thermal" / "thermal_zone0" / "type", "iwlwifi_1");
+        WriteFile(dir.path / "thermal" / "thermal_zone0" / "temp", "40000");
+
+        ThermalEvents events((dir.path / "hwmon").string(), (dir.path / "thermal").string(), kFallbackMs);
+        CHECK(!events.Start([] {}));
+
+        ThermalEvents missing((dir.path / "missing").string(), (dir.path / "missing").string(), kFallbackMs);
+        CHECK(!missing.Start([] {}));
+
+        // A CPU thermal zone alone is enough
+        WriteFile(dir.path / "thermal" / "thermal_zone0" / "type", "x86_pkg_temp");
+        ThermalEvents zoneOnly((dir.path / "hwmon").string(), (dir.path / "thermal").string(), kFallbackMs);
+        CHECK(zoneOnly.Start([] {}));
+        zoneOnly.Stop();
+    }
+}
+
+int main() {
+    TestSteadyState();
+    TestFallback();
+    TestNoCpuSensors();
+    return TestResult();
+}
@@ -0,0 +1,232 @@
+// The trace-event JSON: it parses, every event has the fields viewers need,
+// and each thread's begin/end events nest, including after the rings wrap
+// while a thread keeps recording during the write
+#include "Trace.h"
+#include "TestCheck.h"
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Just enough JSON to check the file: objects, arrays, strings without
+    // escapes, and integers
+    struct Json {
+        char type = 0;   // '{', '[', '"' or '0'
+        std::string text;
+        std::vector<std::pair<std::string, Json>> members;
+        std::vector<Json> items;
+
+        const Json* Find(const std::string& key) const {
+            for (const auto& member : members) {
+                if (member.first == key) return &member.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class Parser {
+    public:
+        explicit Parser(const std::string& input) : text(input), pos(0) {}
+
+        bool Document(Json& value) {
+            if (!Value(value)) return false;
+            Skip();
+            return pos == text.size();
+        }
+
+    private:
+        const std::string& text;
+        size_t pos;
+
+        void Skip() {
+            while (pos < text.size() && isspace((unsigned char)text[pos])) pos++;
+        }
+
+        bool Take(char c) {
+            Skip();
+            if (pos < text.size() && text[pos] == c) {
+                pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool String(std::string& out) {
+            if (!Take('"')) return false;
+            size_t end = text.find('"', pos);
+            if (end == std::string::npos) return false;
+            out = text.substr(pos, end - pos);
+            pos = end + 1;
+            return out.find('\\') == std::string::npos;
+        }
+
+        bool Value(Json& value) {
+            Skip();
+            if (pos >= text.size()) return false;
+            char c = text[pos];
+            if (c == '{') {
+                value.type = '{';
+                pos++;
+                if (Take('}')) return true;
+                do {
+                    std::string key;
+                    Json member;
+                    if (!String(key) || !Take(':') || !Value(member)) return false;
+                    value.members.emplace_back(key, member);
+                } while (Take(','));
+                return Take('}');
+            }
+            if (c == '[') {
+                value.type = '[';
+                pos++;
+                if (Take(']')) return true;
+                do {
+                    value.items.emplace_back();
+                    if (!Value(value.items.back())) return false;
+                } while (Take(','));
+                return Take(']');
+            }
+            if (c == '"') {
+                value.type = '"';
+                return String(value.text);
+            }
+            size_t start = pos;
+            if (text[pos] == '-') pos++;
+            while (pos < text.size() && isdigit((unsigned char)text[pos])) pos++;
+            value.type = '0';
+            value.text = text.substr(start, pos - start);
+            return pos > start && value.text != "-";
+        }
+    };
+
+    const char* const kStages[] = { "tick", "sample", "read cpu", "publish" };
+
+    bool KnownStage(const std::string& name) {
+        for (const char* stage : kStages) {
+            if (name == stage) return true;
+        }
+        return false;
+    }
+
+    // One tick's worth of nested scopes
+    void RecordTick() {
+        TRACE_SCOPE("tick");
+        {
+            TRACE_SCOPE("sample");
+            TRACE_SCOPE("read cpu");
+        }
+        TRACE_SCOPE("publish");
+    }
+
+    // Parses the file and checks every event; returns the events per thread
+    std::map<long long, size_t> CheckFile(const std::filesystem::path& path) {
+        std::map<long long, size_t> counts;
+        std::ifstream in(path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+
+        Json root;
+        bool parsed = Parser(buffer.str()).Document(root);
+        CHECK(parsed);
+        if (!parsed) return counts;
+
+        const Json* unit = root.Find("displayTimeUnit");
+        CHECK(unit && unit->type == '"' && unit->text == "ms");
+        const Json* events = root.Find("traceEvents");
+        CHECK(events && events->type == '[');
+        if (!events) return counts;
+
+        std::map<long long, std::vector<std::string>> stacks;
+        std::map<long long, long long> lastTime;
+        for (const Json& event : events->items) {
+            const Json* name = event.Find("name");
+            const Json* ph = event.Find("ph");
+            const Json* ts = event.Find("ts");
+            const Json* pid = event.Find("pid");
+            const Json* tid = event.Find("tid");
+            bool complete = event.type == '{' && name && name->type == '"' && ph && ph->type == '"' &&
+                ts && ts->type == '0' && pid && pid->type == '0' && tid && tid->type == '0';
+            CHECK(complete);
+            if (!complete) continue;
+
+            CHECK(KnownStage(name->text));
+            CHECK(ph->text == "B" || ph->text == "E");
+
+            long long thread = std::stoll(tid->text);
+            long long time = std::stoll(ts->text);
+            // A half-written slot would show up as time going backwards
+            if (lastTime.count(thread)) CHECK(time >= lastTime[thread]);
+            lastTime[thread] = time;
+            counts[thread]++;
+
+            // Ends always close the innermost open begin of their thread
+            auto& stack = stacks[thread];
+            if (ph->text == "B") {
+                stack.push_back(name->text);
+            } else {
+                CHECK(!stack.empty() && stack.back() == name->text);
+                if (!stack.empty()) stack.pop_back();
+            }
+        }
+        return counts;
+    }
+
+    void TestNesting(const TestDirectory& dir) {
+        Trace::SetEnabled(true);
+        for (int i = 0; i < 10; i++) RecordTick();
+        std::thread other([] { for (int i = 0; i < 5; i++) RecordTick(); });
+        other.join();
+
+        std::filesystem::path path = dir.path / "nesting.json";
+        CHECK(Trace::WriteJson(path.wstring()));
+        auto counts = CheckFile(path);
+        CHECK(counts.size() == 2);
+        size_t total = 0;
+        for (const auto& count : counts) total += count.second;
+        CHECK(total == 15 * 8);
+    }
+
+    // One thread wraps its ring many times over while the file is written
+    void TestWrapWhileWriting(const TestDirectory& dir) {
+        std::atomic<bool> stop(false);
+        std::thread writer([&] {
+            while (!stop) RecordTick();
+        });
+
+        for (int i = 0; i < 5; i++) {
+            std::filesystem::path path = dir.path / ("wrap" + std::to_string(i) + ".json");
+            CHECK(Trace::WriteJson(path.wstring()));
+            auto counts = CheckFile(path);
+            for (const auto& count : counts) CHECK(count.second <= Trace::kEventsPerThread);
+        }
+        stop = true;
+        writer.join();
+    }
+
+    void TestDisabled(const TestDirectory& dir) {
+        std::filesystem::path before = dir.path / "before.json";
+        CHECK(Trace::WriteJson(before.wstring()));
+        size_t recorded = 0;
+        for (const auto& count : CheckFile(before)) recorded += count.second;
+
+        Trace::SetEnabled(false);
+        for (int i = 0; i < 100; i++) RecordTick();
+        std::filesystem::path after = dir.path / "after.json";
+        CHECK(Trace::WriteJson(after.wstring()));
+        size_t total = 0;
+        for (const auto& count : CheckFile(after)) total += count.second;
+        CHECK(total == recorded);
+
+        CHECK(!Trace::WriteJson((dir.path / "missing" / "trace.json").wstring()));
+    }
+}
+
+int main() {
+    TestDirectory dir("trace");
+    TestNesting(dir);
+    TestWrapWhileWriting(dir);
+    TestDisabled(dir);
+    return TestResult();
+}
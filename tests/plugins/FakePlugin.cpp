@@ -0,0 +1,41 @@
+// Plugins that misbehave on purpose, for PluginHostTest. Built twice:
+// with FAKE_FAIL_OPEN it refuses to open, without it every read hangs.
+#include "TempMonitorPlugin.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+extern "C" TM_PLUGIN_EXPORT int tm_plugin_open(uint32_t host_abi_version, tm_plugin_info* info, void** context) {
+    memset(info, 0, sizeof(*info));
+    info->abi_version = host_abi_version;
+#ifdef FAKE_FAIL_OPEN
+    (void)context;
+    return -1;
+#else
+    info->read_deadline_ms = 50;
+    info->sensor_count = 1;
+    info->sensors[0].kind = TM_KIND_OTHER;
+    info->sensors[0].unit = TM_UNIT_CELSIUS;
+    strcpy(info->sensors[0].key, "hang");
+    strcpy(info->sensors[0].label, "Hanging Probe");
+    *context = info;   // anything non-null
+    return 0;
+#endif
+}
+
+extern "C" TM_PLUGIN_EXPORT int tm_plugin_read(void*, float* values, uint8_t* valid, uint32_t count) {
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    if (count > 0) {
+        values[0] = 1.0f;
+        valid[0] = 1;
+    }
+    return 0;
+}
+
+extern "C" TM_PLUGIN_EXPORT void tm_plugin_close(void*) {
+#ifdef FAKE_FAIL_OPEN
+    // The host must not close a plugin whose open failed
+    abort();
+#endif
+}